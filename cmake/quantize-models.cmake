@@ -0,0 +1,27 @@
+# Quantize every unquantized model in MODEL_DIR to each of TYPES, writing
+# ggml-<name>-<type>.bin next to it. Outputs newer than their source are
+# left alone, so re-running after adding a model only does the new work.
+#   cmake -DQUANTIZE=<tool> -DMODEL_DIR=<dir> -DTYPES=q5_1,q8_0 -P quantize-models.cmake
+string(REPLACE "," ";" TYPES "${TYPES}")
+file(GLOB models "${MODEL_DIR}/ggml-*.bin")
+foreach(model ${models})
+    get_filename_component(name "${model}" NAME_WLE)
+    if(name MATCHES "-q[0-9]_[0-9k]$")
+        continue()
+    endif()
+    foreach(type ${TYPES})
+        set(out "${MODEL_DIR}/${name}-${type}.bin")
+        if(EXISTS "${out}" AND "${out}" IS_NEWER_THAN "${model}")
+            continue()
+        endif()
+        message(STATUS "Quantizing ${name} to ${type}")
+        execute_process(
+            COMMAND "${QUANTIZE}" "${model}" "${out}" ${type}
+            RESULT_VARIABLE rc
+            OUTPUT_QUIET ERROR_QUIET)
+        if(NOT rc EQUAL 0)
+            file(REMOVE "${out}")
+            message(WARNING "Quantizing ${name} to ${type} failed (${rc})")
+        endif()
+    endforeach()
+endforeach()
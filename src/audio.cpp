@@ -2,41 +2,146 @@
 #include "miniaudio.h"
 
 #include "audio.h"
+#include "echo.h"
+#include "metrics.h"
 
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <memory>
+#include <vector>
 
 static constexpr uint32_t SAMPLE_RATE    = 16000;
-static constexpr uint32_t RING_BUF_SECS  = 60;
-static constexpr uint32_t RING_BUF_FRAMES = SAMPLE_RATE * RING_BUF_SECS;
+static constexpr uint32_t RING_BUF_SECS  = 60;                  // until set_ring_seconds()
+static constexpr uint32_t REF_RING_FRAMES = SAMPLE_RATE;        // 1s of far-end reference
+static constexpr uint32_t REF_MAX_LAG     = SAMPLE_RATE / 5;    // drop reference beyond 200ms ahead
 
 struct AudioCapture::Impl {
     ma_device   device{};
     ma_pcm_rb   ring_buf{};
+    uint32_t    ring_frames   = SAMPLE_RATE * RING_BUF_SECS;
     bool        device_inited = false;
     bool        rb_inited     = false;
+
+    // Echo cancellation: playback monitor captured into its own ring
+    ma_context  context{};
+    ma_device   ref_device{};
+    ma_pcm_rb   ref_ring{};
+    bool        context_inited    = false;
+    bool        ref_device_inited = false;
+    bool        ref_rb_inited     = false;
+
+    std::unique_ptr<EchoCanceller> echo;
+    std::vector<float>             ref_buf;
+
+    bool init_reference();
 };
 
+// Resolved once in AudioCapture::init(); the callback must not look them up
+static metrics::Counter* g_dropped_frames     = nullptr;
+static metrics::Counter* g_ref_dropped_frames = nullptr;   // echo reference ring
+static metrics::Gauge*   g_ring_fill          = nullptr;
+
+static void write_ring(ma_pcm_rb* rb, const float* src, ma_uint32 frame_count,
+                       metrics::Counter* dropped)
+{
+    // The writable region may wrap, so write in up to two pieces
+    ma_uint32 written = 0;
+    while (written < frame_count) {
+        void* buf_write;
+        ma_uint32 frames_to_write = frame_count - written;
+        if (ma_pcm_rb_acquire_write(rb, &frames_to_write, &buf_write) != MA_SUCCESS
+            || frames_to_write == 0)
+            break;
+        std::memcpy(buf_write, src + written, frames_to_write * sizeof(float));
+        ma_pcm_rb_commit_write(rb, frames_to_write);
+        written += frames_to_write;
+    }
+    if (written < frame_count && dropped)
+        dropped->add(frame_count - written);
+}
+
 static void capture_callback(ma_device* device, void* /*output*/,
                               const void* input, ma_uint32 frame_count)
 {
-    auto* rb = static_cast<ma_pcm_rb*>(device->pUserData);
+    write_ring(static_cast<ma_pcm_rb*>(device->pUserData),
+               static_cast<const float*>(input), frame_count, g_dropped_frames);
+}
 
-    void* buf_write;
-    ma_uint32 frames_to_write = frame_count;
-    if (ma_pcm_rb_acquire_write(rb, &frames_to_write, &buf_write) == MA_SUCCESS) {
-        std::memcpy(buf_write, input, frames_to_write * sizeof(float));
-        ma_pcm_rb_commit_write(rb, frames_to_write);
+// The reference ring overflows whenever the sink plays and nobody reads
+// (paused, not recording); that is not lost speech
+static void reference_callback(ma_device* device, void* /*output*/,
+                               const void* input, ma_uint32 frame_count)
+{
+    write_ring(static_cast<ma_pcm_rb*>(device->pUserData),
+               static_cast<const float*>(input), frame_count, g_ref_dropped_frames);
+}
+
+// ---------------------------------------------------------------------------
+// Far-end reference: the monitor source of the default sink (PulseAudio and
+// PipeWire name these "Monitor of ..."). miniaudio's loopback device type is
+// WASAPI-only, so on Linux the monitor is opened as a regular capture device.
+// LIVE_WHISPER_AEC_SOURCE overrides the name to match.
+// ---------------------------------------------------------------------------
+bool AudioCapture::Impl::init_reference()
+{
+    if (ma_context_init(nullptr, 0, nullptr, &context) != MA_SUCCESS) {
+        std::fprintf(stderr, "audio: failed to init context\n");
+        return false;
     }
+    context_inited = true;
+
+    const char* want = std::getenv("LIVE_WHISPER_AEC_SOURCE");
+    if (!want) want = "Monitor";
+
+    ma_device_info* infos = nullptr;
+    ma_uint32 count = 0;
+    if (ma_context_get_devices(&context, nullptr, nullptr, &infos, &count) != MA_SUCCESS)
+        return false;
+
+    const ma_device_info* monitor = nullptr;
+    for (ma_uint32 i = 0; i < count && !monitor; ++i)
+        if (std::strstr(infos[i].name, want))
+            monitor = &infos[i];
+    if (!monitor) {
+        std::fprintf(stderr, "audio: no capture device matching \"%s\" for echo reference\n", want);
+        return false;
+    }
+
+    if (ma_pcm_rb_init(ma_format_f32, 1, REF_RING_FRAMES, nullptr,
+                       nullptr, &ref_ring) != MA_SUCCESS)
+        return false;
+    ref_rb_inited = true;
+
+    ma_device_config config = ma_device_config_init(ma_device_type_capture);
+    config.capture.pDeviceID = &monitor->id;
+    config.capture.format    = ma_format_f32;
+    config.capture.channels  = 1;
+    config.sampleRate        = SAMPLE_RATE;
+    config.dataCallback      = reference_callback;
+    config.pUserData         = &ref_ring;
+
+    if (ma_device_init(&context, &config, &ref_device) != MA_SUCCESS) {
+        std::fprintf(stderr, "audio: failed to open echo reference %s\n", monitor->name);
+        return false;
+    }
+    ref_device_inited = true;
+
+    echo = std::make_unique<EchoCanceller>();
+    return true;
 }
 
 AudioCapture::AudioCapture() : impl_(std::make_unique<Impl>()) {}
 AudioCapture::~AudioCapture() { shutdown(); }
 
-bool AudioCapture::init()
+bool AudioCapture::init(bool echo_cancel)
 {
+    g_dropped_frames     = metrics::counter("audio_dropped_frames");
+    g_ref_dropped_frames = metrics::counter("echo_ref_dropped_frames");
+    g_ring_fill          = metrics::gauge("ring_fill");
+
     // Init ring buffer
-    if (ma_pcm_rb_init(ma_format_f32, 1, RING_BUF_FRAMES, nullptr,
+    if (ma_pcm_rb_init(ma_format_f32, 1, impl_->ring_frames, nullptr,
                        nullptr, &impl_->ring_buf) != MA_SUCCESS) {
         std::fprintf(stderr, "audio: failed to init ring buffer\n");
         return false;
@@ -51,7 +156,12 @@ bool AudioCapture::init()
     config.dataCallback     = capture_callback;
     config.pUserData        = &impl_->ring_buf;
 
-    if (ma_device_init(nullptr, &config, &impl_->device) != MA_SUCCESS) {
+    // Echo cancellation is best effort: without a reference, capture as usual
+    if (echo_cancel && !impl_->init_reference())
+        std::fprintf(stderr, "audio: echo cancellation disabled\n");
+
+    ma_context* ctx = impl_->context_inited ? &impl_->context : nullptr;
+    if (ma_device_init(ctx, &config, &impl_->device) != MA_SUCCESS) {
         std::fprintf(stderr, "audio: failed to init capture device\n");
         return false;
     }
@@ -61,24 +171,64 @@ bool AudioCapture::init()
         std::fprintf(stderr, "audio: failed to start capture device\n");
         return false;
     }
+    if (impl_->echo && ma_device_start(&impl_->ref_device) != MA_SUCCESS) {
+        std::fprintf(stderr, "audio: failed to start echo reference, echo cancellation disabled\n");
+        impl_->echo.reset();
+    }
 
     return true;
 }
 
+bool AudioCapture::init_injected()
+{
+    g_dropped_frames = metrics::counter("audio_dropped_frames");
+    g_ring_fill      = metrics::gauge("ring_fill");
+
+    if (ma_pcm_rb_init(ma_format_f32, 1, impl_->ring_frames, nullptr,
+                       nullptr, &impl_->ring_buf) != MA_SUCCESS) {
+        std::fprintf(stderr, "audio: failed to init ring buffer\n");
+        return false;
+    }
+    impl_->rb_inited = true;
+    return true;
+}
+
+void AudioCapture::inject(const float* frames, uint32_t n)
+{
+    if (impl_->rb_inited) write_ring(&impl_->ring_buf, frames, n, g_dropped_frames);
+}
+
 void AudioCapture::shutdown()
 {
     if (impl_->device_inited) {
         ma_device_uninit(&impl_->device);
         impl_->device_inited = false;
     }
+    if (impl_->ref_device_inited) {
+        ma_device_uninit(&impl_->ref_device);
+        impl_->ref_device_inited = false;
+    }
     if (impl_->rb_inited) {
         ma_pcm_rb_uninit(&impl_->ring_buf);
         impl_->rb_inited = false;
     }
+    if (impl_->ref_rb_inited) {
+        ma_pcm_rb_uninit(&impl_->ref_ring);
+        impl_->ref_rb_inited = false;
+    }
+    if (impl_->context_inited) {
+        ma_context_uninit(&impl_->context);
+        impl_->context_inited = false;
+    }
+    impl_->echo.reset();
 }
 
 uint32_t AudioCapture::read(float* buf, uint32_t max_frames)
 {
+    if (g_ring_fill)
+        g_ring_fill->set(static_cast<double>(ma_pcm_rb_available_read(&impl_->ring_buf))
+                         / impl_->ring_frames);
+
     void* buf_read;
     ma_uint32 frames = max_frames;
     if (ma_pcm_rb_acquire_read(&impl_->ring_buf, &frames, &buf_read) != MA_SUCCESS)
@@ -86,9 +236,83 @@ uint32_t AudioCapture::read(float* buf, uint32_t max_frames)
 
     std::memcpy(buf, buf_read, frames * sizeof(float));
     ma_pcm_rb_commit_read(&impl_->ring_buf, frames);
+
+    if (impl_->echo && frames > 0) {
+        // Keep the reference within the canceller's reach: if the monitor
+        // ran ahead of the mic, drop the surplus.
+        ma_uint32 ref_avail = ma_pcm_rb_available_read(&impl_->ref_ring);
+        if (ref_avail > frames + REF_MAX_LAG)
+            ma_pcm_rb_seek_read(&impl_->ref_ring, ref_avail - frames - REF_MAX_LAG);
+
+        impl_->ref_buf.assign(frames, 0.0f);   // silence if the monitor is behind
+        ma_uint32 filled = 0;
+        while (filled < frames) {
+            void* ref_read;
+            ma_uint32 n = frames - filled;
+            if (ma_pcm_rb_acquire_read(&impl_->ref_ring, &n, &ref_read) != MA_SUCCESS || n == 0)
+                break;
+            std::memcpy(impl_->ref_buf.data() + filled, ref_read, n * sizeof(float));
+            ma_pcm_rb_commit_read(&impl_->ref_ring, n);
+            filled += n;
+        }
+        impl_->echo->process(buf, impl_->ref_buf.data(), buf, frames);
+    }
     return frames;
 }
 
+// ---------------------------------------------------------------------------
+// Ring resize: the callback writes without locking, so capture stops while
+// the buffer is swapped. Unread audio is carried over, newest first if it
+// no longer fits.
+// ---------------------------------------------------------------------------
+void AudioCapture::set_ring_seconds(uint32_t secs)
+{
+    uint32_t frames = SAMPLE_RATE * secs;
+    if (!impl_->rb_inited || frames == impl_->ring_frames) return;
+
+    bool running = impl_->device_inited && ma_device_is_started(&impl_->device);
+    if (running) ma_device_stop(&impl_->device);
+
+    // Raw samples: echo cancellation runs when they are read from the new ring
+    std::vector<float> kept;
+    for (;;) {
+        void* buf_read;
+        ma_uint32 n = ma_pcm_rb_available_read(&impl_->ring_buf);
+        if (n == 0 || ma_pcm_rb_acquire_read(&impl_->ring_buf, &n, &buf_read) != MA_SUCCESS
+            || n == 0)
+            break;
+        const float* src = static_cast<const float*>(buf_read);
+        kept.insert(kept.end(), src, src + n);
+        ma_pcm_rb_commit_read(&impl_->ring_buf, n);
+    }
+    if (kept.size() > frames)
+        kept.erase(kept.begin(), kept.end() - frames);
+
+    ma_pcm_rb_uninit(&impl_->ring_buf);
+    if (ma_pcm_rb_init(ma_format_f32, 1, frames, nullptr, nullptr,
+                       &impl_->ring_buf) == MA_SUCCESS) {
+        impl_->ring_frames = frames;
+    } else {
+        std::fprintf(stderr, "audio: failed to resize ring buffer to %us\n", secs);
+        if (ma_pcm_rb_init(ma_format_f32, 1, impl_->ring_frames, nullptr, nullptr,
+                           &impl_->ring_buf) != MA_SUCCESS) {
+            std::fprintf(stderr, "audio: failed to restore ring buffer\n");
+            impl_->rb_inited = false;
+            return;
+        }
+    }
+
+    void* buf_write;
+    ma_uint32 n = static_cast<ma_uint32>(kept.size());
+    if (n > 0 && ma_pcm_rb_acquire_write(&impl_->ring_buf, &n, &buf_write) == MA_SUCCESS) {
+        std::memcpy(buf_write, kept.data(), n * sizeof(float));
+        ma_pcm_rb_commit_write(&impl_->ring_buf, n);
+    }
+
+    if (running && ma_device_start(&impl_->device) != MA_SUCCESS)
+        std::fprintf(stderr, "audio: failed to restart capture device\n");
+}
+
 uint32_t AudioCapture::available() const
 {
     return ma_pcm_rb_available_read(&impl_->ring_buf);
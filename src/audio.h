@@ -10,12 +10,27 @@ struct AudioCapture {
     AudioCapture(const AudioCapture&) = delete;
     AudioCapture& operator=(const AudioCapture&) = delete;
 
-    bool init();
+    // With echo_cancel, also capture the playback monitor as a far-end
+    // reference and run acoustic echo cancellation on every read.
+    bool init(bool echo_cancel = false);
     void shutdown();
 
+    // Ring only, no device: audio arrives through inject() instead, so a
+    // bench can drive the capture path with a recording.
+    bool init_injected();
+
+    // Write frames into the ring as the capture callback does, from one
+    // thread at a time; what does not fit is dropped and counted.
+    void inject(const float* frames, uint32_t n);
+
     // Read available samples into buf. Returns number of frames actually read.
+    // Samples are echo-cancelled when enabled in init().
     uint32_t read(float* buf, uint32_t max_frames);
 
+    // Resize the capture ring buffer, keeping unread audio. Capture pauses
+    // briefly while the buffer is swapped; no-op if the size is unchanged.
+    void set_ring_seconds(uint32_t secs);
+
     // Number of frames available for reading.
     uint32_t available() const;
 
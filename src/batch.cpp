@@ -0,0 +1,693 @@
+#include "batch.h"
+#include "numa.h"
+#include "results.h"
+#include "wav.h"
+#include "whisper.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+static constexpr int    SAMPLE_RATE       = 16000;
+static constexpr size_t FRAME             = SAMPLE_RATE * 30 / 1000;  // 30ms energy frames
+static constexpr size_t QUIET_FRAMES      = 10;                       // 300ms quietest window
+static constexpr size_t MIN_SHARD         = SAMPLE_RATE * 10;
+static constexpr size_t MAX_SHARD         = SAMPLE_RATE * 28;         // one whisper window
+static constexpr int    MAX_ATTEMPTS      = 3;
+static constexpr int    MAX_RESPAWNS      = 8;
+static constexpr double TIMEOUT_MIN_S     = 60.0;
+static constexpr double TIMEOUT_PER_AUDIO = 10.0;   // x shard duration
+static constexpr int    POLL_MS           = 500;
+static constexpr int    HELLO_TIMEOUT_MS  = 5000;   // connect to HELLO
+
+using Clock = std::chrono::steady_clock;
+
+// ---------------------------------------------------------------------------
+// Socket I/O helpers
+// ---------------------------------------------------------------------------
+static bool write_all(int fd, const void* data, size_t n)
+{
+    const auto* p = static_cast<const char*>(data);
+    while (n > 0) {
+        ssize_t w = send(fd, p, n, MSG_NOSIGNAL);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        p += w;
+        n -= static_cast<size_t>(w);
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* data, size_t n)
+{
+    auto* p = static_cast<char*>(data);
+    while (n > 0) {
+        ssize_t r = read(fd, p, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        p += r;
+        n -= static_cast<size_t>(r);
+    }
+    return true;
+}
+
+static bool read_line(int fd, std::string* line)
+{
+    line->clear();
+    char c;
+    for (;;) {
+        ssize_t r = read(fd, &c, 1);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        if (c == '\n') return true;
+        *line += c;
+    }
+}
+
+// Pop one '\n'-terminated line from a buffer, if complete.
+static bool take_line(std::string& buf, size_t* pos, std::string* line)
+{
+    size_t end = buf.find('\n', *pos);
+    if (end == std::string::npos) return false;
+    *line = buf.substr(*pos, end - *pos);
+    *pos = end + 1;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Silence splitting: cut at the quietest 300ms between MIN_SHARD and
+// MAX_SHARD into the remaining audio, so no shard exceeds one window and
+// cuts rarely fall inside a word.
+// ---------------------------------------------------------------------------
+struct Range {
+    size_t offset;
+    size_t length;
+};
+
+static std::vector<Range> split_at_silence(const std::vector<float>& audio)
+{
+    size_t n_frames = audio.size() / FRAME;
+    std::vector<double> energy(n_frames);
+    for (size_t f = 0; f < n_frames; ++f) {
+        double e = 0.0;
+        for (size_t i = 0; i < FRAME; ++i) {
+            float x = audio[f * FRAME + i];
+            e += x * x;
+        }
+        energy[f] = e;
+    }
+
+    std::vector<Range> ranges;
+    size_t pos = 0;
+    while (audio.size() - pos > MAX_SHARD) {
+        size_t first = (pos + MIN_SHARD) / FRAME;
+        size_t last  = (pos + MAX_SHARD) / FRAME - QUIET_FRAMES;
+
+        size_t best = last;
+        double best_e = -1.0;
+        double window = 0.0;
+        for (size_t f = first; f < first + QUIET_FRAMES; ++f) window += energy[f];
+        for (size_t f = first; f <= last; ++f) {
+            if (best_e < 0.0 || window < best_e) {
+                best_e = window;
+                best = f;
+            }
+            if (f < last) window += energy[f + QUIET_FRAMES] - energy[f];
+        }
+
+        size_t cut = (best + QUIET_FRAMES / 2) * FRAME;
+        ranges.push_back({pos, cut - pos});
+        pos = cut;
+    }
+    if (pos < audio.size())
+        ranges.push_back({pos, audio.size() - pos});
+    return ranges;
+}
+
+// ---------------------------------------------------------------------------
+// Coordinator state
+// ---------------------------------------------------------------------------
+struct Segment {
+    double      start;   // seconds from the start of the file
+    double      end;
+    std::string text;
+};
+
+struct Shard {
+    int    file;
+    size_t offset;
+    size_t length;
+    int    attempts = 0;
+    bool   done     = false;
+    std::vector<Segment> segments;
+};
+
+struct InputFile {
+    std::string        path;
+    std::vector<float> audio;        // freed once every shard is done
+    std::vector<int>   shards;
+    int                remaining = 0;
+};
+
+struct Worker {
+    pid_t       pid = -1;            // -1 for workers that were not spawned here
+    int         node = -1;           // NUMA node it is bound to, -1 if none
+    int         fd  = -1;
+    std::string inbuf;
+    bool        hello = false;       // HELLO received; no shards before it
+    pid_t       hello_pid = -1;      // pid the connection reported
+    int         shard = -1;
+    Clock::time_point deadline;      // of the shard, or of HELLO on a new connection
+};
+
+struct Coordinator {
+    std::vector<std::string> inputs;
+    std::string              model_path;
+    int                      threads_per_worker = 1;
+    std::vector<numa::Node>  nodes;    // placement targets; empty = unbound
+    bool                     per_node = false;  // one worker per node, all its CPUs
+    std::string              socket_path;
+    int                      listen_fd = -1;
+
+    std::vector<InputFile> files;
+    std::vector<Shard>     shards;
+    std::deque<int>        queue;          // shard ids waiting for a worker
+    size_t                 next_input = 0; // next file to load
+    size_t                 next_emit  = 0;
+    std::vector<Worker>    workers;
+    int                    respawns   = 0;
+    int                    failed     = 0;
+    FILE*                  out        = nullptr;
+
+    bool load_next_file();
+    int  pick_node() const;
+    bool spawn_worker();
+    bool adopt(Worker& conn);
+    bool assign(Worker& w);
+    void requeue(Worker& w, const char* why);
+    void drop_worker(size_t i, const char* why);
+    bool handle_input(Worker& w);
+    void emit_ready();
+    bool finished() const;
+};
+
+bool Coordinator::load_next_file()
+{
+    while (next_input < inputs.size()) {
+        InputFile f;
+        f.path = inputs[next_input++];
+        if (!wav::read(f.path, &f.audio)) {
+            std::fprintf(stderr, "batch: skipping %s\n", f.path.c_str());
+            ++failed;
+            files.push_back(std::move(f));
+            continue;   // no shards; keeps its place in the output order
+        }
+
+        int file_idx = static_cast<int>(files.size());
+        for (const Range& r : split_at_silence(f.audio)) {
+            Shard s;
+            s.file   = file_idx;
+            s.offset = r.offset;
+            s.length = r.length;
+            f.shards.push_back(static_cast<int>(shards.size()));
+            queue.push_back(static_cast<int>(shards.size()));
+            shards.push_back(std::move(s));
+        }
+        f.remaining = static_cast<int>(f.shards.size());
+        std::fprintf(stderr, "batch: %s: %.1f s, %zu shards\n", f.path.c_str(),
+                     static_cast<double>(f.audio.size()) / SAMPLE_RATE, f.shards.size());
+        files.push_back(std::move(f));
+        return true;
+    }
+    return false;
+}
+
+// Least loaded node: fewest local workers per CPU (with one worker per
+// node, fewest workers), so replacements for a failed worker land where it
+// was
+int Coordinator::pick_node() const
+{
+    int best = -1;
+    double best_load = 0.0;
+    for (const numa::Node& n : nodes) {
+        int count = 0;
+        for (const Worker& w : workers) count += w.node == n.id;
+        double load = per_node ? count - 1e-6 * n.cpus.size()
+                               : (count + 1.0) / n.cpus.size();
+        if (best < 0 || load < best_load) {
+            best = n.id;
+            best_load = load;
+        }
+    }
+    return best;
+}
+
+bool Coordinator::spawn_worker()
+{
+    int node = pick_node();
+    int threads = threads_per_worker;
+    if (per_node)
+        for (const numa::Node& n : nodes)
+            if (n.id == node) threads = static_cast<int>(n.cpus.size());
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        std::fprintf(stderr, "batch: fork failed: %s\n", std::strerror(errno));
+        return false;
+    }
+    if (pid == 0) {
+        std::string n_threads = std::to_string(threads);
+        std::string node_id = std::to_string(node);
+        execl("/proc/self/exe", "live-whisper", "--worker", socket_path.c_str(),
+              "--model", model_path.c_str(), "--worker-threads", n_threads.c_str(),
+              "--worker-node", node_id.c_str(), static_cast<char*>(nullptr));
+        std::_Exit(127);
+    }
+    Worker w;
+    w.pid  = pid;
+    w.node = node;
+    workers.push_back(std::move(w));
+    return true;
+}
+
+// A new connection that said HELLO with the pid of a spawned worker still
+// waiting for its socket belongs to that worker: hand it over, keeping the
+// worker's node. Returns true if the connection entry is now empty; anything
+// else stays as an external worker joining the pool.
+bool Coordinator::adopt(Worker& conn)
+{
+    if (conn.pid > 0 || !conn.hello || conn.hello_pid <= 0) return false;
+    auto it = std::find_if(workers.begin(), workers.end(), [&](const Worker& w) {
+        return w.pid == conn.hello_pid && w.fd < 0;
+    });
+    if (it == workers.end()) return false;
+    it->fd    = conn.fd;
+    it->inbuf = std::move(conn.inbuf);
+    it->hello = true;
+    conn.fd = -1;
+    return true;
+}
+
+// Hand the next queued shard to an idle worker. Returns false if the send
+// failed, in which case the shard is still owned by the worker for requeue.
+bool Coordinator::assign(Worker& w)
+{
+    if (w.fd < 0 || !w.hello || w.shard >= 0) return true;
+    if (queue.empty()) load_next_file();
+    if (queue.empty()) return true;
+
+    int id = queue.front();
+    queue.pop_front();
+    Shard& s = shards[id];
+    const float* samples = files[s.file].audio.data() + s.offset;
+
+    char head[64];
+    int len = std::snprintf(head, sizeof(head), "SHARD %d %zu\n", id, s.length);
+    ++s.attempts;
+    w.shard = id;
+    double secs = static_cast<double>(s.length) / SAMPLE_RATE;
+    w.deadline = Clock::now() + std::chrono::milliseconds(static_cast<long>(
+        1000.0 * std::max(TIMEOUT_MIN_S, TIMEOUT_PER_AUDIO * secs)));
+
+    return write_all(w.fd, head, static_cast<size_t>(len))
+        && write_all(w.fd, samples, s.length * sizeof(float));
+}
+
+void Coordinator::requeue(Worker& w, const char* why)
+{
+    if (w.shard < 0) return;
+    Shard& s = shards[w.shard];
+    std::fprintf(stderr, "batch: shard %d of %s: %s (attempt %d)\n", w.shard,
+                 files[s.file].path.c_str(), why, s.attempts);
+    if (s.attempts < MAX_ATTEMPTS) {
+        queue.push_front(w.shard);
+    } else {
+        // Give up on this shard; the file is emitted without it
+        s.done = true;
+        ++failed;
+        if (--files[s.file].remaining == 0) files[s.file].audio = {};
+    }
+    w.shard = -1;
+}
+
+void Coordinator::drop_worker(size_t i, const char* why)
+{
+    Worker& w = workers[i];
+    requeue(w, why);
+    if (w.fd >= 0) close(w.fd);
+    if (w.pid > 0) {
+        kill(w.pid, SIGKILL);
+        waitpid(w.pid, nullptr, 0);
+    }
+    bool local = w.pid > 0;
+    workers.erase(workers.begin() + static_cast<long>(i));
+
+    if (local && respawns < MAX_RESPAWNS && !finished()) {
+        ++respawns;
+        spawn_worker();
+    }
+}
+
+// Parse complete messages from a worker. Returns false on protocol error.
+bool Coordinator::handle_input(Worker& w)
+{
+    for (;;) {
+        size_t pos = 0;
+        std::string line;
+        if (!take_line(w.inbuf, &pos, &line)) return true;
+
+        char kind[16] = {};
+        int id = -1, n = 0;
+        if (std::sscanf(line.c_str(), "%15s %d %d", kind, &id, &n) < 1) return false;
+        std::string k = kind;
+
+        if (k == "HELLO") {
+            if (w.hello) return false;
+            w.hello     = true;
+            w.hello_pid = id;
+        } else if (!w.hello) {
+            return false;
+        } else if (k == "RESULT") {
+            std::vector<Segment> segs;
+            for (int i = 0; i < n; ++i) {
+                std::string seg;
+                if (!take_line(w.inbuf, &pos, &seg)) return true;   // wait for the rest
+                long t0 = 0, t1 = 0;
+                int consumed = 0;
+                if (std::sscanf(seg.c_str(), "%ld\t%ld\t%n", &t0, &t1, &consumed) < 2)
+                    return false;
+                segs.push_back({t0 / 1000.0, t1 / 1000.0, seg.substr(consumed)});
+            }
+            if (id != w.shard || id < 0 || id >= static_cast<int>(shards.size()))
+                return false;
+
+            Shard& s = shards[id];
+            double base = static_cast<double>(s.offset) / SAMPLE_RATE;
+            for (Segment& seg : segs) {
+                seg.start += base;
+                seg.end   += base;
+            }
+            s.segments = std::move(segs);
+            s.done = true;
+            w.shard = -1;
+            if (--files[s.file].remaining == 0) files[s.file].audio = {};
+        } else if (k == "ERROR") {
+            if (id != w.shard) return false;
+            requeue(w, line.c_str());
+        } else {
+            return false;
+        }
+        w.inbuf.erase(0, pos);
+    }
+}
+
+void Coordinator::emit_ready()
+{
+    while (next_emit < files.size()) {
+        InputFile& f = files[next_emit];
+        if (f.remaining > 0) return;
+
+        for (int id : f.shards) {
+            for (const Segment& seg : shards[id].segments) {
+                std::string line = "{\"file\":";
+                append_json_string(line, f.path);
+                char times[64];
+                std::snprintf(times, sizeof(times), ",\"start\":%.2f,\"end\":%.2f,\"text\":",
+                              seg.start, seg.end);
+                line += times;
+                append_json_string(line, seg.text);
+                line += "}\n";
+                std::fputs(line.c_str(), out);
+            }
+            shards[id].segments.clear();
+        }
+        std::fflush(out);
+        ++next_emit;
+    }
+}
+
+bool Coordinator::finished() const
+{
+    return next_input >= inputs.size() && next_emit >= files.size();
+}
+
+// ---------------------------------------------------------------------------
+// Worker side
+// ---------------------------------------------------------------------------
+// Transcribe one shard into RESULT body lines. Returns false if whisper fails.
+static bool transcribe_shard(whisper_context* ctx, int threads,
+                             const std::vector<float>& audio, std::string* body, int* n_segments)
+{
+    whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
+    params.print_progress   = false;
+    params.print_special    = false;
+    params.print_realtime   = false;
+    params.print_timestamps = false;
+    params.no_context       = true;
+    params.language         = "en";
+    params.n_threads        = threads;
+
+    body->clear();
+    *n_segments = 0;
+    if (whisper_full(ctx, params, audio.data(), static_cast<int>(audio.size())) != 0)
+        return false;
+
+    int n = whisper_full_n_segments(ctx);
+    for (int i = 0; i < n; ++i) {
+        std::string text = whisper_full_get_segment_text(ctx, i);
+        for (char& c : text)
+            if (c == '\n' || c == '\t') c = ' ';
+        // whisper timestamps are in 10ms units
+        char head[48];
+        std::snprintf(head, sizeof(head), "%lld\t%lld\t",
+                      static_cast<long long>(whisper_full_get_segment_t0(ctx, i)) * 10,
+                      static_cast<long long>(whisper_full_get_segment_t1(ctx, i)) * 10);
+        *body += head + text + "\n";
+    }
+    *n_segments = n;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+namespace batch {
+
+int run_coordinator(const std::vector<std::string>& inputs, const std::string& output,
+                    const std::string& model_path, int workers, bool numa_placement)
+{
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int cores = static_cast<int>(sysconf(_SC_NPROCESSORS_ONLN));
+
+    Coordinator c;
+    c.inputs     = inputs;
+    c.model_path = model_path;
+    if (numa_placement) c.nodes = numa::nodes();
+    if (c.nodes.size() < 2) c.nodes.clear();   // nothing to place on UMA machines
+
+    // On NUMA machines the default is one copy of the weights per node,
+    // computed on by all of that node's CPUs; otherwise one single-threaded
+    // worker per core
+    if (workers <= 0 && !c.nodes.empty()) {
+        c.per_node = true;
+        workers = static_cast<int>(c.nodes.size());
+    }
+    if (workers <= 0) workers = std::max(1, cores);
+    c.threads_per_worker = std::max(1, cores / workers);
+
+    if (c.per_node) {
+        std::string layout;
+        for (const numa::Node& n : c.nodes)
+            layout += " " + std::to_string(n.id) + ":" + std::to_string(n.cpus.size());
+        std::fprintf(stderr, "batch: one worker per NUMA node (node:threads%s)\n", layout.c_str());
+    } else {
+        std::fprintf(stderr, "batch: %d workers x %d threads, %s\n", workers, c.threads_per_worker,
+                     c.nodes.empty() ? "no NUMA placement"
+                                     : ("spread over " + std::to_string(c.nodes.size())
+                                        + " NUMA nodes").c_str());
+    }
+
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    c.socket_path = std::string(runtime ? runtime : "/tmp")
+                  + "/live-whisper-batch-" + std::to_string(getpid()) + ".sock";
+
+    c.out = output == "-" ? stdout : std::fopen(output.c_str(), "w");
+    if (!c.out) {
+        std::fprintf(stderr, "batch: cannot open %s: %s\n", output.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    sockaddr_un addr{};
+    if (c.socket_path.size() >= sizeof(addr.sun_path)) return 1;
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, c.socket_path.c_str(), c.socket_path.size() + 1);
+    c.listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    unlink(c.socket_path.c_str());
+    if (c.listen_fd < 0
+        || bind(c.listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(c.listen_fd, workers) != 0) {
+        std::fprintf(stderr, "batch: cannot listen on %s: %s\n",
+                     c.socket_path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    auto t0 = Clock::now();
+    c.load_next_file();
+    for (int i = 0; i < workers; ++i) c.spawn_worker();
+
+    while (!c.finished()) {
+        if (c.workers.empty()) {
+            std::fprintf(stderr, "batch: no workers left\n");
+            break;
+        }
+
+        std::vector<pollfd> fds;
+        fds.push_back({c.listen_fd, POLLIN, 0});
+        for (const Worker& w : c.workers)
+            fds.push_back({w.fd, static_cast<short>(w.fd >= 0 ? POLLIN : 0), 0});
+        poll(fds.data(), fds.size(), POLL_MS);
+
+        // New connection: polled like any worker until its HELLO arrives
+        // (handle_input), then matched to a spawned worker (adopt). A peer
+        // that never says HELLO cannot stall the loop, only time out.
+        auto now = Clock::now();
+        if (fds[0].revents & POLLIN) {
+            int fd = accept4(c.listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd >= 0) {
+                Worker w;
+                w.fd = fd;
+                w.deadline = now + std::chrono::milliseconds(HELLO_TIMEOUT_MS);
+                c.workers.push_back(std::move(w));
+                fds.push_back({fd, 0, 0});   // nothing to read yet this round
+            }
+        }
+
+        for (size_t i = 0; i < c.workers.size() && i + 1 < fds.size(); ) {
+            Worker& w = c.workers[i];
+            const char* failure = nullptr;
+
+            if (w.fd >= 0 && (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+                char buf[4096];
+                ssize_t r = read(w.fd, buf, sizeof(buf));
+                if (r > 0) {
+                    w.inbuf.append(buf, static_cast<size_t>(r));
+                    if (!c.handle_input(w)) failure = "protocol error";
+                } else if (r == 0 || errno != EINTR) {
+                    failure = "worker exited";
+                }
+            }
+            if (!failure && c.adopt(w)) {
+                c.workers.erase(c.workers.begin() + static_cast<long>(i));
+                fds.erase(fds.begin() + static_cast<long>(i) + 1);
+                continue;
+            }
+            if (!failure && w.shard >= 0 && now > w.deadline) failure = "timed out";
+            if (!failure && w.fd >= 0 && !w.hello && now > w.deadline) failure = "no HELLO";
+            if (!failure && w.pid > 0 && w.fd < 0 && waitpid(w.pid, nullptr, WNOHANG) == w.pid) {
+                w.pid = -1;
+                failure = "worker failed to start";
+            }
+
+            if (!failure && !c.assign(w)) failure = "send failed";
+
+            if (failure) {
+                c.drop_worker(i, failure);
+                fds.erase(fds.begin() + static_cast<long>(i) + 1);
+                continue;
+            }
+            ++i;
+        }
+        c.emit_ready();
+    }
+
+    for (Worker& w : c.workers) {
+        if (w.fd >= 0) {
+            write_all(w.fd, "QUIT\n", 5);
+            close(w.fd);
+        }
+        if (w.pid > 0) waitpid(w.pid, nullptr, 0);
+    }
+    close(c.listen_fd);
+    unlink(c.socket_path.c_str());
+    if (c.out != stdout) std::fclose(c.out);
+
+    double secs = std::chrono::duration<double>(Clock::now() - t0).count();
+    double audio_secs = 0.0;
+    for (const Shard& s : c.shards) audio_secs += static_cast<double>(s.length) / SAMPLE_RATE;
+    std::fprintf(stderr, "batch: %zu files, %.0f s of audio in %.1f s (%.1fx real time), "
+                 "%d shards failed\n", c.files.size(), audio_secs, secs,
+                 secs > 0.0 ? audio_secs / secs : 0.0, c.failed);
+    return c.failed == 0 && c.finished() ? 0 : 1;
+}
+
+int run_worker(const std::string& socket_path, const std::string& model_path, int threads,
+               int node)
+{
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // Before the model loads, so the weights, the state and ggml's compute
+    // threads all live on the node
+    if (node >= 0) numa::bind_process(node);
+    whisper_log_set([](ggml_log_level, const char*, void*) {}, nullptr);
+
+    whisper_context_params cparams = whisper_context_default_params();
+    whisper_context* ctx = whisper_init_from_file_with_params(model_path.c_str(), cparams);
+    if (!ctx) {
+        std::fprintf(stderr, "worker: failed to load model: %s\n", model_path.c_str());
+        return 1;
+    }
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, socket_path.c_str(), sizeof(addr.sun_path) - 1);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::fprintf(stderr, "worker: cannot connect to %s: %s\n",
+                     socket_path.c_str(), std::strerror(errno));
+        whisper_free(ctx);
+        return 1;
+    }
+
+    std::string hello = "HELLO " + std::to_string(getpid()) + "\n";
+    write_all(fd, hello.data(), hello.size());
+
+    std::string line;
+    std::vector<float> audio;
+    while (read_line(fd, &line)) {
+        int id = -1;
+        size_t n = 0;
+        if (line == "QUIT") break;
+        if (std::sscanf(line.c_str(), "SHARD %d %zu", &id, &n) != 2) break;
+
+        audio.resize(n);
+        if (!read_all(fd, audio.data(), n * sizeof(float))) break;
+
+        int n_segments = 0;
+        std::string body;
+        std::string reply;
+        if (transcribe_shard(ctx, threads, audio, &body, &n_segments))
+            reply = "RESULT " + std::to_string(id) + " " + std::to_string(n_segments) + "\n" + body;
+        else
+            reply = "ERROR " + std::to_string(id) + " whisper_full failed\n";
+        if (!write_all(fd, reply.data(), reply.size())) break;
+    }
+
+    close(fd);
+    whisper_free(ctx);
+    return 0;
+}
+
+} // namespace batch
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Batch transcription of audio archives with a pool of worker processes.
+//
+// The coordinator splits each input at silence into shards of at most one
+// whisper window (28 s) and hands them to workers over a Unix stream
+// socket. Workers connect to the coordinator rather than being piped to
+// it, so workers started elsewhere can join by connecting to the same
+// protocol. Shards whose worker fails, errors or times out are retried on
+// another worker; results are stitched per file in input order with
+// timestamps relative to the start of the file.
+//
+// Protocol (one text header line, optional binary payload):
+//   worker -> coordinator  HELLO <pid>                 first, within 5 s
+//   coordinator -> worker  SHARD <id> <n_samples>   + n_samples float32
+//   worker -> coordinator  RESULT <id> <n_segments> + n lines "t0_ms\tt1_ms\ttext"
+//   worker -> coordinator  ERROR <id> <message>
+//   coordinator -> worker  QUIT
+namespace batch {
+
+// Transcribe inputs (16 kHz WAV) with `workers` local worker processes and
+// write JSON lines {"file","start","end","text"} to output ("-" = stdout).
+// With numa_placement on a multi-node machine and workers <= 0, there is
+// one worker per node, bound to it and running a thread on each of its
+// CPUs: one model copy per node, read from local memory by local threads.
+// An explicit worker count is spread over the nodes by load instead.
+int run_coordinator(const std::vector<std::string>& inputs, const std::string& output,
+                    const std::string& model_path, int workers, bool numa_placement);
+
+// Worker process: bind to NUMA node `node` (if >= 0), connect to the
+// coordinator socket and serve shards.
+int run_worker(const std::string& socket_path, const std::string& model_path, int threads,
+               int node);
+
+} // namespace batch
@@ -0,0 +1,943 @@
+#include "bench.h"
+#include "audio.h"
+#include "echo.h"
+#include "font.h"
+#include "imgui_impl_gles.h"
+#include "latency.h"
+#include "metrics.h"
+#include "transcriber.h"
+#include "ui.h"
+#include "wav.h"
+
+#include "imgui.h"
+#include "imgui_impl_opengl3.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <mutex>
+#include <pthread.h>
+#include <random>
+#include <sched.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+static constexpr int SAMPLE_RATE     = 16000;
+static constexpr int CALLBACK_MS     = 10;   // typical miniaudio capture period
+static constexpr int CALLBACK_FRAMES = SAMPLE_RATE * CALLBACK_MS / 1000;
+
+// Render bench geometry: the overlay at 2x on a 1920-wide output
+static constexpr int   RENDER_WIDTH   = 960;
+static constexpr int   RENDER_HEIGHT  = 350;
+static constexpr float RENDER_SCALE   = 2.0f;
+static constexpr float BASE_FONT_SIZE = 10.0f;
+static constexpr int   WARMUP_FRAMES  = 30;
+
+// Echo rig room model: direct path after a speaker-to-mic delay, then an
+// exponentially decaying diffuse tail
+static constexpr int   ECHO_DELAY      = SAMPLE_RATE * 30 / 1000;   // 30ms
+static constexpr int   ECHO_TAIL       = SAMPLE_RATE * 150 / 1000;  // 150ms
+static constexpr float ECHO_RT60_S     = 0.25f;
+static constexpr float ECHO_GAIN       = 0.6f;
+static constexpr int   ECHO_LATENCY    = 128;  // EchoCanceller output lag in samples
+static constexpr int   ECHO_SOLO_S     = 5;    // far end alone before and after double talk
+
+// Contention bench: each memory stressor streams over a buffer well past
+// any last-level cache; every condition is replayed a few times
+static constexpr size_t STRESS_BUF_BYTES   = 64u << 20;
+static constexpr int    CONTENTION_ROUNDS  = 3;
+static constexpr int    PIPELINE_FRAME_MS  = 16;    // overlay frame loop period
+
+// Soak: one UI frame per 16ms of wall time, one row per minute of audio.
+// Growth is measured from the windows after warm-up (the re-decode history
+// fills at 10 minutes) to the last windows of the run.
+static constexpr int    SOAK_FRAME_MS          = 16;
+static constexpr int    SOAK_WARMUP_MIN        = 12;
+static constexpr int    SOAK_COMPARE_MIN       = 5;
+static constexpr double SOAK_MAX_RSS_GROWTH_MB = 32.0;
+static constexpr double SOAK_MAX_ALLOC_GROWTH  = 2.0;   // x heap bytes per one-minute window
+static constexpr double SOAK_MAX_PASS_GROWTH   = 1.5;   // x pass p90
+static constexpr double SOAK_MAX_FRAME_GROWTH  = 1.5;   // x frame p99,
+static constexpr double SOAK_FRAME_SLACK_MS    = 1.0;   //   plus this
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static double percentile(std::vector<double> v, double p)
+{
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t idx = static_cast<size_t>(p / 100.0 * (v.size() - 1) + 0.5);
+    return v[std::min(idx, v.size() - 1)];
+}
+
+static double stddev(const std::vector<double>& v)
+{
+    if (v.size() < 2) return 0.0;
+    double mean = 0.0;
+    for (double x : v) mean += x;
+    mean /= v.size();
+    double var = 0.0;
+    for (double x : v) var += (x - mean) * (x - mean);
+    return std::sqrt(var / (v.size() - 1));
+}
+
+static void timespec_add_ms(timespec* ts, int ms)
+{
+    ts->tv_nsec += static_cast<long>(ms) * 1000000L;
+    while (ts->tv_nsec >= 1000000000L) {
+        ts->tv_nsec -= 1000000000L;
+        ++ts->tv_sec;
+    }
+}
+
+static double timespec_diff_us(const timespec& a, const timespec& b)
+{
+    return (a.tv_sec - b.tv_sec) * 1e6 + (a.tv_nsec - b.tv_nsec) / 1e3;
+}
+
+// ---------------------------------------------------------------------------
+// One real-time replay of the audio through the streaming transcriber.
+// ---------------------------------------------------------------------------
+struct ReplayStats {
+    std::vector<double> wake_late_us;   // feeder wake-up lateness per period
+    std::vector<double> pass_ms;        // inference time per pass
+    std::vector<double> decode_steps;   // decoder evaluations per pass
+    std::vector<double> staleness_ms;   // per period: audio fed but not yet shown
+    double first_partial_ms = -1.0;     // replay start to first non-empty result
+    double final_ms = 0.0;              // last sample fed to final result
+};
+
+static ReplayStats replay(Transcriber& transcriber, const std::vector<float>& audio)
+{
+    ReplayStats st;
+    std::mutex mutex;
+    double shown_s = -1.0;   // audio covered by the latest result
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    transcriber.reset();
+    transcriber.set_result_callback([&](const Transcriber::Result& r) {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        std::lock_guard<std::mutex> lk(mutex);
+        if (st.first_partial_ms < 0.0 && !r.text.empty())
+            st.first_partial_ms = timespec_diff_us(now, start) / 1e3;
+        if (!r.text.empty()) shown_s = r.audio_seconds;
+        if (r.pass_ms <= 0.0f) return;
+        st.pass_ms.push_back(r.pass_ms);
+        st.decode_steps.push_back(r.decode_steps);
+    });
+    transcriber.start();
+
+    timespec next = start;
+    for (size_t off = 0; off < audio.size(); off += CALLBACK_FRAMES) {
+        timespec_add_ms(&next, CALLBACK_MS);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        st.wake_late_us.push_back(timespec_diff_us(now, next));
+
+        size_t n = std::min<size_t>(CALLBACK_FRAMES, audio.size() - off);
+        transcriber.process(audio.data() + off, static_cast<uint32_t>(n));
+
+        std::lock_guard<std::mutex> lk(mutex);
+        if (shown_s >= 0.0)
+            st.staleness_ms.push_back((off + n) * 1000.0 / SAMPLE_RATE - shown_s * 1000.0);
+    }
+
+    timespec fed;
+    clock_gettime(CLOCK_MONOTONIC, &fed);
+    transcriber.finish();
+    timespec done;
+    clock_gettime(CLOCK_MONOTONIC, &done);
+    st.final_ms = timespec_diff_us(done, fed) / 1e3;
+
+    transcriber.set_result_callback(nullptr);
+    return st;
+}
+
+static void print_row(const char* name, const ReplayStats& st)
+{
+    double steps = 0.0;
+    for (double x : st.decode_steps) steps += x;
+    if (!st.decode_steps.empty()) steps /= st.decode_steps.size();
+
+    std::printf("%-12s %7.0f %7.0f %7.0f   %4zu %7.1f %7.1f %7.1f %7.1f %7.1f %7.1f\n",
+                name,
+                percentile(st.wake_late_us, 50), percentile(st.wake_late_us, 99),
+                percentile(st.wake_late_us, 100),
+                st.pass_ms.size(),
+                percentile(st.pass_ms, 50), percentile(st.pass_ms, 90),
+                percentile(st.pass_ms, 99), percentile(st.pass_ms, 100),
+                stddev(st.pass_ms), steps);
+}
+
+// ---------------------------------------------------------------------------
+// Stressor: background load standing in for a parallel build. CPU threads
+// spin on dependent integer and FP work in registers; memory threads
+// stream read-modify-write over their own buffer, saturating bandwidth and
+// evicting the inference working set from shared caches. Each thread is
+// pinned to its own CPU, taken from the top of the affinity mask, so N
+// threads load exactly N cores.
+// ---------------------------------------------------------------------------
+struct Stressor {
+    std::vector<std::thread> threads;
+    std::atomic<bool>        running{false};
+    std::atomic<uint64_t>    cpu_iters{0};
+    std::atomic<uint64_t>    mem_bytes{0};
+
+    ~Stressor() { stop(); }
+
+    void start(int n, bench::StressKind kind);
+    void stop();
+
+private:
+    void spin_cpu();
+    void stream_mem();
+};
+
+void Stressor::spin_cpu()
+{
+    uint64_t x = 0x9e3779b97f4a7c15ull, iters = 0;
+    double   f = 1.0;
+    while (running.load(std::memory_order_relaxed)) {
+        for (int i = 0; i < 4096; ++i) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+            f = f * 1.0000001 + static_cast<double>(x & 0xff) * 1e-9;
+        }
+        iters += 4096;
+    }
+    cpu_iters += iters + (f < 0.0 ? 1 : 0);   // keep the loop observable
+}
+
+void Stressor::stream_mem()
+{
+    std::vector<uint64_t> buf(STRESS_BUF_BYTES / sizeof(uint64_t), 1);
+    uint64_t bytes = 0;
+    while (running.load(std::memory_order_relaxed)) {
+        for (uint64_t& w : buf) w = w * 3 + 1;
+        bytes += STRESS_BUF_BYTES * 2;   // read and write
+    }
+    mem_bytes += bytes + (buf[0] == 0 ? 1 : 0);
+}
+
+void Stressor::start(int n, bench::StressKind kind)
+{
+    std::vector<int> cpus;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        for (int c = CPU_SETSIZE - 1; c >= 0; --c)
+            if (CPU_ISSET(c, &allowed)) cpus.push_back(c);
+
+    running = true;
+    for (int i = 0; i < n; ++i) {
+        bool mem = kind == bench::StressKind::Memory
+                || (kind == bench::StressKind::Mixed && i % 2 == 1);
+        threads.emplace_back(mem ? &Stressor::stream_mem : &Stressor::spin_cpu, this);
+        if (cpus.empty()) continue;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[static_cast<size_t>(i) % cpus.size()], &set);
+        int err = pthread_setaffinity_np(threads.back().native_handle(), sizeof(set), &set);
+        if (err != 0)
+            std::fprintf(stderr, "bench: cannot pin stressor %d: %s\n", i, std::strerror(err));
+    }
+}
+
+void Stressor::stop()
+{
+    running = false;
+    for (std::thread& t : threads) t.join();
+    threads.clear();
+}
+
+static void print_contention_row(const char* name, const std::vector<ReplayStats>& rounds)
+{
+    std::vector<double> first, stale, final_ms, pass;
+    for (const ReplayStats& st : rounds) {
+        if (st.first_partial_ms >= 0.0) first.push_back(st.first_partial_ms);
+        final_ms.push_back(st.final_ms);
+        stale.insert(stale.end(), st.staleness_ms.begin(), st.staleness_ms.end());
+        pass.insert(pass.end(), st.pass_ms.begin(), st.pass_ms.end());
+    }
+    std::printf("%-10s %7.0f %7.0f   %7.0f %7.0f %7.0f %7.0f   %7.0f %7.0f   %5zu %7.0f\n",
+                name,
+                percentile(first, 50), percentile(first, 100),
+                percentile(stale, 50), percentile(stale, 90), percentile(stale, 99),
+                percentile(stale, 100),
+                percentile(final_ms, 50), percentile(final_ms, 100),
+                pass.size(), percentile(pass, 50));
+}
+
+// ---------------------------------------------------------------------------
+// Offscreen GL: surfaceless EGL context rendering into an FBO, so the render
+// bench runs without a compositor (e.g. on llvmpipe in CI).
+// ---------------------------------------------------------------------------
+struct OffscreenGL {
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLContext context = EGL_NO_CONTEXT;
+    GLuint     fbo = 0;
+    GLuint     rbo = 0;
+
+    bool init(int w, int h)
+    {
+        auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+            eglGetProcAddress("eglGetPlatformDisplayEXT"));
+        if (!get_platform_display) {
+            std::fprintf(stderr, "bench: eglGetPlatformDisplayEXT unavailable\n");
+            return false;
+        }
+        display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+            std::fprintf(stderr, "bench: surfaceless EGL display unavailable\n");
+            return false;
+        }
+        eglBindAPI(EGL_OPENGL_ES_API);
+
+        EGLint config_attribs[] = { EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT, EGL_NONE };
+        EGLConfig config;
+        EGLint num_configs = 0;
+        eglChooseConfig(display, config_attribs, &config, 1, &num_configs);
+        EGLint ctx_attribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+        context = eglCreateContext(display, num_configs > 0 ? config : EGL_NO_CONFIG_KHR,
+                                   EGL_NO_CONTEXT, ctx_attribs);
+        if (context == EGL_NO_CONTEXT ||
+            !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            std::fprintf(stderr, "bench: cannot create surfaceless GLES3 context\n");
+            return false;
+        }
+
+        glGenRenderbuffers(1, &rbo);
+        glBindRenderbuffer(GL_RENDERBUFFER, rbo);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, w, h);
+        glGenFramebuffers(1, &fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rbo);
+        return glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    void shutdown()
+    {
+        if (fbo) glDeleteFramebuffers(1, &fbo);
+        if (rbo) glDeleteRenderbuffers(1, &rbo);
+        if (context != EGL_NO_CONTEXT) {
+            eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            eglDestroyContext(display, context);
+        }
+        if (display != EGL_NO_DISPLAY) eglTerminate(display);
+    }
+};
+
+struct RenderStats {
+    std::vector<double> frame_ms;
+    double draw_calls = 0.0;   // per frame
+};
+
+// ImGui context for the offscreen overlay, with either renderer
+static ImGuiIO& begin_offscreen_ui(bool stock)
+{
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(RENDER_WIDTH, RENDER_HEIGHT);
+    io.DisplayFramebufferScale = ImVec2(RENDER_SCALE, RENDER_SCALE);
+    ui::apply_style(RENDER_SCALE);
+    ImGui::UseSdfFont(io, BASE_FONT_SIZE * RENDER_SCALE);
+
+    if (stock)
+        ImGui_ImplOpenGL3_Init("#version 300 es");
+    else
+        ImGui_ImplGLES::Init(ImGui::SdfFontActive());
+    return io;
+}
+
+static void end_offscreen_ui(bool stock)
+{
+    if (stock) ImGui_ImplOpenGL3_Shutdown(); else ImGui_ImplGLES::Shutdown();
+    ImGui::SdfFontShutdown();
+    ImGui::DestroyContext();
+}
+
+// One overlay frame of ui::draw(), rendered into the offscreen target.
+static void draw_offscreen_frame(ImGuiIO& io, ui::State& state, int frame_ms)
+{
+    io.DeltaTime = frame_ms / 1000.0f;
+    ImGui_ImplGLES::NewFrame();
+    ImGui::NewFrame();
+    ui::draw(state);
+    ImGui::Render();
+    glViewport(0, 0, static_cast<int>(RENDER_WIDTH * RENDER_SCALE),
+               static_cast<int>(RENDER_HEIGHT * RENDER_SCALE));
+    glClear(GL_COLOR_BUFFER_BIT);
+    ImGui_ImplGLES::RenderDrawData(ImGui::GetDrawData());
+    glFinish();
+}
+
+// ---------------------------------------------------------------------------
+// One real-time replay through the whole overlay pipeline: a feeder thread
+// writes the audio into an AudioCapture ring in 10ms periods, like the
+// capture callback, while this thread runs the overlay's frame loop —
+// drain the ring into the transcriber, splice the latest result into the
+// transcript, draw and render it offscreen. Staleness is measured against
+// the text a frame has actually drawn. Needs begin_offscreen_ui(false).
+// ---------------------------------------------------------------------------
+static ReplayStats replay_pipeline(Transcriber& transcriber, const std::vector<float>& audio,
+                                   ImGuiIO& io)
+{
+    ReplayStats st;
+    AudioCapture capture;
+    if (!capture.init_injected()) return st;
+
+    std::vector<char> text(64 * 1024, '\0');
+    ui::State state;
+    state.text     = text.data();
+    state.text_cap = text.size();
+
+    std::mutex  mutex;
+    bool        pending = false;
+    std::string pending_text;
+    float       pending_audio_s = 0.0f;
+    double      shown_s = -1.0;          // audio covered by the drawn text
+    std::atomic<bool> fed_all{false};
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    timespec fed = start;
+
+    transcriber.reset();
+    transcriber.set_result_callback([&](const Transcriber::Result& r) {
+        std::lock_guard<std::mutex> lk(mutex);
+        pending_text    = r.text;
+        pending_audio_s = r.audio_seconds;
+        pending         = true;
+        if (r.pass_ms <= 0.0f) return;
+        st.pass_ms.push_back(r.pass_ms);
+        st.decode_steps.push_back(r.decode_steps);
+    });
+    transcriber.start();
+
+    std::thread feeder([&] {
+        timespec next = start;
+        for (size_t off = 0; off < audio.size(); off += CALLBACK_FRAMES) {
+            timespec_add_ms(&next, CALLBACK_MS);
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            size_t n = std::min<size_t>(CALLBACK_FRAMES, audio.size() - off);
+            capture.inject(audio.data() + off, static_cast<uint32_t>(n));
+
+            std::lock_guard<std::mutex> lk(mutex);
+            st.wake_late_us.push_back(timespec_diff_us(now, next));
+            if (shown_s >= 0.0)
+                st.staleness_ms.push_back((off + n) * 1000.0 / SAMPLE_RATE - shown_s * 1000.0);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &fed);
+        fed_all = true;
+    });
+
+    std::vector<float> buf(SAMPLE_RATE / 10);
+    timespec next = start;
+    while (!fed_all.load() || capture.available() > 0) {
+        timespec_add_ms(&next, PIPELINE_FRAME_MS);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+
+        while (uint32_t got = capture.read(buf.data(), static_cast<uint32_t>(buf.size())))
+            transcriber.process(buf.data(), got);
+
+        bool splice = false;
+        float audio_s = 0.0f;
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (pending) {
+                splice  = !pending_text.empty();
+                state.live_text  = std::move(pending_text);
+                state.live_dirty = true;
+                audio_s = pending_audio_s;
+                pending = false;
+            }
+        }
+        draw_offscreen_frame(io, state, PIPELINE_FRAME_MS);
+        if (splice) {
+            timespec now;
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            std::lock_guard<std::mutex> lk(mutex);
+            if (st.first_partial_ms < 0.0) st.first_partial_ms = timespec_diff_us(now, start) / 1e3;
+            shown_s = audio_s;
+        }
+    }
+    feeder.join();
+
+    transcriber.finish();
+    timespec done;
+    clock_gettime(CLOCK_MONOTONIC, &done);
+    st.final_ms = timespec_diff_us(done, fed) / 1e3;
+
+    transcriber.set_result_callback(nullptr);
+    capture.shutdown();
+    return st;
+}
+
+// Render the overlay with a long transcript for the given number of frames.
+static RenderStats render_frames(bool stock, int frames)
+{
+    RenderStats st;
+    ImGuiIO& io = begin_offscreen_ui(stock);
+
+    std::string sample;
+    while (sample.size() < 4000)
+        sample += "The quick brown fox jumps over the lazy dog while we keep talking. ";
+    std::vector<char> text(sample.begin(), sample.end());
+    text.resize(64 * 1024, '\0');
+
+    ui::State state;
+    state.text     = text.data();
+    state.text_cap = text.size();
+
+    long calls = 0;
+    for (int i = 0; i < WARMUP_FRAMES + frames; ++i) {
+        auto t0 = std::chrono::steady_clock::now();
+
+        io.DeltaTime = 1.0f / 60.0f;
+        state.recording_seconds = i / 60.0f;
+        if (stock) ImGui_ImplOpenGL3_NewFrame(); else ImGui_ImplGLES::NewFrame();
+        ImGui::NewFrame();
+        if (stock) ImGui::SdfFontNewFrame();
+        ui::draw(state);
+        ImGui::Render();
+
+        glViewport(0, 0, static_cast<int>(RENDER_WIDTH * RENDER_SCALE),
+                   static_cast<int>(RENDER_HEIGHT * RENDER_SCALE));
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        ImDrawData* dd = ImGui::GetDrawData();
+        int frame_calls = 0;
+        if (stock) {
+            ImGui_ImplOpenGL3_RenderDrawData(dd);
+            for (const ImDrawList* list : dd->CmdLists)
+                for (const ImDrawCmd& cmd : list->CmdBuffer)
+                    if (!cmd.UserCallback) ++frame_calls;
+        } else {
+            ImGui_ImplGLES::RenderDrawData(dd);
+            frame_calls = ImGui_ImplGLES::LastDrawCalls();
+        }
+        glFinish();  // count GPU (llvmpipe) work in the frame time
+
+        if (i < WARMUP_FRAMES) continue;
+        st.frame_ms.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count());
+        calls += frame_calls;
+    }
+    st.draw_calls = frames > 0 ? static_cast<double>(calls) / frames : 0.0;
+
+    end_offscreen_ui(stock);
+    return st;
+}
+
+static void print_render_row(const char* name, const RenderStats& st)
+{
+    double mean = 0.0;
+    for (double x : st.frame_ms) mean += x;
+    if (!st.frame_ms.empty()) mean /= st.frame_ms.size();
+    std::printf("%-20s %8.3f %8.3f %8.3f %8.3f %8.1f\n", name, mean,
+                percentile(st.frame_ms, 50), percentile(st.frame_ms, 99),
+                percentile(st.frame_ms, 100), st.draw_calls);
+}
+
+// ---------------------------------------------------------------------------
+// Soak: an accelerated long session through the transcriber and the overlay
+// UI rendered offscreen, sampled once per minute of audio.
+// ---------------------------------------------------------------------------
+struct SoakWindow {
+    long                rss_kb = 0;
+    double              alloc_bytes = 0.0;   // heap bytes allocated in the window
+    size_t              text_bytes = 0;
+    std::vector<double> pass_ms;
+    std::vector<double> frame_ms;
+};
+
+// Pool the windows [from, to) for a before/after comparison.
+static SoakWindow pool_windows(const std::vector<SoakWindow>& ws, size_t from, size_t to)
+{
+    SoakWindow p;
+    for (size_t i = from; i < to && i < ws.size(); ++i) {
+        p.rss_kb = ws[i].rss_kb;
+        p.alloc_bytes += ws[i].alloc_bytes / (to - from);
+        p.pass_ms.insert(p.pass_ms.end(), ws[i].pass_ms.begin(), ws[i].pass_ms.end());
+        p.frame_ms.insert(p.frame_ms.end(), ws[i].frame_ms.begin(), ws[i].frame_ms.end());
+    }
+    return p;
+}
+
+static bool soak_check(const char* what, double before, double after, double limit,
+                       const char* unit)
+{
+    bool ok = after <= limit;
+    std::printf("%-4s %-24s %10.2f -> %10.2f %s (limit %.2f)\n",
+                ok ? "ok" : "FAIL", what, before, after, unit, limit);
+    return ok;
+}
+
+// ---------------------------------------------------------------------------
+// Echo rig: deterministic synthetic room impulse response.
+// ---------------------------------------------------------------------------
+static std::vector<float> synthetic_rir()
+{
+    std::vector<float> h(ECHO_DELAY + ECHO_TAIL, 0.0f);
+    std::mt19937 rng(1234);
+    std::normal_distribution<float> noise(0.0f, 1.0f);
+
+    h[ECHO_DELAY] = 1.0f;
+    float decay = std::log(1000.0f) / (ECHO_RT60_S * SAMPLE_RATE);  // -60 dB at RT60
+    for (int i = 1; i < ECHO_TAIL; ++i)
+        h[ECHO_DELAY + i] = 0.3f * noise(rng) * std::exp(-decay * i);
+
+    float energy = 0.0f;
+    for (float x : h) energy += x * x;
+    float norm = ECHO_GAIN / std::sqrt(energy);
+    for (float& x : h) x *= norm;
+    return h;
+}
+
+static std::vector<float> convolve(const std::vector<float>& x, const std::vector<float>& h)
+{
+    std::vector<float> y(x.size(), 0.0f);
+    for (size_t n = 0; n < x.size(); ++n) {
+        size_t taps = std::min(h.size(), n + 1);
+        float acc = 0.0f;
+        for (size_t k = 0; k < taps; ++k)
+            acc += h[k] * x[n - k];
+        y[n] = acc;
+    }
+    return y;
+}
+
+static double to_db(double num, double den)
+{
+    if (den <= 0.0) return 99.0;
+    if (num <= 0.0) return -99.0;
+    return 10.0 * std::log10(num / den);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+namespace bench {
+
+int run_jitter(Transcriber& transcriber, const std::string& wav_path,
+               int latency_us, bool performance_epp)
+{
+    std::vector<float> audio;
+    if (!wav::read(wav_path, &audio)) return 1;
+
+    std::printf("bench: %s, %.1f s of audio\n\n", wav_path.c_str(),
+                static_cast<double>(audio.size()) / SAMPLE_RATE);
+    std::printf("%-12s %23s   %36s\n", "", "wake late (us)", "pass (ms)");
+    std::printf("%-12s %7s %7s %7s   %4s %7s %7s %7s %7s %7s %7s\n",
+                "run", "p50", "p99", "max", "n", "p50", "p90", "p99", "max", "stddev", "steps");
+
+    print_row("baseline", replay(transcriber, audio));
+
+    if (latency_us >= 0) {
+        LatencyHint hint;
+        if (!hint.init(latency_us, performance_epp)) {
+            std::fprintf(stderr, "bench: no latency hint could be applied\n");
+            return 1;
+        }
+        print_row("low-latency", replay(transcriber, audio));
+        hint.shutdown();
+    }
+    return 0;
+}
+
+int run_contention(Transcriber& transcriber, const std::string& wav_path,
+                   int cores, StressKind kind)
+{
+    std::vector<float> audio;
+    if (!wav::read(wav_path, &audio)) return 1;
+
+    if (cores <= 0) cores = static_cast<int>(std::thread::hardware_concurrency());
+    const char* kind_name = kind == StressKind::Cpu    ? "cpu"
+                          : kind == StressKind::Memory ? "memory" : "mixed";
+    // Audio goes through the capture ring and the overlay frame loop, as in
+    // a session, with the overlay rendered offscreen
+    OffscreenGL gl;
+    if (!gl.init(static_cast<int>(RENDER_WIDTH * RENDER_SCALE),
+                 static_cast<int>(RENDER_HEIGHT * RENDER_SCALE))) {
+        gl.shutdown();
+        return 1;
+    }
+    ImGuiIO& io = begin_offscreen_ui(false);
+
+    std::printf("contention bench: %s, %.1f s of audio, %d rounds per run, "
+                "stressor: %d threads (%s) pinned one per core\n\n",
+                wav_path.c_str(), static_cast<double>(audio.size()) / SAMPLE_RATE,
+                CONTENTION_ROUNDS, cores, kind_name);
+    std::printf("%-10s %15s   %31s   %15s   %13s\n",
+                "", "first (ms)", "staleness (ms)", "final (ms)", "pass (ms)");
+    std::printf("%-10s %7s %7s   %7s %7s %7s %7s   %7s %7s   %5s %7s\n",
+                "run", "p50", "max", "p50", "p90", "p99", "max", "p50", "max", "n", "p50");
+
+    std::vector<ReplayStats> idle;
+    for (int i = 0; i < CONTENTION_ROUNDS; ++i)
+        idle.push_back(replay_pipeline(transcriber, audio, io));
+    print_contention_row("idle", idle);
+
+    Stressor stressor;
+    auto t0 = std::chrono::steady_clock::now();
+    stressor.start(cores, kind);
+    std::vector<ReplayStats> loaded;
+    for (int i = 0; i < CONTENTION_ROUNDS; ++i)
+        loaded.push_back(replay_pipeline(transcriber, audio, io));
+    stressor.stop();
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    print_contention_row("stressed", loaded);
+
+    std::printf("\nstressor: %.2f G iterations/s, %.1f GB/s memory traffic\n",
+                stressor.cpu_iters.load() / secs / 1e9, stressor.mem_bytes.load() / secs / 1e9);
+
+    end_offscreen_ui(false);
+    gl.shutdown();
+    return 0;
+}
+
+int run_soak(Transcriber& transcriber, const std::string& wav_path, int minutes, double speed)
+{
+    std::vector<float> clip;
+    if (!wav::read(wav_path, &clip) || clip.empty()) return 1;
+    if (minutes < SOAK_WARMUP_MIN + 2 * SOAK_COMPARE_MIN) {
+        std::fprintf(stderr, "bench: a soak needs at least %d minutes\n",
+                     SOAK_WARMUP_MIN + 2 * SOAK_COMPARE_MIN);
+        return 1;
+    }
+
+    OffscreenGL gl;
+    if (!gl.init(static_cast<int>(RENDER_WIDTH * RENDER_SCALE),
+                 static_cast<int>(RENDER_HEIGHT * RENDER_SCALE))) {
+        gl.shutdown();
+        return 1;
+    }
+    ImGuiIO& io = begin_offscreen_ui(false);
+
+    std::vector<char> text(64 * 1024, '\0');
+    ui::State state;
+    state.text     = text.data();
+    state.text_cap = text.size();
+
+    // Results are spliced by the frame loop, as the overlay does
+    std::mutex  mutex;
+    bool        pending = false;
+    std::string pending_text;
+    std::vector<double> pass_ms;
+    transcriber.reset();
+    transcriber.set_result_callback([&](const Transcriber::Result& r) {
+        std::lock_guard<std::mutex> lk(mutex);
+        pending_text = r.text;
+        pending      = true;
+        if (r.pass_ms > 0.0f) pass_ms.push_back(r.pass_ms);
+    });
+    transcriber.start();
+
+    const size_t total  = static_cast<size_t>(minutes) * 60 * SAMPLE_RATE;
+    const size_t window = static_cast<size_t>(60) * SAMPLE_RATE;
+    const size_t chunk  = static_cast<size_t>(speed * SAMPLE_RATE * SOAK_FRAME_MS / 1000);
+    std::printf("soak: %s looped to %d min at %.1fx (%.1f min wall)\n\n", wav_path.c_str(),
+                minutes, speed, minutes / speed);
+    std::printf("%5s %9s %10s %9s %6s %8s %8s %8s\n",
+                "min", "rss MB", "alloc MB", "text KB", "passes", "pass p90", "frame p50",
+                "frame p99");
+
+    std::vector<SoakWindow> windows;
+    SoakWindow cur;
+    uint64_t alloc_mark = metrics::allocated_bytes();
+    size_t fed = 0, clip_pos = 0;
+    timespec next;
+    clock_gettime(CLOCK_MONOTONIC, &next);
+
+    while (fed < total) {
+        timespec_add_ms(&next, SOAK_FRAME_MS);
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timespec_diff_us(now, next) > 100000.0) next = now;   // fell behind: don't spiral
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr);
+        auto t0 = std::chrono::steady_clock::now();
+
+        for (size_t left = std::min(chunk, total - fed); left > 0; ) {
+            size_t n = std::min(left, clip.size() - clip_pos);
+            transcriber.process(clip.data() + clip_pos, static_cast<uint32_t>(n));
+            clip_pos = (clip_pos + n) % clip.size();
+            fed  += n;
+            left -= n;
+        }
+
+        {
+            std::lock_guard<std::mutex> lk(mutex);
+            if (pending) {
+                state.live_text  = std::move(pending_text);
+                state.live_dirty = true;
+                pending = false;
+            }
+        }
+        state.recording_seconds = static_cast<float>(fed) / SAMPLE_RATE;
+        draw_offscreen_frame(io, state, SOAK_FRAME_MS);
+        cur.frame_ms.push_back(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count());
+
+        if (fed >= (windows.size() + 1) * window || fed >= total) {
+            uint64_t alloc_now = metrics::allocated_bytes();
+            cur.rss_kb      = metrics::rss_kb();
+            cur.alloc_bytes = static_cast<double>(alloc_now - alloc_mark);
+            cur.text_bytes  = std::strlen(text.data());
+            alloc_mark = alloc_now;
+            {
+                std::lock_guard<std::mutex> lk(mutex);
+                cur.pass_ms.swap(pass_ms);
+            }
+            std::printf("%5zu %9.1f %10.1f %9.1f %6zu %8.0f %8.2f %8.2f\n", windows.size() + 1,
+                        cur.rss_kb / 1024.0, cur.alloc_bytes / 1e6, cur.text_bytes / 1024.0,
+                        cur.pass_ms.size(), percentile(cur.pass_ms, 90),
+                        percentile(cur.frame_ms, 50), percentile(cur.frame_ms, 99));
+            std::fflush(stdout);
+            windows.push_back(std::move(cur));
+            cur = {};
+        }
+    }
+
+    transcriber.finish();
+    transcriber.set_result_callback(nullptr);
+    end_offscreen_ui(false);
+    gl.shutdown();
+
+    // Warm-up windows against the last ones
+    size_t n = windows.size();
+    SoakWindow a = pool_windows(windows, SOAK_WARMUP_MIN, SOAK_WARMUP_MIN + SOAK_COMPARE_MIN);
+    SoakWindow b = pool_windows(windows, n - SOAK_COMPARE_MIN, n);
+    double pass_a  = percentile(a.pass_ms, 90),  pass_b  = percentile(b.pass_ms, 90);
+    double frame_a = percentile(a.frame_ms, 99), frame_b = percentile(b.frame_ms, 99);
+
+    std::printf("\nminutes %d-%d against %zu-%zu:\n", SOAK_WARMUP_MIN + 1,
+                SOAK_WARMUP_MIN + SOAK_COMPARE_MIN, n - SOAK_COMPARE_MIN + 1, n);
+    bool ok = true;
+    ok &= soak_check("rss", a.rss_kb / 1024.0, b.rss_kb / 1024.0,
+                     a.rss_kb / 1024.0 + SOAK_MAX_RSS_GROWTH_MB, "MB");
+    ok &= soak_check("heap allocated / min", a.alloc_bytes / 1e6, b.alloc_bytes / 1e6,
+                     a.alloc_bytes / 1e6 * SOAK_MAX_ALLOC_GROWTH, "MB");
+    ok &= soak_check("pass p90", pass_a, pass_b, pass_a * SOAK_MAX_PASS_GROWTH, "ms");
+    ok &= soak_check("frame p99", frame_a, frame_b,
+                     frame_a * SOAK_MAX_FRAME_GROWTH + SOAK_FRAME_SLACK_MS, "ms");
+    std::printf("\nsoak %s\n", ok ? "passed" : "FAILED");
+    return ok ? 0 : 1;
+}
+
+int run_render(int frames)
+{
+    OffscreenGL gl;
+    if (!gl.init(static_cast<int>(RENDER_WIDTH * RENDER_SCALE),
+                 static_cast<int>(RENDER_HEIGHT * RENDER_SCALE))) {
+        gl.shutdown();
+        return 1;
+    }
+
+    std::printf("render bench: %dx%d @%.0fx, %d frames, renderer %s\n\n",
+                RENDER_WIDTH, RENDER_HEIGHT, static_cast<double>(RENDER_SCALE), frames,
+                reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    std::printf("%-20s %8s %8s %8s %8s %8s\n",
+                "backend", "mean ms", "p50", "p99", "max", "draws");
+
+    print_render_row("imgui_impl_opengl3", render_frames(true, frames));
+    print_render_row("imgui_impl_gles", render_frames(false, frames));
+
+    gl.shutdown();
+    return 0;
+}
+
+int run_echo(const std::string& near_wav, const std::string& far_wav)
+{
+    std::vector<float> near_talk, far_loop;
+    if (!wav::read(near_wav, &near_talk) || !wav::read(far_wav, &far_loop) || far_loop.empty())
+        return 1;
+
+    // Far end alone (convergence), the near end talking over it (double
+    // talk), far end alone again (did the filter hold?). The far end loops.
+    size_t dt_begin = static_cast<size_t>(ECHO_SOLO_S) * SAMPLE_RATE;
+    size_t dt_end   = dt_begin + near_talk.size();
+    size_t n        = dt_end + static_cast<size_t>(ECHO_SOLO_S) * SAMPLE_RATE;
+    std::vector<float> near(n, 0.0f), far(n);
+    std::copy(near_talk.begin(), near_talk.end(), near.begin() + static_cast<long>(dt_begin));
+    for (size_t i = 0; i < n; ++i) far[i] = far_loop[i % far_loop.size()];
+
+    std::vector<float> echo = convolve(far, synthetic_rir());
+    std::vector<float> mic(n);
+    for (size_t i = 0; i < n; ++i)
+        mic[i] = near[i] + echo[i];
+
+    std::vector<float> out(n);
+    std::vector<double> step(n / SAMPLE_RATE + 1, 0.0);
+    std::vector<int> step_n(step.size(), 0);
+    EchoCanceller canceller;
+    double elapsed_ms = 0.0;
+    for (size_t off = 0; off < n; off += CALLBACK_FRAMES) {
+        uint32_t len = static_cast<uint32_t>(std::min<size_t>(CALLBACK_FRAMES, n - off));
+        auto t0 = std::chrono::steady_clock::now();
+        canceller.process(mic.data() + off, far.data() + off, out.data() + off, len);
+        elapsed_ms += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+        step[off / SAMPLE_RATE] += canceller.step_scale();
+        ++step_n[off / SAMPLE_RATE];
+    }
+
+    std::printf("echo bench: %s over echo of %s, %.1f s (double talk %.1f-%.1f s), "
+                "%.1f ms to process (%.0fx real time)\n\n",
+                near_wav.c_str(), far_wav.c_str(), static_cast<double>(n) / SAMPLE_RATE,
+                static_cast<double>(dt_begin) / SAMPLE_RATE,
+                static_cast<double>(dt_end) / SAMPLE_RATE,
+                elapsed_ms, elapsed_ms > 0.0 ? n * 1000.0 / SAMPLE_RATE / elapsed_ms : 0.0);
+    std::printf("%6s %-7s %10s %10s %10s %6s\n", "sec", "phase", "echo dB", "resid dB", "ERLE dB", "step");
+
+    // Residual echo = output minus the (delayed) near end it should
+    // preserve, so near-end damage during double talk counts against it
+    enum { BEFORE, DOUBLE_TALK, AFTER, PHASES };
+    static const char* const phase_names[PHASES] = {"far", "double", "far"};
+    double phase_echo[PHASES] = {}, phase_resid[PHASES] = {};
+    for (size_t sec = 0; sec * SAMPLE_RATE < n; ++sec) {
+        size_t begin = sec * SAMPLE_RATE;
+        size_t end   = std::min(n, begin + SAMPLE_RATE);
+        double e = 0.0, r = 0.0;
+        for (size_t i = std::max<size_t>(begin, ECHO_LATENCY); i < end; ++i) {
+            double resid = out[i] - near[i - ECHO_LATENCY];
+            double ei    = echo[i - ECHO_LATENCY];
+            e += ei * ei;
+            r += resid * resid;
+        }
+        size_t mid = (begin + end) / 2;
+        int phase = mid < dt_begin ? BEFORE : mid < dt_end ? DOUBLE_TALK : AFTER;
+        phase_echo[phase]  += e;
+        phase_resid[phase] += r;
+        std::printf("%6zu %-7s %10.1f %10.1f %10.1f %6.2f\n", sec, phase_names[phase],
+                    to_db(e, static_cast<double>(end - begin)),
+                    to_db(r, static_cast<double>(end - begin)), to_db(e, r),
+                    step_n[sec] ? step[sec] / step_n[sec] : 0.0);
+    }
+    std::printf("\nERLE converging %.1f dB, double talk %.1f dB, after %.1f dB\n",
+                to_db(phase_echo[BEFORE], phase_resid[BEFORE]),
+                to_db(phase_echo[DOUBLE_TALK], phase_resid[DOUBLE_TALK]),
+                to_db(phase_echo[AFTER], phase_resid[AFTER]));
+    return 0;
+}
+
+} // namespace bench
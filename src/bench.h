@@ -0,0 +1,49 @@
+#pragma once
+
+#include <string>
+
+struct Transcriber;
+
+namespace bench {
+
+// Replay a WAV file through the transcriber in real time, 10ms at a time
+// like the capture callback, and report wake-up lateness of the feeding
+// thread and per-pass inference latency. With latency_us >= 0 the replay
+// runs a second time holding a LatencyHint so both can be compared.
+int run_jitter(Transcriber& transcriber, const std::string& wav_path,
+               int latency_us, bool performance_epp);
+
+enum class StressKind { Cpu, Memory, Mixed };
+
+// Replay a WAV file in real time through the capture ring, the transcriber
+// and the overlay frame loop (rendered offscreen), CONTENTION_ROUNDS times
+// idle and as many times while `cores` stressor threads (0 = one per
+// hardware thread), each pinned to its own CPU, load the CPU, memory
+// bandwidth or both. Reports time to first drawn partial, staleness (audio
+// fed but not yet in the drawn text, sampled every 10ms) and final latency
+// after the last sample.
+int run_contention(Transcriber& transcriber, const std::string& wav_path,
+                   int cores, StressKind kind);
+
+// Soak test: loop a WAV file to `minutes` of audio and feed it at `speed`
+// times real time through the transcriber and the overlay UI rendered
+// offscreen, printing RSS, heap traffic, transcript size, pass and frame
+// latency per minute of audio. Fails (returns 1) if memory, allocation
+// rate, pass or frame latency grow beyond fixed limits between the
+// windows after warm-up and the end of the run.
+int run_soak(Transcriber& transcriber, const std::string& wav_path, int minutes, double speed);
+
+// Render the overlay UI offscreen (surfaceless EGL + FBO, no compositor)
+// for the given number of frames with the stock imgui_impl_opengl3 backend
+// and with ImGui_ImplGLES, and report CPU time per frame and draw calls.
+int run_render(int frames);
+
+// Echo canceller rig: convolve far_wav (looped) with a synthetic room
+// response as the echo, run EchoCanceller with far_wav as the reference, and
+// report echo return loss enhancement (ERLE) per second. near_wav talks over
+// the echo after 5 s of far end alone and is followed by 5 s more, so the
+// table shows convergence, double talk and whether the filter held through
+// it. Either file may be the same recording.
+int run_echo(const std::string& near_wav, const std::string& far_wav);
+
+} // namespace bench
@@ -0,0 +1,313 @@
+#include "config.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <mutex>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace config {
+
+// ---------------------------------------------------------------------------
+// Keys and their valid ranges. Keys with names also accept those words for
+// the values min, min + 1, ...
+// ---------------------------------------------------------------------------
+struct Key {
+    const char*        name;
+    int Tuning::*      field;
+    int                min;
+    int                max;
+    const char* const* names = nullptr;
+};
+
+static const char* const ACCURACY_NAMES[] = {"fast", "balanced", "exact", nullptr};
+
+static const Key KEYS[] = {
+    {"initial_interval_ms", &Tuning::initial_interval_ms, 50,    5000},
+    {"stream_interval_ms",  &Tuning::stream_interval_ms,  50,    5000},
+    {"boundary_dip_ms",     &Tuning::boundary_dip_ms,     0,     1000},
+    {"min_pass_gap_ms",     &Tuning::min_pass_gap_ms,     0,     5000},
+    {"min_samples",         &Tuning::min_samples,         1600,  16000 * 10},
+    {"commit_samples",      &Tuning::commit_samples,      16000, 16000 * 28},  // inside one window
+    {"ring_buf_secs",       &Tuning::ring_buf_secs,       5,     600},
+    {"read_buf_size",       &Tuning::read_buf_size,       160,   16000},
+    {"overlay_height",      &Tuning::overlay_height,      80,    2000},
+    {"threads",             &Tuning::threads,             0,     256},
+    {"threads_min",         &Tuning::threads_min,         1,     256},
+    {"threads_max",         &Tuning::threads_max,         1,     256},
+    {"speech_threshold_db", &Tuning::speech_threshold_db, -70,   -10},
+    {"speech_over_floor",   &Tuning::speech_over_floor,   1,     20},
+    {"accuracy",            &Tuning::accuracy,            ACCURACY_FAST, ACCURACY_EXACT,
+                            ACCURACY_NAMES},
+};
+
+// One parsed `key = value`; keep = true for an invalid value, which leaves
+// the value in effect alone
+struct Entry {
+    const Key* key;
+    int        value;
+    bool       keep;
+};
+
+struct Section {
+    std::string        name;   // empty for the base section
+    std::vector<Entry> entries;
+};
+
+static std::mutex           g_mutex;
+static Tuning               g_tuning;
+static std::vector<Section> g_sections;
+static std::string          g_variant;
+
+static std::thread g_watcher;
+static int         g_inotify = -1;
+static int         g_wake[2] = {-1, -1};
+
+static std::string trim(const std::string& s)
+{
+    size_t b = s.find_first_not_of(" \t\r");
+    if (b == std::string::npos) return {};
+    size_t e = s.find_last_not_of(" \t\r");
+    return s.substr(b, e - b + 1);
+}
+
+static std::string config_dir()
+{
+    if (const char* xdg = std::getenv("XDG_CONFIG_HOME"); xdg && *xdg)
+        return std::string(xdg) + "/live-whisper";
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.config/live-whisper";
+}
+
+std::string path() { return config_dir() + "/config"; }
+
+// ---------------------------------------------------------------------------
+// Parsing
+// ---------------------------------------------------------------------------
+static bool parse_value(const Key& key, const std::string& value, int* out)
+{
+    if (key.names)
+        for (int i = 0; key.names[i]; ++i)
+            if (value == key.names[i]) {
+                *out = key.min + i;
+                return true;
+            }
+
+    char* end = nullptr;
+    errno = 0;
+    long v = std::strtol(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || errno == ERANGE || v < key.min || v > key.max)
+        return false;
+    *out = static_cast<int>(v);
+    return true;
+}
+
+static bool parse_file(const std::string& file, std::vector<Section>* sections)
+{
+    std::ifstream in(file);
+    if (!in) {
+        if (errno == ENOENT) return true;
+        std::fprintf(stderr, "config: cannot read %s: %s\n", file.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    sections->push_back({});
+    std::string line;
+    for (int lineno = 1; std::getline(in, line); ++lineno) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        line = trim(line);
+        if (line.empty()) continue;
+
+        if (line.front() == '[') {
+            const std::string prefix = "[variant ";
+            std::string name;
+            if (line.back() == ']' && line.compare(0, prefix.size(), prefix) == 0)
+                name = trim(line.substr(prefix.size(), line.size() - prefix.size() - 1));
+            if (name.empty() || name == "control") {
+                std::fprintf(stderr, "config: %s:%d: expected [variant NAME]\n",
+                             file.c_str(), lineno);
+                name = "(invalid)";   // skip its entries rather than merge them elsewhere
+            }
+            sections->push_back({name, {}});
+            continue;
+        }
+
+        size_t eq = line.find('=');
+        if (eq == std::string::npos) {
+            std::fprintf(stderr, "config: %s:%d: expected key = value\n", file.c_str(), lineno);
+            continue;
+        }
+        std::string name  = trim(line.substr(0, eq));
+        std::string value = trim(line.substr(eq + 1));
+
+        const Key* key = nullptr;
+        for (const Key& k : KEYS)
+            if (name == k.name) key = &k;
+        if (!key) {
+            std::fprintf(stderr, "config: %s:%d: unknown key %s\n", file.c_str(), lineno, name.c_str());
+            continue;
+        }
+
+        Entry entry{key, 0, false};
+        if (!parse_value(*key, value, &entry.value)) {
+            std::fprintf(stderr, "config: %s:%d: %s must be %s in [%d, %d]\n",
+                         file.c_str(), lineno, key->name,
+                         key->names ? "a level name or an integer" : "an integer",
+                         key->min, key->max);
+            entry.keep = true;
+        }
+        sections->back().entries.push_back(entry);
+    }
+    return true;
+}
+
+// Defaults, then the base section, then the selected variant. Keys absent
+// from the file take their default; keys present but invalid keep the
+// value in effect, so a typo during a live edit does not silently reset a
+// tuned machine. Called with g_mutex held.
+static void apply_locked()
+{
+    const Tuning prev = g_tuning;
+    Tuning next;
+    for (const Section& section : g_sections) {
+        if (!section.name.empty() && section.name != g_variant) continue;
+        for (const Entry& e : section.entries)
+            next.*e.key->field = e.keep ? prev.*e.key->field : e.value;
+    }
+
+    // Constraints between keys
+    if (next.min_samples > next.commit_samples) {
+        std::fprintf(stderr, "config: min_samples exceeds commit_samples\n");
+        next.min_samples    = prev.min_samples;
+        next.commit_samples = prev.commit_samples;
+    }
+    if (next.threads_min > next.threads_max) {
+        std::fprintf(stderr, "config: threads_min exceeds threads_max\n");
+        next.threads_min = prev.threads_min;
+        next.threads_max = prev.threads_max;
+    }
+    g_tuning = next;
+}
+
+bool load()
+{
+    std::vector<Section> sections;
+    if (!parse_file(path(), &sections)) return false;
+
+    std::lock_guard<std::mutex> lk(g_mutex);
+    g_sections = std::move(sections);
+    apply_locked();
+    return true;
+}
+
+std::vector<std::string> variants()
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    std::vector<std::string> names;
+    for (const Section& section : g_sections)
+        if (!section.name.empty() && section.name != "(invalid)"
+            && std::find(names.begin(), names.end(), section.name) == names.end())
+            names.push_back(section.name);
+    return names;
+}
+
+void select_variant(const std::string& name)
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    g_variant = name == "control" ? std::string() : name;
+    apply_locked();
+}
+
+Tuning current()
+{
+    std::lock_guard<std::mutex> lk(g_mutex);
+    return g_tuning;
+}
+
+int inference_threads()
+{
+    Tuning t = current();
+    if (t.threads > 0) return t.threads;
+    int n = static_cast<int>(std::thread::hardware_concurrency());
+    return std::clamp(n, t.threads_min, t.threads_max);
+}
+
+// ---------------------------------------------------------------------------
+// Live reload: inotify on the directory rather than the file, so editors
+// and config management that replace the file by rename are seen too.
+// ---------------------------------------------------------------------------
+static void watch_loop()
+{
+    alignas(inotify_event) char buf[4096];
+    for (;;) {
+        pollfd fds[2] = {{g_inotify, POLLIN, 0}, {g_wake[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+
+        bool changed = false;
+        ssize_t n = read(g_inotify, buf, sizeof(buf));
+        for (ssize_t off = 0; off < n; ) {
+            const auto* ev = reinterpret_cast<const inotify_event*>(buf + off);
+            if (ev->len > 0 && std::strcmp(ev->name, "config") == 0) changed = true;
+            off += static_cast<ssize_t>(sizeof(inotify_event) + ev->len);
+        }
+        if (changed && load())
+            std::fprintf(stderr, "config: reloaded %s\n", path().c_str());
+    }
+}
+
+bool watch()
+{
+    if (g_watcher.joinable()) return true;
+
+    g_inotify = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (g_inotify < 0) {
+        std::fprintf(stderr, "config: inotify_init1 failed: %s\n", std::strerror(errno));
+        return false;
+    }
+    std::string dir = config_dir();
+    if (inotify_add_watch(g_inotify, dir.c_str(),
+                          IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE) < 0) {
+        if (errno != ENOENT)
+            std::fprintf(stderr, "config: cannot watch %s: %s\n", dir.c_str(), std::strerror(errno));
+        close(g_inotify);
+        g_inotify = -1;
+        return false;
+    }
+    if (pipe2(g_wake, O_CLOEXEC) != 0) {
+        std::fprintf(stderr, "config: pipe2 failed: %s\n", std::strerror(errno));
+        close(g_inotify);
+        g_inotify = -1;
+        return false;
+    }
+
+    g_watcher = std::thread(watch_loop);
+    return true;
+}
+
+void unwatch()
+{
+    if (g_watcher.joinable()) {
+        char c = 0;
+        (void)!write(g_wake[1], &c, 1);
+        g_watcher.join();
+    }
+    for (int* fd : {&g_inotify, &g_wake[0], &g_wake[1]}) {
+        if (*fd >= 0) close(*fd);
+        *fd = -1;
+    }
+}
+
+} // namespace config
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Runtime tuning from $XDG_CONFIG_HOME/live-whisper/config (by default
+// ~/.config/live-whisper/config): one `key = value` per line, `#` starts a
+// comment, `[variant NAME]` starts a section of overrides. The file is read
+// at startup and re-read whenever it is written or replaced, so a running
+// instance can be retuned without a rebuild or restart. Consumers take a
+// snapshot at the start of each pass or frame.
+namespace config {
+
+struct Tuning {
+    int initial_interval_ms = 300;          // first partial fires quickly
+    int stream_interval_ms  = 400;          // subsequent partials
+    int boundary_dip_ms     = 60;           // a dip this long after speech starts a pass
+                                            //   early (the intervals are a cap), 0 = off
+    int min_pass_gap_ms     = 150;          //   but no sooner than this after the last one
+    int min_samples         = 16000 / 4;    // need >= 0.25s of audio for a pass
+    int commit_samples      = 16000 * 25;   // commit chunk every 25s
+    int ring_buf_secs       = 60;           // capture ring buffer
+    int read_buf_size       = 16000 / 10;   // 100ms chunks into the transcriber
+    int overlay_height      = 350;          // logical pixels
+    int threads             = 0;            // inference threads, 0 = automatic:
+    int threads_min         = 4;            //   hardware threads clamped to
+    int threads_max         = 16;           //   [threads_min, threads_max]
+    int speech_threshold_db = -40;          // resume after an edit: speech is louder
+    int speech_over_floor   = 4;            //   than this and this many x the noise floor
+    int accuracy            = -1;           // model tier (ACCURACY_*), -1 = environment
+};
+
+enum { ACCURACY_FAST, ACCURACY_BALANCED, ACCURACY_EXACT };
+
+// Location of the config file.
+std::string path();
+
+// Read the config file. A missing file means defaults; malformed or out of
+// range entries are reported and keep the value currently in effect.
+// Returns false only if the file exists but cannot be read.
+bool load();
+
+// Variant sections, `[variant NAME]`, override keys of the base section for
+// A/B experiments (experiment.h). Names of the variants in the file.
+std::vector<std::string> variants();
+
+// Apply the named variant on top of the base values, now and after every
+// reload. "control" or an empty name selects the base values.
+void select_variant(const std::string& name);
+
+// Re-read the file on changes until unwatch(). Needs the config directory
+// to exist when called.
+bool watch();
+void unwatch();
+
+// The values currently in effect.
+Tuning current();
+
+// Inference thread count for the current tuning.
+int inference_threads();
+
+} // namespace config
@@ -0,0 +1,239 @@
+#include "delivery.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <set>
+#include <sstream>
+#include <sys/stat.h>
+#include <utility>
+
+static constexpr int    PROMOTE_AFTER = 2;     // successes before trying a faster method
+static constexpr double RATE_SMOOTH   = 0.7;   // weight of the previous rate estimate
+
+static const paste::Method ALL_METHODS[] = {
+    paste::Method::Clipboard, paste::Method::FastKeys, paste::Method::Keys,
+};
+
+struct MethodStats {
+    int    attempts      = 0;
+    int    failures      = 0;
+    double chars_per_sec = 0.0;
+
+    // One failure in the first few attempts is enough to rule a method out
+    bool bad() const    { return failures > 0 && failures * 4 > attempts; }
+    bool proven() const { return !bad() && attempts - failures >= PROMOTE_AFTER; }
+};
+
+struct DeliveryCache::Impl {
+    std::map<std::pair<std::string, std::string>, MethodStats> stats;  // (class, method)
+    std::set<std::pair<std::string, std::string>> allowed;  // (class, method) opted in
+    std::string last_class;
+    std::string last_method;
+
+    std::string path;
+
+    const MethodStats* find(const std::string& window_class, paste::Method m) const
+    {
+        auto it = stats.find({window_class, paste::method_name(m)});
+        return it == stats.end() ? nullptr : &it->second;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static std::string cache_dir()
+{
+    std::string base;
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME")) {
+        base = xdg;
+    } else if (const char* home = std::getenv("HOME")) {
+        base = std::string(home) + "/.cache";
+    }
+    if (base.empty()) return {};
+    return base + "/live-whisper";
+}
+
+// Window classes go into a tab-separated file; keep them to one field.
+static std::string class_key(const std::string& window_class)
+{
+    if (window_class.empty()) return "-";
+    std::string key = window_class;
+    for (char& c : key)
+        if (c == '\t' || c == '\n') c = ' ';
+    return key;
+}
+
+// ---------------------------------------------------------------------------
+// Public interface
+// ---------------------------------------------------------------------------
+
+DeliveryCache::DeliveryCache() : impl_(std::make_unique<Impl>())
+{
+    std::string dir = cache_dir();
+    if (!dir.empty()) impl_->path = dir + "/delivery.tsv";
+}
+
+DeliveryCache::~DeliveryCache() = default;
+
+bool DeliveryCache::load()
+{
+    if (impl_->path.empty()) return false;
+    std::ifstream in(impl_->path);
+    if (!in) return false;
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') continue;
+
+        std::istringstream fields(line);
+        std::string cls, method;
+        if (!std::getline(fields, cls, '\t') || !std::getline(fields, method, '\t'))
+            continue;
+
+        if (cls == "@last") {
+            // "@last <class> <method>": the delivery --paste-failed refers to
+            impl_->last_class  = method;
+            std::getline(fields, impl_->last_method, '\t');
+            continue;
+        }
+        if (cls == "@allow") {
+            // "@allow <class> <method>": the user confirmed the method works there
+            std::string allowed;
+            if (std::getline(fields, allowed, '\t')) impl_->allowed.insert({method, allowed});
+            continue;
+        }
+
+        MethodStats st;
+        fields >> st.attempts >> st.failures >> st.chars_per_sec;
+        if (fields.fail()) continue;
+        impl_->stats[{cls, method}] = st;
+    }
+    return true;
+}
+
+bool DeliveryCache::save() const
+{
+    if (impl_->path.empty()) return false;
+
+    std::string dir = cache_dir();
+    std::string parent = dir.substr(0, dir.rfind('/'));
+    mkdir(parent.c_str(), 0755);
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::fprintf(stderr, "delivery: cannot create %s: %s\n",
+                     dir.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    // Write a temp file and rename so concurrent runs never see half a file
+    std::string tmp = impl_->path + ".tmp";
+    FILE* f = std::fopen(tmp.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "delivery: cannot write %s: %s\n",
+                     tmp.c_str(), std::strerror(errno));
+        return false;
+    }
+    std::fprintf(f, "# class\tmethod\tattempts\tfailures\tchars/s\n");
+    for (const auto& [key, st] : impl_->stats)
+        std::fprintf(f, "%s\t%s\t%d\t%d\t%.1f\n", key.first.c_str(), key.second.c_str(),
+                     st.attempts, st.failures, st.chars_per_sec);
+    for (const auto& [cls, method] : impl_->allowed)
+        std::fprintf(f, "@allow\t%s\t%s\n", cls.c_str(), method.c_str());
+    if (!impl_->last_class.empty())
+        std::fprintf(f, "@last\t%s\t%s\n", impl_->last_class.c_str(),
+                     impl_->last_method.c_str());
+    std::fclose(f);
+
+    return std::rename(tmp.c_str(), impl_->path.c_str()) == 0;
+}
+
+paste::Method DeliveryCache::choose(const std::string& window_class) const
+{
+    std::string key = class_key(window_class);
+
+    // Sent keys or a sent paste shortcut are no evidence the text arrived:
+    // apps may drop keys that come too fast, or not paste on the shortcut.
+    // Faster methods need a class known to take them, or an opt-in.
+    auto allowed = [&](paste::Method m) {
+        if (impl_->allowed.count({key, paste::method_name(m)})) return true;
+        switch (m) {
+        case paste::Method::Clipboard: return paste::paste_shortcut_known(window_class);
+        case paste::Method::FastKeys:  return paste::fast_keys_known(window_class);
+        case paste::Method::Keys:      return true;
+        }
+        return false;
+    };
+
+    // Climb from plain typing towards allowed faster methods while each step
+    // has proven itself, stopping below any method known to fail here.
+    paste::Method current = paste::Method::Keys;
+    for (int i = static_cast<int>(std::size(ALL_METHODS)) - 2; i >= 0; --i) {
+        if (!allowed(ALL_METHODS[i])) continue;
+        const MethodStats* cur = impl_->find(key, current);
+        const MethodStats* next = impl_->find(key, ALL_METHODS[i]);
+        if (next && next->bad()) break;
+        if (!cur || !cur->proven()) break;
+        current = ALL_METHODS[i];
+    }
+
+    // Among methods that work, prefer the one measured fastest. The fixed
+    // order above is only a guess for text of typical length.
+    const MethodStats* best = impl_->find(key, current);
+    for (paste::Method m : ALL_METHODS) {
+        if (!allowed(m)) continue;
+        const MethodStats* st = impl_->find(key, m);
+        if (st && st->proven() && best && best->proven()
+            && st->chars_per_sec > best->chars_per_sec) {
+            best = st;
+            current = m;
+        }
+    }
+    return current;
+}
+
+void DeliveryCache::record(const std::string& window_class, paste::Method method,
+                           bool ok, double chars_per_sec)
+{
+    std::string key = class_key(window_class);
+    MethodStats& st = impl_->stats[{key, paste::method_name(method)}];
+
+    ++st.attempts;
+    if (!ok) {
+        ++st.failures;
+    } else if (st.chars_per_sec <= 0.0) {
+        st.chars_per_sec = chars_per_sec;
+    } else {
+        st.chars_per_sec = RATE_SMOOTH * st.chars_per_sec + (1.0 - RATE_SMOOTH) * chars_per_sec;
+    }
+
+    impl_->last_class  = key;
+    impl_->last_method = paste::method_name(method);
+}
+
+bool DeliveryCache::mark_last_failed()
+{
+    if (impl_->last_class.empty()) return false;
+    auto it = impl_->stats.find({impl_->last_class, impl_->last_method});
+    if (it == impl_->stats.end()) return false;
+
+    ++it->second.failures;
+    std::fprintf(stderr, "delivery: marked %s via %s as failed\n",
+                 impl_->last_class.c_str(), impl_->last_method.c_str());
+    impl_->last_class.clear();   // only once per delivery
+    impl_->last_method.clear();
+    return true;
+}
+
+bool DeliveryCache::allow_last(paste::Method method)
+{
+    if (impl_->last_class.empty()) return false;
+    impl_->allowed.insert({impl_->last_class, paste::method_name(method)});
+    std::fprintf(stderr, "delivery: %s allowed for %s\n", paste::method_name(method),
+                 impl_->last_class.c_str());
+    return true;
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "paste.h"
+
+#include <memory>
+#include <string>
+
+// Per-window-class record of how each paste method fared, persisted in
+// $XDG_CACHE_HOME/live-whisper/delivery.tsv. New classes start with plain
+// typing; once a method has worked a few times the next faster one is
+// tried. A method failing more than a quarter of its attempts for a class
+// is no longer chosen for it. "Worked" only means the keys were sent, which
+// says nothing about dropped keys or an ignored paste, so a faster method is
+// only tried for a class known to take it (paste::fast_keys_known,
+// paste::paste_shortcut_known) or that the user opted in.
+struct DeliveryCache {
+    DeliveryCache();
+    ~DeliveryCache();
+
+    DeliveryCache(const DeliveryCache&) = delete;
+    DeliveryCache& operator=(const DeliveryCache&) = delete;
+
+    bool load();
+    bool save() const;
+
+    // Method to start with for a window class.
+    paste::Method choose(const std::string& window_class) const;
+
+    // Record one delivery attempt and its throughput.
+    void record(const std::string& window_class, paste::Method method,
+                bool ok, double chars_per_sec);
+
+    // Count the most recent delivery as failed — for when it completed but
+    // the text did not arrive intact (dropped keys, paste ignored).
+    bool mark_last_failed();
+
+    // Allow a faster method (FastKeys or Clipboard) for the class of the
+    // most recent delivery.
+    bool allow_last(paste::Method method);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
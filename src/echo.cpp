@@ -0,0 +1,318 @@
+#include "echo.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+static constexpr int   BLOCK      = 128;          // 8 ms at 16 kHz
+static constexpr int   FFT_SIZE   = 2 * BLOCK;    // overlap-save
+static constexpr int   BINS       = FFT_SIZE;     // full complex spectrum
+static constexpr int   PARTITIONS = 32;           // 256 ms echo tail
+static constexpr float STEP       = 0.5f;         // NLMS step size, the most any bin takes
+static constexpr float POWER_SMOOTH = 0.9f;
+static constexpr float REGULARIZE = BINS * 1e-4f; // ~ -40 dBFS far-end floor per bin
+
+// Double talk: near-end speech in the error must not be learned as echo.
+// Rather than a detector with a threshold on the echo path, the step of
+// each bin is scaled by the residual echo's share of the error (Valin,
+// "On adjusting the learning rate in frequency domain echo cancellation with
+// double-talk", 2007). The residual echo is estimated from the leak: how
+// much of the echo estimate's power fluctuation still shows in the error,
+// i.e. the coherence of the two. Near-end speech raises the error without
+// raising that, so adaptation slows while someone talks over the far end
+// and speeds up again on its own, with no detector threshold to lock up on
+// a loud path. Until the filter has seen ADAPT_BLOCKS of far-end audio there is no
+// estimate to go on and the full step applies.
+static constexpr float SPEC_AVERAGE = 0.35f;        // per-bin power means for the leak
+static constexpr float LEAK_BETA0   = 0.016f;       // leak smoothing, scaled by echo power
+static constexpr float LEAK_BETA_MAX = LEAK_BETA0 / 4.0f;
+static constexpr float MIN_LEAK     = 0.005f;
+static constexpr float MAX_RER      = 0.5f;         // residual-to-error ratio cap
+static constexpr float FAR_ACTIVE   = 1e-6f;        // far-end block power that can echo
+static constexpr int   ADAPT_BLOCKS = 2 * PARTITIONS;
+
+// ---------------------------------------------------------------------------
+// Radix-2 complex FFT on split real/imaginary arrays. Split (SoA) layout
+// keeps the per-bin loops below unit-stride so the compiler vectorizes them
+// (SSE/AVX on x86, NEON on ARM) without intrinsics.
+// ---------------------------------------------------------------------------
+struct Fft {
+    std::vector<float> cos_tw, sin_tw;
+    std::vector<int>   bitrev;
+
+    Fft()
+    {
+        cos_tw.resize(FFT_SIZE / 2);
+        sin_tw.resize(FFT_SIZE / 2);
+        for (int i = 0; i < FFT_SIZE / 2; ++i) {
+            double a = -2.0 * M_PI * i / FFT_SIZE;
+            cos_tw[i] = static_cast<float>(std::cos(a));
+            sin_tw[i] = static_cast<float>(std::sin(a));
+        }
+        int bits = 0;
+        while ((1 << bits) < FFT_SIZE) ++bits;
+        bitrev.resize(FFT_SIZE);
+        for (int i = 0; i < FFT_SIZE; ++i) {
+            int r = 0;
+            for (int b = 0; b < bits; ++b)
+                if (i & (1 << b)) r |= 1 << (bits - 1 - b);
+            bitrev[i] = r;
+        }
+    }
+
+    // In place; inverse includes the 1/N scale.
+    void run(float* re, float* im, bool inverse) const
+    {
+        for (int i = 0; i < FFT_SIZE; ++i) {
+            int j = bitrev[i];
+            if (j > i) {
+                std::swap(re[i], re[j]);
+                std::swap(im[i], im[j]);
+            }
+        }
+        float sign = inverse ? -1.0f : 1.0f;
+        for (int len = 2; len <= FFT_SIZE; len <<= 1) {
+            int half = len / 2;
+            int step = FFT_SIZE / len;
+            for (int start = 0; start < FFT_SIZE; start += len) {
+                for (int k = 0; k < half; ++k) {
+                    float wr = cos_tw[k * step];
+                    float wi = sign * sin_tw[k * step];
+                    int a = start + k, b = a + half;
+                    float tr = re[b] * wr - im[b] * wi;
+                    float ti = re[b] * wi + im[b] * wr;
+                    re[b] = re[a] - tr;
+                    im[b] = im[a] - ti;
+                    re[a] += tr;
+                    im[a] += ti;
+                }
+            }
+        }
+        if (inverse) {
+            float s = 1.0f / FFT_SIZE;
+            for (int i = 0; i < FFT_SIZE; ++i) {
+                re[i] *= s;
+                im[i] *= s;
+            }
+        }
+    }
+};
+
+struct EchoCanceller::Impl {
+    Fft fft;
+
+    // Far-end spectra of the last PARTITIONS blocks (ring, newest at head)
+    // and one filter partition per delay, all split re/im.
+    std::vector<float> x_re, x_im;   // [PARTITIONS][BINS]
+    std::vector<float> w_re, w_im;   // [PARTITIONS][BINS]
+    std::vector<float> power;        // smoothed far-end power per bin
+    std::vector<float> err_mean, echo_mean;   // per-bin error / echo estimate power
+    float leak_ey = 0.0f, leak_yy = 0.0f;     // smoothed covariance, echo variance
+    int   far_blocks = 0;            // far-end blocks seen, up to ADAPT_BLOCKS
+    float step_scale = 1.0f;         // last block's mean step over STEP
+    int head = 0;
+    int constrain_next = 0;          // partition to constrain this block
+
+    std::vector<float> ref_prev;     // previous far-end block (overlap)
+    std::vector<float> mic_block, ref_block;
+    int fill = 0;
+
+    std::vector<float> out_block;    // last processed block, drained by process()
+
+    // Scratch
+    std::vector<float> a_re, a_im, b_re, b_im, c_re, c_im;
+    std::vector<float> err_pow, echo_pow;
+
+    Impl()
+    {
+        x_re.assign(PARTITIONS * BINS, 0.0f);
+        x_im.assign(PARTITIONS * BINS, 0.0f);
+        w_re.assign(PARTITIONS * BINS, 0.0f);
+        w_im.assign(PARTITIONS * BINS, 0.0f);
+        power.assign(BINS, 0.0f);
+        err_mean.assign(BINS, 0.0f);
+        echo_mean.assign(BINS, 0.0f);
+        ref_prev.assign(BLOCK, 0.0f);
+        mic_block.assign(BLOCK, 0.0f);
+        ref_block.assign(BLOCK, 0.0f);
+        out_block.assign(BLOCK, 0.0f);
+        a_re.resize(BINS); a_im.resize(BINS);
+        b_re.resize(BINS); b_im.resize(BINS);
+        c_re.resize(BINS); c_im.resize(BINS);
+        err_pow.resize(BINS); echo_pow.resize(BINS);
+    }
+
+    void process_block();
+    void step_sizes(float far_power);
+};
+
+// ---------------------------------------------------------------------------
+// One overlap-save block: predict echo from the partitioned filter, subtract
+// it, then adapt every partition with the normalized error spectrum, each
+// bin's step scaled down by the near-end share of the error.
+// ---------------------------------------------------------------------------
+void EchoCanceller::Impl::process_block()
+{
+    // Far-end spectrum of [previous block, current block]
+    head = (head + PARTITIONS - 1) % PARTITIONS;
+    float* xr = &x_re[head * BINS];
+    float* xi = &x_im[head * BINS];
+    std::copy(ref_prev.begin(), ref_prev.end(), xr);
+    std::copy(ref_block.begin(), ref_block.end(), xr + BLOCK);
+    std::fill(xi, xi + BINS, 0.0f);
+    fft.run(xr, xi, false);
+    ref_prev = ref_block;
+
+    float far_power = 0.0f;
+    for (int k = 0; k < BINS; ++k) {
+        float p = xr[k] * xr[k] + xi[k] * xi[k];
+        power[k] = POWER_SMOOTH * power[k] + (1.0f - POWER_SMOOTH) * p;
+        far_power += p;
+    }
+
+    // Echo estimate Y = sum_p W_p * X_{k-p}
+    float* __restrict yr = a_re.data();
+    float* __restrict yi = a_im.data();
+    std::fill(yr, yr + BINS, 0.0f);
+    std::fill(yi, yi + BINS, 0.0f);
+    for (int p = 0; p < PARTITIONS; ++p) {
+        const float* __restrict pr = &x_re[((head + p) % PARTITIONS) * BINS];
+        const float* __restrict pi = &x_im[((head + p) % PARTITIONS) * BINS];
+        const float* __restrict wr = &w_re[p * BINS];
+        const float* __restrict wi = &w_im[p * BINS];
+        for (int k = 0; k < BINS; ++k) {
+            yr[k] += wr[k] * pr[k] - wi[k] * pi[k];
+            yi[k] += wr[k] * pi[k] + wi[k] * pr[k];
+        }
+    }
+    fft.run(yr, yi, true);
+
+    // Error e = d - y over the valid (second) half
+    for (int i = 0; i < BLOCK; ++i)
+        out_block[i] = mic_block[i] - yr[BLOCK + i];
+
+    // Spectra of the valid halves of e and y, zero-padded alike
+    float* __restrict er = b_re.data();
+    float* __restrict ei = b_im.data();
+    std::fill(er, er + BLOCK, 0.0f);
+    std::copy(out_block.begin(), out_block.end(), er + BLOCK);
+    std::fill(ei, ei + BINS, 0.0f);
+    fft.run(er, ei, false);
+
+    float* __restrict vr = c_re.data();
+    float* __restrict vi = c_im.data();
+    std::fill(vr, vr + BLOCK, 0.0f);
+    std::copy(yr + BLOCK, yr + BINS, vr + BLOCK);
+    std::fill(vi, vi + BINS, 0.0f);
+    fft.run(vr, vi, false);
+    for (int k = 0; k < BINS; ++k) {
+        err_pow[k]  = er[k] * er[k] + ei[k] * ei[k];
+        echo_pow[k] = vr[k] * vr[k] + vi[k] * vi[k];
+    }
+
+    // Normalized error spectrum mu E / (P + eps)
+    step_sizes(far_power);
+    for (int k = 0; k < BINS; ++k) {
+        float g = err_pow[k] / (PARTITIONS * power[k] + REGULARIZE);   // err_pow now holds mu
+        er[k] *= g;
+        ei[k] *= g;
+    }
+
+    // W_p += conj(X_{k-p}) * E
+    for (int p = 0; p < PARTITIONS; ++p) {
+        const float* __restrict pr = &x_re[((head + p) % PARTITIONS) * BINS];
+        const float* __restrict pi = &x_im[((head + p) % PARTITIONS) * BINS];
+        float* __restrict wr = &w_re[p * BINS];
+        float* __restrict wi = &w_im[p * BINS];
+        for (int k = 0; k < BINS; ++k) {
+            wr[k] += pr[k] * er[k] + pi[k] * ei[k];
+            wi[k] += pr[k] * ei[k] - pi[k] * er[k];
+        }
+    }
+
+    // Gradient constraint (zero the circular-wrap half of the impulse
+    // response) on one partition per block keeps the cost at two extra FFTs.
+    float* wr = &w_re[constrain_next * BINS];
+    float* wi = &w_im[constrain_next * BINS];
+    fft.run(wr, wi, true);
+    std::fill(wr + BLOCK, wr + BINS, 0.0f);
+    std::fill(wi, wi + BINS, 0.0f);
+    fft.run(wr, wi, false);
+    constrain_next = (constrain_next + 1) % PARTITIONS;
+}
+
+// ---------------------------------------------------------------------------
+// Per-bin step sizes from the leak estimate, written over err_pow.
+// ---------------------------------------------------------------------------
+void EchoCanceller::Impl::step_sizes(float far_power)
+{
+    float see = 0.0f, syy = 0.0f, pey = 0.0f, pyy = 0.0f;
+    for (int k = 0; k < BINS; ++k) {
+        float de = err_pow[k] - err_mean[k];
+        float dy = echo_pow[k] - echo_mean[k];
+        see += err_pow[k];
+        syy += echo_pow[k];
+        pey += de * dy;
+        pyy += dy * dy;
+        err_mean[k]  += SPEC_AVERAGE * (err_pow[k] - err_mean[k]);
+        echo_mean[k] += SPEC_AVERAGE * (echo_pow[k] - echo_mean[k]);
+    }
+    pyy = std::sqrt(pyy);
+    if (pyy > 0.0f) pey /= pyy;
+
+    // Smooth faster the more of the error the echo estimate explains
+    if (see > 0.0f) {
+        float alpha = std::min(LEAK_BETA0 * syy, LEAK_BETA_MAX * see) / see;
+        leak_ey += alpha * (pey - leak_ey);
+        leak_yy += alpha * (pyy - leak_yy);
+    }
+    float leak = leak_yy > 0.0f ? std::clamp(leak_ey / leak_yy, MIN_LEAK, 1.0f) : 1.0f;
+
+    if (far_blocks < ADAPT_BLOCKS) {
+        if (far_power > FAR_ACTIVE * BINS) ++far_blocks;
+        std::fill(err_pow.begin(), err_pow.end(), STEP);
+        return;
+    }
+
+    // Residual echo over error, overall and per bin
+    float rer = see > 0.0f ? std::min(MAX_RER, 3.0f * leak * syy / see) : MAX_RER;
+    float sum = 0.0f;
+    for (int k = 0; k < BINS; ++k) {
+        float e = err_pow[k] + 1e-10f;
+        float r = std::min(leak * echo_pow[k], 0.5f * e);
+        r = 0.7f * r + 0.3f * rer * e;
+        err_pow[k] = STEP * std::min(1.0f, 2.0f * r / e);
+        sum += err_pow[k];
+    }
+    step_scale = sum / (BINS * STEP);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+EchoCanceller::EchoCanceller() : impl_(std::make_unique<Impl>()) {}
+EchoCanceller::~EchoCanceller() = default;
+
+void EchoCanceller::process(const float* mic, const float* ref, float* out, uint32_t n)
+{
+    Impl& s = *impl_;
+    for (uint32_t i = 0; i < n; ++i) {
+        s.mic_block[s.fill] = mic[i];
+        s.ref_block[s.fill] = ref[i];
+        out[i] = s.out_block[s.fill];   // previous block's output, one block behind
+        if (++s.fill == BLOCK) {
+            s.process_block();
+            s.fill = 0;
+        }
+    }
+}
+
+float EchoCanceller::step_scale() const
+{
+    return impl_->step_scale;
+}
+
+void EchoCanceller::reset()
+{
+    impl_ = std::make_unique<Impl>();
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+
+// Acoustic echo canceller: partitioned-block frequency-domain NLMS. Learns
+// the path from a far-end reference (what the speakers play) to the
+// microphone and subtracts the predicted echo, adapting more slowly while
+// the near end talks over it. Output lags input by one block (8 ms at
+// 16 kHz).
+struct EchoCanceller {
+    EchoCanceller();
+    ~EchoCanceller();
+
+    EchoCanceller(const EchoCanceller&) = delete;
+    EchoCanceller& operator=(const EchoCanceller&) = delete;
+
+    // Process n samples. mic and ref are time-aligned; out receives n
+    // echo-cancelled samples (may alias mic).
+    void process(const float* mic, const float* ref, float* out, uint32_t n);
+
+    // Mean adaptation step of the last block relative to the full step:
+    // 1 while converging, lower while the near end talks
+    float step_scale() const;
+
+    void reset();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -0,0 +1,161 @@
+#include "experiment.h"
+#include "config.h"
+#include "metrics.h"
+#include "results.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+namespace experiment {
+
+struct Session {
+    bool        active = false;
+    std::string id;
+    std::string variant;
+    int64_t     start_unix_ms = 0;
+    double      start_cpu_s   = 0.0;
+    uint64_t    start_passes  = 0;
+    uint64_t    start_pass_us = 0;
+};
+
+static Session g_session;
+
+static std::string state_dir()
+{
+    std::string base;
+    if (const char* xdg = std::getenv("XDG_STATE_HOME")) {
+        base = xdg;
+    } else if (const char* home = std::getenv("HOME")) {
+        base = std::string(home) + "/.local/state";
+    }
+    if (base.empty()) return {};
+    return base + "/live-whisper";
+}
+
+std::string log_path()
+{
+    std::string dir = state_dir();
+    return dir.empty() ? std::string() : dir + "/sessions.jsonl";
+}
+
+static double process_cpu_s()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// FNV-1a: stable across builds and platforms, unlike std::hash
+static uint64_t fnv1a(const std::string& s)
+{
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+// Machine id prefix plus start time: unique per session, and the assignment
+// can be recomputed from the logged id.
+static std::string make_session_id(int64_t unix_ms)
+{
+    std::string machine;
+    std::ifstream("/etc/machine-id") >> machine;
+    if (machine.size() > 8) machine.resize(8);
+    if (machine.empty()) machine = "local";
+    return machine + "-" + std::to_string(unix_ms);
+}
+
+std::string begin(const std::string& forced_variant)
+{
+    std::vector<std::string> arms = {"control"};
+    for (const std::string& name : config::variants()) arms.push_back(name);
+
+    g_session = {};
+    g_session.start_unix_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    g_session.id = make_session_id(g_session.start_unix_ms);
+
+    if (!forced_variant.empty()) {
+        bool known = false;
+        for (const std::string& arm : arms) known = known || arm == forced_variant;
+        if (!known)
+            std::fprintf(stderr, "experiment: no variant %s in %s, running control\n",
+                         forced_variant.c_str(), config::path().c_str());
+        g_session.variant = known ? forced_variant : "control";
+    } else {
+        g_session.variant = arms[fnv1a(g_session.id) % arms.size()];
+    }
+    g_session.active = !forced_variant.empty() || arms.size() > 1;
+    if (!g_session.active) return g_session.variant;
+
+    config::select_variant(g_session.variant);
+    metrics::set_label("variant", g_session.variant);
+
+    metrics::Histogram* passes = metrics::histogram("pass_ms");
+    g_session.start_cpu_s   = process_cpu_s();
+    g_session.start_passes  = passes->count.load();
+    g_session.start_pass_us = passes->sum_micro.load();
+    return g_session.variant;
+}
+
+void finish(const Outcome& outcome, double audio_seconds)
+{
+    if (!g_session.active) return;
+    g_session.active = false;
+
+    std::string path = log_path();
+    if (path.empty()) return;
+    std::string dir = state_dir();
+    std::string parent = dir.substr(0, dir.rfind('/'));
+    mkdir(parent.c_str(), 0755);
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::fprintf(stderr, "experiment: cannot create %s: %s\n", dir.c_str(), std::strerror(errno));
+        return;
+    }
+
+    metrics::Histogram* hist = metrics::histogram("pass_ms");
+    uint64_t passes  = hist->count.load() - g_session.start_passes;
+    double   pass_ms = passes
+        ? (hist->sum_micro.load() - g_session.start_pass_us) / 1e6 / passes : 0.0;
+
+    std::string session, variant;
+    append_json_string(session, g_session.id);
+    append_json_string(variant, g_session.variant);
+
+    // One write() per line in append mode, so concurrent sessions interleave
+    // whole records
+    char line[1024];
+    int n = std::snprintf(line, sizeof(line),
+        "{\"session\":%s,\"variant\":%s,\"time\":%lld,\"audio_s\":%.2f,"
+        "\"first_partial_ms\":%.1f,\"passes\":%llu,\"pass_ms\":%.2f,\"cpu_s\":%.3f,"
+        "\"edits\":%d,\"redecodes\":%d,\"words\":%zu,\"accepted\":%s,\"accept_ms\":%.1f}\n",
+        session.c_str(), variant.c_str(),
+        static_cast<long long>(g_session.start_unix_ms / 1000), audio_seconds,
+        outcome.first_partial_ms, static_cast<unsigned long long>(passes), pass_ms,
+        process_cpu_s() - g_session.start_cpu_s,
+        outcome.edits, outcome.redecodes, outcome.words,
+        outcome.accepted ? "true" : "false", outcome.accept_ms);
+    if (n <= 0 || n >= static_cast<int>(sizeof(line))) return;
+
+    FILE* f = std::fopen(path.c_str(), "a");
+    if (!f) {
+        std::fprintf(stderr, "experiment: cannot write %s: %s\n", path.c_str(), std::strerror(errno));
+        return;
+    }
+    std::setvbuf(f, nullptr, _IOFBF, sizeof(line));
+    std::fputs(line, f);
+    std::fclose(f);
+}
+
+} // namespace experiment
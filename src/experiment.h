@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+// A/B experiments over tuning variants.
+//
+// The arms are "control" (the base config) and every `[variant NAME]`
+// section of the config file (config.h). Each session gets one arm,
+// derived from a hash of its session id, so the assignment can be
+// reproduced from the log. The variant labels the live metrics, and at
+// exit one JSON line per session is appended to
+// $XDG_STATE_HOME/live-whisper/sessions.jsonl for live-whisper-ab:
+//
+//   {"session","variant","time","audio_s","first_partial_ms","passes",
+//    "pass_ms","cpu_s","edits","redecodes","words","accepted","accept_ms"}
+//
+// Without variants in the config and without a forced variant nothing is
+// logged.
+namespace experiment {
+
+// Measured by the event loop over one session.
+struct Outcome {
+    double first_partial_ms = -1.0;   // start to first non-empty result; -1 if none
+    int    edits     = 0;             // frames in which the user changed the text
+    int    redecodes = 0;             // Ctrl+R re-decodes
+    size_t words     = 0;             // in the text on exit
+    bool   accepted  = false;
+    double accept_ms = -1.0;          // Enter to the first delivered key; -1 if none
+};
+
+// Start a session: pick its variant (forced, or by hash over the arms),
+// apply it to the config and label the metrics. Returns the variant name.
+std::string begin(const std::string& forced_variant);
+
+// Append the session's record, with pass and CPU figures taken since
+// begin(). No-op when no experiment is running.
+void finish(const Outcome& outcome, double audio_seconds);
+
+// Default log location.
+std::string log_path();
+
+} // namespace experiment
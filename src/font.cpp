@@ -1,5 +1,431 @@
 #include "font.h"
+#include "gl_program.h"
 #include "gen_font.cpp"
+#include "gen_sdf_font.cpp"
+
+#include "imgui_internal.h"
+
+// Private copy for fallback fonts in SDF mode; imgui_draw.cpp keeps its own
+// static.
+#define STB_TRUETYPE_IMPLEMENTATION
+#define STBTT_STATIC
+#include "imstb_truetype.h"
+
+#include <GLES3/gl3.h>
+
+#include <cctype>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+
+static constexpr int MAX_CACHED_GLYPHS = 2048;  // per baked font, once fallbacks are in use
+
+static float g_font_size = 0.0f;  // SizePixels of the default font
+
+// ---------------------------------------------------------------------------
+// SDF glyph loader — serves glyphs from the generated atlas instead of
+// rasterising the TTF. Glyph quads are scaled by baked size / SDF size.
+// ---------------------------------------------------------------------------
+static const SdfGlyph* find_sdf_glyph(ImWchar codepoint)
+{
+    int lo = 0, hi = sdf_font_glyph_count - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (sdf_font_glyphs[mid].codepoint == codepoint) return &sdf_font_glyphs[mid];
+        if (sdf_font_glyphs[mid].codepoint < codepoint) lo = mid + 1;
+        else hi = mid - 1;
+    }
+    return nullptr;
+}
+
+static bool sdf_contains_glyph(ImFontAtlas*, ImFontConfig*, ImWchar codepoint)
+{
+    return find_sdf_glyph(codepoint) != nullptr;
+}
+
+static bool sdf_baked_init(ImFontAtlas*, ImFontConfig* src, ImFontBaked* baked, void*)
+{
+    if (!src->MergeMode) {
+        float k = baked->Size / sdf_font_size;
+        baked->Ascent  = ImCeil(sdf_font_ascent * k);
+        baked->Descent = ImFloor(sdf_font_descent * k);
+    }
+    return true;
+}
+
+// Pack a w x h field generated at sdf_font_size into the atlas as the glyph's
+// bitmap, with its quad scaled to the baked size.
+static bool set_sdf_glyph_bitmap(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked,
+                                 ImFontGlyph* out_glyph, const unsigned char* pixels, int pitch,
+                                 int w, int h, float xoff, float yoff)
+{
+    ImFontAtlasRectId pack_id = ImFontAtlasPackAddRect(atlas, w, h);
+    if (pack_id == ImFontAtlasRectId_Invalid) {
+        IM_ASSERT(pack_id != ImFontAtlasRectId_Invalid && "Out of texture memory.");
+        return false;
+    }
+    ImTextureRect* r = ImFontAtlasPackGetRect(atlas, pack_id);
+
+    float k = baked->Size / sdf_font_size;
+    float off_y = ImRound(baked->Ascent);
+    out_glyph->X0      = xoff * k;
+    out_glyph->Y0      = yoff * k + off_y;
+    out_glyph->X1      = (xoff + w) * k;
+    out_glyph->Y1      = (yoff + h) * k + off_y;
+    out_glyph->Visible = true;
+    out_glyph->PackId  = pack_id;
+
+    ImFontAtlasBakedSetFontGlyphBitmap(atlas, baked, src, out_glyph, r, pixels,
+                                       ImTextureFormat_Alpha8, pitch);
+    return true;
+}
+
+static bool sdf_load_glyph(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void*,
+                           ImWchar codepoint, ImFontGlyph* out_glyph, float* out_advance_x)
+{
+    const SdfGlyph* g = find_sdf_glyph(codepoint);
+    if (!g) return false;
+
+    float k = baked->Size / sdf_font_size;
+    if (out_advance_x) {
+        *out_advance_x = g->advance * k;
+        return true;
+    }
+
+    out_glyph->Codepoint = codepoint;
+    out_glyph->AdvanceX  = g->advance * k;
+    if (g->w == 0 || g->h == 0) return true;
+
+    const unsigned char* pixels = sdf_atlas_pixels + g->y * sdf_atlas_width + g->x;
+    return set_sdf_glyph_bitmap(atlas, src, baked, out_glyph, pixels, sdf_atlas_width,
+                                g->w, g->h, g->xoff, g->yoff);
+}
+
+static ImFontLoader make_sdf_loader()
+{
+    ImFontLoader loader;
+    loader.Name                 = "live_whisper_sdf";
+    loader.FontSrcContainsGlyph = sdf_contains_glyph;
+    loader.FontBakedInit        = sdf_baked_init;
+    loader.FontBakedLoadGlyph   = sdf_load_glyph;
+    return loader;
+}
+
+static const ImFontLoader g_sdf_loader = make_sdf_loader();
+
+// ---------------------------------------------------------------------------
+// SDF TTF loader — merged fallback sources in SDF mode. Generates each glyph's
+// field from the TTF when it is first drawn, with the generator's parameters,
+// so fallback glyphs go through the same shader as the built-in atlas.
+// ---------------------------------------------------------------------------
+struct SdfTtfSource {
+    stbtt_fontinfo info;
+    float          scale = 0.0f;  // font units -> sdf_font_size pixels
+};
+
+static bool sdf_ttf_src_init(ImFontAtlas*, ImFontConfig* src)
+{
+    const unsigned char* data = static_cast<const unsigned char*>(src->FontData);
+    int offset = stbtt_GetFontOffsetForIndex(data, static_cast<int>(src->FontNo));
+    auto* s = new SdfTtfSource;
+    if (offset < 0 || !stbtt_InitFont(&s->info, data, offset)) {
+        delete s;
+        return false;
+    }
+    s->scale = stbtt_ScaleForPixelHeight(&s->info, sdf_font_size);
+    src->FontLoaderData = s;
+    return true;
+}
+
+static void sdf_ttf_src_destroy(ImFontAtlas*, ImFontConfig* src)
+{
+    delete static_cast<SdfTtfSource*>(src->FontLoaderData);
+    src->FontLoaderData = nullptr;
+}
+
+static bool sdf_ttf_contains_glyph(ImFontAtlas*, ImFontConfig* src, ImWchar codepoint)
+{
+    auto* s = static_cast<SdfTtfSource*>(src->FontLoaderData);
+    return stbtt_FindGlyphIndex(&s->info, codepoint) != 0;
+}
+
+static bool sdf_ttf_load_glyph(ImFontAtlas* atlas, ImFontConfig* src, ImFontBaked* baked, void*,
+                               ImWchar codepoint, ImFontGlyph* out_glyph, float* out_advance_x)
+{
+    auto* s = static_cast<SdfTtfSource*>(src->FontLoaderData);
+    int index = stbtt_FindGlyphIndex(&s->info, codepoint);
+    if (index == 0) return false;
+
+    int advance = 0, lsb = 0;
+    stbtt_GetGlyphHMetrics(&s->info, index, &advance, &lsb);
+    float k = baked->Size / sdf_font_size;
+    if (out_advance_x) {
+        *out_advance_x = advance * s->scale * k;
+        return true;
+    }
+
+    out_glyph->Codepoint = codepoint;
+    out_glyph->AdvanceX  = advance * s->scale * k;
+
+    int w = 0, h = 0, xoff = 0, yoff = 0;
+    unsigned char* pixels = stbtt_GetGlyphSDF(&s->info, s->scale, index, sdf_font_padding,
+                                              sdf_font_on_edge,
+                                              static_cast<float>(sdf_font_on_edge) / sdf_font_padding,
+                                              &w, &h, &xoff, &yoff);
+    if (!pixels) return true;  // blank glyph
+    bool ok = set_sdf_glyph_bitmap(atlas, src, baked, out_glyph, pixels, w, w, h,
+                                   static_cast<float>(xoff), static_cast<float>(yoff));
+    stbtt_FreeSDF(pixels, nullptr);
+    return ok;
+}
+
+static ImFontLoader make_sdf_ttf_loader()
+{
+    ImFontLoader loader;
+    loader.Name                 = "live_whisper_sdf_ttf";
+    loader.FontSrcInit          = sdf_ttf_src_init;
+    loader.FontSrcDestroy       = sdf_ttf_src_destroy;
+    loader.FontSrcContainsGlyph = sdf_ttf_contains_glyph;
+    loader.FontBakedInit        = sdf_baked_init;
+    loader.FontBakedLoadGlyph   = sdf_ttf_load_glyph;
+    return loader;
+}
+
+static const ImFontLoader g_sdf_ttf_loader = make_sdf_ttf_loader();
+
+// ---------------------------------------------------------------------------
+// Distance-field shader. Same vertex layout and uniforms as the stock
+// imgui_impl_opengl3 program, so it can be swapped in with a draw callback.
+// Non-glyph atlas texels (the white pixel) are fully inside the field and
+// render unchanged.
+// ---------------------------------------------------------------------------
+static const char* SDF_FRAGMENT_SHADER = R"(#version 300 es
+precision mediump float;
+uniform sampler2D Texture;
+in vec2 Frag_UV;
+in vec4 Frag_Color;
+layout (location = 0) out vec4 Out_Color;
+void main()
+{
+    vec4 t = texture(Texture, Frag_UV.st);
+    float w = max(fwidth(t.a), 1.0 / 255.0);
+    float a = smoothstep(0.5 - w, 0.5 + w, t.a);
+    Out_Color = Frag_Color * vec4(t.rgb, a);
+}
+)";
+
+static GLuint g_sdf_program = 0;
+static GLint  g_sdf_proj    = -1;
+static GLint  g_sdf_texture = -1;
+
+// Draw callback: runs after the backend has set up its render state, and the
+// bound program persists for the rest of the frame.
+static void use_sdf_program(const ImDrawList*, const ImDrawCmd*)
+{
+    float ortho[4][4];
+    gl_program::ortho(ImGui::GetDrawData(), ortho);
+    glUseProgram(g_sdf_program);
+    glUniform1i(g_sdf_texture, 0);
+    glUniformMatrix4fv(g_sdf_proj, 1, GL_FALSE, &ortho[0][0]);
+}
+
+// ---------------------------------------------------------------------------
+// Fallback fonts — merged into the default font the first time a transcript
+// needs a character it lacks. Sources only parse their tables when added;
+// glyphs are rasterised one by one as they are drawn, into ImGui's growable
+// atlas. In SDF mode the embedded DroidSans (Latin Extended, Greek,
+// Cyrillic) is tried before fontconfig, as the generated atlas stops at
+// Latin-1.
+//
+// fontconfig is asked on a background thread: fc-match is a process spawn
+// and a font file can be tens of megabytes, neither of which belongs in a
+// frame. FontCoverText() queues what it lacks and merges what has come back.
+// ---------------------------------------------------------------------------
+static std::vector<std::string>   g_fallback_fonts;   // "file:index", in merge order
+static std::unordered_set<ImWchar> g_uncovered;       // no installed font has these
+static bool                       g_embedded_merged = false;
+
+using FontData = std::shared_ptr<std::vector<unsigned char>>;
+
+struct FontMatch {
+    ImWchar     codepoint = 0;
+    std::string file;      // empty: no usable font
+    int         index = 0;
+    FontData    data;      // null: that face was already sent
+};
+
+struct FontLookup {
+    std::mutex                  mutex;
+    std::condition_variable     cv;
+    std::deque<ImWchar>         queue;
+    std::vector<FontMatch>      done;
+    std::unordered_set<ImWchar> in_flight;   // queued or being matched
+    bool                        stop = false;
+    std::thread                 thread;
+};
+
+static std::unique_ptr<FontLookup> g_lookup;
+// Files of merged fallbacks: the atlas reads glyphs from them until exit
+static std::vector<FontData> g_font_data;
+
+// Font file and face index that fontconfig picks for the codepoint.
+static bool match_font(ImWchar codepoint, std::string* file, int* index)
+{
+    char cmd[96];
+    std::snprintf(cmd, sizeof(cmd), "fc-match --format='%%{index} %%{file}' ':charset=%x' 2>/dev/null",
+                  static_cast<unsigned>(codepoint));
+    FILE* pipe = popen(cmd, "r");
+    if (!pipe) return false;
+    char line[1024] = "";
+    bool ok = std::fgets(line, sizeof(line), pipe) != nullptr;
+    pclose(pipe);
+
+    char* path = nullptr;
+    *index = static_cast<int>(std::strtol(line, &path, 10));
+    if (!ok || path == line || *path != ' ') return false;
+    *file = path + 1;
+
+    // stb_truetype reads TrueType and CFF outlines only
+    size_t dot = file->rfind('.');
+    std::string ext = dot == std::string::npos ? "" : file->substr(dot + 1);
+    for (char& c : ext) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return ext == "ttf" || ext == "otf" || ext == "ttc" || ext == "otc";
+}
+
+static void merge_source(ImFont* font, ImFontConfig& cfg, const char* name)
+{
+    cfg.MergeMode  = true;
+    cfg.DstFont    = font;
+    cfg.FontLoader = g_sdf_program ? &g_sdf_ttf_loader : nullptr;
+    cfg.SizePixels = g_font_size;
+    ImFormatString(cfg.Name, IM_ARRAYSIZE(cfg.Name), "%s", name);
+}
+
+static bool read_file(const std::string& path, std::vector<unsigned char>* out)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0)
+        out->insert(out->end(), buf, buf + n);
+    bool ok = !std::ferror(f);
+    std::fclose(f);
+    return ok && !out->empty();
+}
+
+// A face the lookup thread has read, kept open to check coverage.
+struct SentFace {
+    std::string    file;
+    int            index = 0;
+    FontData       data;
+    stbtt_fontinfo info;
+};
+
+// Lookup thread: match each queued codepoint and read the font file, once
+// per face; merging is left to the UI thread, which owns the atlas. Text
+// in a new script queues many codepoints at once; those a face already
+// read covers skip fc-match.
+static void lookup_loop(FontLookup* l)
+{
+    std::unordered_set<std::string> sent;   // "file:index"
+    std::vector<std::unique_ptr<SentFace>> faces;
+    std::unique_lock<std::mutex> lk(l->mutex);
+    for (;;) {
+        l->cv.wait(lk, [l] { return l->stop || !l->queue.empty(); });
+        if (l->stop) return;
+        FontMatch m;
+        m.codepoint = l->queue.front();
+        l->queue.pop_front();
+        lk.unlock();
+
+        const SentFace* covering = nullptr;
+        for (const auto& f : faces) {
+            if (stbtt_FindGlyphIndex(&f->info, m.codepoint) != 0) {
+                covering = f.get();
+                break;
+            }
+        }
+        if (covering) {
+            m.file  = covering->file;
+            m.index = covering->index;
+        } else if (!match_font(m.codepoint, &m.file, &m.index)) {
+            m.file.clear();
+        } else if (sent.insert(m.file + ":" + std::to_string(m.index)).second) {
+            auto data = std::make_shared<std::vector<unsigned char>>();
+            if (!read_file(m.file, data.get())) {
+                std::fprintf(stderr, "font: cannot read %s\n", m.file.c_str());
+                m.file.clear();
+            } else {
+                auto face = std::make_unique<SentFace>();
+                int offset = stbtt_GetFontOffsetForIndex(data->data(), m.index);
+                if (offset >= 0 && stbtt_InitFont(&face->info, data->data(), offset)) {
+                    face->file  = m.file;
+                    face->index = m.index;
+                    face->data  = data;
+                    faces.push_back(std::move(face));
+                }
+                m.data = std::move(data);
+            }
+        }
+
+        lk.lock();
+        l->done.push_back(std::move(m));
+    }
+}
+
+static void queue_lookup(ImWchar codepoint)
+{
+    if (!g_lookup) {
+        g_lookup = std::make_unique<FontLookup>();
+        g_lookup->thread = std::thread(lookup_loop, g_lookup.get());
+    }
+    std::lock_guard<std::mutex> lk(g_lookup->mutex);
+    if (!g_lookup->in_flight.insert(codepoint).second) return;
+    g_lookup->queue.push_back(codepoint);
+    g_lookup->cv.notify_one();
+}
+
+// The embedded font, in SDF mode. True if it has the codepoint.
+static bool add_embedded_fallback(ImFont* font, ImWchar codepoint)
+{
+    if (!g_sdf_program || g_embedded_merged) return false;
+    g_embedded_merged = true;
+    ImFontConfig cfg;
+    merge_source(font, cfg, "DroidSans SDF fallback");
+    return ImGui::GetIO().Fonts->AddFontFromMemoryCompressedTTF(
+               gen_font_compressed_data, gen_font_compressed_size, g_font_size, &cfg)
+        && font->IsGlyphInFont(codepoint);
+}
+
+// Merge a font the lookup thread matched. False if it could not be added.
+static bool add_fallback(ImFont* font, FontMatch& m)
+{
+    if (!m.data) return false;  // a face already merged, but without the codepoint
+    g_fallback_fonts.push_back(m.file + ":" + std::to_string(m.index));
+
+    FontData data = std::move(m.data);
+    ImFontConfig cfg;
+    cfg.FontNo               = static_cast<ImU32>(m.index);
+    cfg.FontDataOwnedByAtlas = false;
+    merge_source(font, cfg, m.file.substr(m.file.rfind('/') + 1).c_str());
+    if (!ImGui::GetIO().Fonts->AddFontFromMemoryTTF(data->data(), static_cast<int>(data->size()),
+                                                    g_font_size, &cfg)) {
+        std::fprintf(stderr, "font: cannot load %s\n", m.file.c_str());
+        return false;
+    }
+    g_font_data.push_back(std::move(data));
+    std::fprintf(stderr, "font: using %s for U+%04X and the like\n", m.file.c_str(),
+                 static_cast<unsigned>(m.codepoint));
+    return font->IsGlyphInFont(m.codepoint);
+}
 
 namespace ImGui {
 
@@ -8,6 +434,122 @@ void UseCustomFont(ImGuiIO& io, float size)
     ImFont* font = io.Fonts->AddFontFromMemoryCompressedTTF(
         gen_font_compressed_data, gen_font_compressed_size, size);
     io.FontDefault = font;
+    g_font_size = size;
+}
+
+bool FontCoverText(const char* text)
+{
+    ImFontAtlas* atlas = GetIO().Fonts;
+    ImFont* font = GetIO().FontDefault;
+    if (!font) return false;
+
+    // Merge what the lookup thread has found since the last call
+    bool merged = false;
+    bool pending = false;
+    if (g_lookup) {
+        std::vector<FontMatch> done;
+        {
+            std::lock_guard<std::mutex> lk(g_lookup->mutex);
+            done.swap(g_lookup->done);
+            for (const FontMatch& m : done) g_lookup->in_flight.erase(m.codepoint);
+        }
+        for (FontMatch& m : done) {
+            if (font->IsGlyphInFont(m.codepoint)) continue;  // a font merged meanwhile has it
+            if (!m.file.empty() && add_fallback(font, m))
+                merged = true;
+            else
+                g_uncovered.insert(m.codepoint);
+        }
+    }
+
+    for (const char* p = text; *p; ) {
+        unsigned int c = 0;
+        p += ImTextCharFromUtf8(&c, p, nullptr);
+        if (c < 0x80 || c > IM_UNICODE_CODEPOINT_MAX) continue;  // ASCII is always there
+        ImWchar wc = static_cast<ImWchar>(c);
+        if (g_uncovered.count(wc) || font->IsGlyphInFont(wc)) continue;
+        if (add_embedded_fallback(font, wc)) {
+            merged = true;
+            continue;
+        }
+        queue_lookup(wc);
+        pending = true;
+    }
+
+    // Bakes remember the codepoints they could not find; drop them so those
+    // are looked up again in the new sources. The same bound keeps the
+    // cache from growing with everything ever transcribed: past it, only
+    // glyphs drawn from the next frame on are rasterised again.
+    if (g_fallback_fonts.empty() && !g_embedded_merged) return pending;
+    if (merged || (font->LastBaked && font->LastBaked->Glyphs.Size > MAX_CACHED_GLYPHS))
+        ImFontAtlasFontDiscardBakes(atlas, font, 0);
+    return pending;
+}
+
+void FontShutdown()
+{
+    if (!g_lookup) return;
+    {
+        std::lock_guard<std::mutex> lk(g_lookup->mutex);
+        g_lookup->stop = true;
+    }
+    g_lookup->cv.notify_one();
+    g_lookup->thread.join();   // at most one fc-match in progress
+    g_lookup.reset();
+}
+
+void UseSdfFont(ImGuiIO& io, float size)
+{
+    g_sdf_program = gl_program::create(SDF_FRAGMENT_SHADER, "font: SDF");
+    if (!g_sdf_program) {
+        UseCustomFont(io, size);
+        return;
+    }
+    g_sdf_proj    = glGetUniformLocation(g_sdf_program, "ProjMtx");
+    g_sdf_texture = glGetUniformLocation(g_sdf_program, "Texture");
+
+    // Anti-aliased lines must be geometry: baked line texels are coverage,
+    // not distance, and would be thresholded away.
+    io.Fonts->Flags |= ImFontAtlasFlags_NoBakedLines;
+
+    ImFontConfig cfg;
+    cfg.FontLoader = &g_sdf_loader;
+    cfg.SizePixels = sdf_font_size;
+    g_font_size    = sdf_font_size;
+    ImFormatString(cfg.Name, IM_ARRAYSIZE(cfg.Name), "DroidSans SDF");
+    ImFont* font = io.Fonts->AddFont(&cfg);
+
+    // Glyph bitmaps are the same distance fields whatever the baked size,
+    // so lock the font to the first size baked: every other size is drawn
+    // by scaling those glyphs instead of baking another copy.
+    font->Flags |= ImFontFlags_LockBakedSizes;
+
+    io.FontDefault = font;
+    ImGui::GetStyle().FontSizeBase = size;
+}
+
+void SdfFontNewFrame()
+{
+    if (g_sdf_program)
+        ImGui::GetBackgroundDrawList()->AddCallback(use_sdf_program, nullptr);
+}
+
+void SdfFontShutdown()
+{
+    if (g_sdf_program) {
+        glDeleteProgram(g_sdf_program);
+        g_sdf_program = 0;
+    }
+}
+
+bool SdfFontActive()
+{
+    return g_sdf_program != 0;
+}
+
+const char* SdfFontFragmentShader()
+{
+    return SDF_FRAGMENT_SHADER;
 }
 
 }
@@ -4,4 +4,31 @@
 
 namespace ImGui {
     void UseCustomFont(ImGuiIO& io, float size);
+
+    // Make every character of text drawable. Characters the default font
+    // lacks are looked up with fontconfig once each on a background thread,
+    // and the font covering them is merged in by a later call; its glyphs
+    // are rasterised as they are first drawn. Returns true while lookups are
+    // outstanding: call again on a following frame until it returns false.
+    // ASCII-only text costs one pass over the bytes. Call between frames.
+    bool FontCoverText(const char* text);
+    // Stop the lookup thread.
+    void FontShutdown();
+
+    // Use the build-time signed-distance-field atlas instead. The font is
+    // baked once at the SDF size and scaled to every other size, so scale
+    // changes need no rasterisation or atlas rebuild. The GL context must
+    // be current: this compiles the distance-field shader.
+    void UseSdfFont(ImGuiIO& io, float size);
+
+    // Switch this frame's draws to the distance-field shader. Call after
+    // NewFrame() when UseSdfFont() is in effect and the stock OpenGL3
+    // backend renders; ImGui_ImplGLES uses the shader directly instead.
+    void SdfFontNewFrame();
+    void SdfFontShutdown();
+
+    // Whether UseSdfFont() succeeded, and the GLSL ES 3.0 fragment shader
+    // that thresholds the field (inputs Frag_UV/Frag_Color, sampler Texture).
+    bool SdfFontActive();
+    const char* SdfFontFragmentShader();
 }
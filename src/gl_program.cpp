@@ -0,0 +1,87 @@
+#include "gl_program.h"
+
+#include "imgui.h"
+
+#include <cstdio>
+
+static const char* VERTEX_SHADER = R"(#version 300 es
+precision highp float;
+layout (location = 0) in vec2 Position;
+layout (location = 1) in vec2 UV;
+layout (location = 2) in vec4 Color;
+uniform mat4 ProjMtx;
+out vec2 Frag_UV;
+out vec4 Frag_Color;
+void main()
+{
+    Frag_UV = UV;
+    Frag_Color = Color;
+    gl_Position = ProjMtx * vec4(Position.xy, 0, 1);
+}
+)";
+
+static GLuint compile_shader(GLenum type, const char* source, const char* who)
+{
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, nullptr);
+    glCompileShader(shader);
+
+    GLint ok = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        char log[512];
+        glGetShaderInfoLog(shader, sizeof(log), nullptr, log);
+        std::fprintf(stderr, "%s: shader compile failed: %s\n", who, log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+namespace gl_program {
+
+GLuint create(const char* fragment_source, const char* who)
+{
+    GLuint vs = compile_shader(GL_VERTEX_SHADER, VERTEX_SHADER, who);
+    GLuint fs = compile_shader(GL_FRAGMENT_SHADER, fragment_source, who);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+
+    GLint ok = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &ok);
+    if (!ok) {
+        std::fprintf(stderr, "%s: program link failed\n", who);
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+void ortho(const ImDrawData* dd, float out[4][4])
+{
+    float L = dd->DisplayPos.x;
+    float R = dd->DisplayPos.x + dd->DisplaySize.x;
+    float T = dd->DisplayPos.y;
+    float B = dd->DisplayPos.y + dd->DisplaySize.y;
+    const float m[4][4] = {
+        { 2.0f / (R - L),    0.0f,              0.0f, 0.0f },
+        { 0.0f,              2.0f / (T - B),    0.0f, 0.0f },
+        { 0.0f,              0.0f,             -1.0f, 0.0f },
+        { (R + L) / (L - R), (T + B) / (B - T), 0.0f, 1.0f },
+    };
+    for (int i = 0; i < 4; ++i)
+        for (int j = 0; j < 4; ++j)
+            out[i][j] = m[i][j];
+}
+
+} // namespace gl_program
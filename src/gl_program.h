@@ -0,0 +1,20 @@
+#pragma once
+
+#include <GLES3/gl3.h>
+
+struct ImDrawData;
+
+// Shader programs for ImGui draw data, shared by the overlay renderer and the
+// distance-field font: one vertex stage (ImDrawVert layout at attribute
+// locations 0-2, uniform ProjMtx) with the caller's fragment stage.
+namespace gl_program {
+
+// Compile and link with the given fragment shader; 0 on failure, logged
+// under `who`.
+GLuint create(const char* fragment_source, const char* who);
+
+// Orthographic projection covering the draw data's display rect, for
+// ProjMtx (column-major).
+void ortho(const ImDrawData* draw_data, float out[4][4]);
+
+} // namespace gl_program
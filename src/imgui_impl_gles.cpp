@@ -0,0 +1,344 @@
+#include "imgui_impl_gles.h"
+#include "font.h"
+#include "gl_program.h"
+
+#include "imgui.h"
+
+#include <GLES3/gl3.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static constexpr int INITIAL_VTX_CAPACITY = 16 * 1024;
+static constexpr int INITIAL_IDX_CAPACITY = 48 * 1024;
+
+static const char* FRAGMENT_SHADER = R"(#version 300 es
+precision mediump float;
+uniform sampler2D Texture;
+in vec2 Frag_UV;
+in vec4 Frag_Color;
+layout (location = 0) out vec4 Out_Color;
+void main()
+{
+    Out_Color = Frag_Color * texture(Texture, Frag_UV.st);
+}
+)";
+
+// ---------------------------------------------------------------------------
+// Renderer state
+// ---------------------------------------------------------------------------
+struct GlesRenderer {
+    GLuint program  = 0;
+    GLint  loc_proj = -1;
+    GLint  loc_tex  = -1;
+
+    GLuint vao = 0;
+    GLuint vbo = 0;
+    GLuint ibo = 0;
+
+    // Streaming ring: each frame's geometry is written past the previous
+    // frame's with unsynchronized maps; on wrap the buffer is orphaned.
+    int vtx_capacity = 0;
+    int idx_capacity = 0;
+    int vtx_head     = 0;
+    int idx_head     = 0;
+
+    int draw_calls   = 0;
+};
+
+static GlesRenderer g_gles;
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+// (Re)allocate the streaming buffers. Called at init and when a frame does
+// not fit; the VAO keeps pointing at the same buffer objects.
+static void allocate_buffers(int vtx_capacity, int idx_capacity)
+{
+    g_gles.vtx_capacity = vtx_capacity;
+    g_gles.idx_capacity = idx_capacity;
+    g_gles.vtx_head = 0;
+    g_gles.idx_head = 0;
+
+    glBindBuffer(GL_ARRAY_BUFFER, g_gles.vbo);
+    glBufferData(GL_ARRAY_BUFFER, static_cast<GLsizeiptr>(vtx_capacity) * sizeof(ImDrawVert),
+                 nullptr, GL_STREAM_DRAW);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, g_gles.ibo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(idx_capacity) * sizeof(GLuint),
+                 nullptr, GL_STREAM_DRAW);
+}
+
+// Make room for n_vtx/n_idx contiguous elements at the ring heads. Returns
+// the GL_MAP_* invalidation flag to use for this frame's maps.
+static GLbitfield reserve(int n_vtx, int n_idx)
+{
+    if (n_vtx > g_gles.vtx_capacity || n_idx > g_gles.idx_capacity) {
+        int vcap = g_gles.vtx_capacity, icap = g_gles.idx_capacity;
+        while (vcap < n_vtx) vcap *= 2;
+        while (icap < n_idx) icap *= 2;
+        allocate_buffers(vcap, icap);
+        return GL_MAP_INVALIDATE_BUFFER_BIT;
+    }
+    if (g_gles.vtx_head + n_vtx > g_gles.vtx_capacity ||
+        g_gles.idx_head + n_idx > g_gles.idx_capacity) {
+        // Wrap: orphan the old storage so in-flight frames keep theirs
+        g_gles.vtx_head = 0;
+        g_gles.idx_head = 0;
+        return GL_MAP_INVALIDATE_BUFFER_BIT;
+    }
+    return GL_MAP_INVALIDATE_RANGE_BIT;
+}
+
+static void update_texture(ImTextureData* tex)
+{
+    if (tex->Status == ImTextureStatus_WantCreate) {
+        IM_ASSERT(tex->Format == ImTextureFormat_RGBA32);
+        GLuint id = 0;
+        glGenTextures(1, &id);
+        glBindTexture(GL_TEXTURE_2D, id);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, tex->Width, tex->Height, 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, tex->GetPixels());
+        tex->SetTexID(static_cast<ImTextureID>(id));
+        tex->SetStatus(ImTextureStatus_OK);
+    } else if (tex->Status == ImTextureStatus_WantUpdates) {
+        glBindTexture(GL_TEXTURE_2D, static_cast<GLuint>(tex->GetTexID()));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, tex->Width);
+        for (const ImTextureRect& r : tex->Updates)
+            glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.w, r.h,
+                            GL_RGBA, GL_UNSIGNED_BYTE, tex->GetPixelsAt(r.x, r.y));
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+        tex->SetStatus(ImTextureStatus_OK);
+    } else if (tex->Status == ImTextureStatus_WantDestroy && tex->UnusedFrames > 0) {
+        GLuint id = static_cast<GLuint>(tex->GetTexID());
+        glDeleteTextures(1, &id);
+        tex->SetTexID(ImTextureID_Invalid);
+        tex->SetStatus(ImTextureStatus_Destroyed);
+    }
+}
+
+// The only per-frame state setup: everything else stays as Init left it.
+static void setup_render_state(ImDrawData* dd, int fb_w, int fb_h)
+{
+    glViewport(0, 0, fb_w, fb_h);
+    glEnable(GL_BLEND);
+    glBlendEquation(GL_FUNC_ADD);
+    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDisable(GL_CULL_FACE);
+    glDisable(GL_DEPTH_TEST);
+    glDisable(GL_STENCIL_TEST);
+    glEnable(GL_SCISSOR_TEST);
+
+    float ortho[4][4];
+    gl_program::ortho(dd, ortho);
+    glUseProgram(g_gles.program);
+    glUniform1i(g_gles.loc_tex, 0);
+    glUniformMatrix4fv(g_gles.loc_proj, 1, GL_FALSE, &ortho[0][0]);
+    glActiveTexture(GL_TEXTURE0);
+    glBindVertexArray(g_gles.vao);
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+bool ImGui_ImplGLES::Init(bool sdf_text)
+{
+    g_gles = GlesRenderer{};
+    g_gles.program = gl_program::create(sdf_text ? ImGui::SdfFontFragmentShader()
+                                                 : FRAGMENT_SHADER, "gles");
+    if (!g_gles.program) return false;
+    g_gles.loc_proj = glGetUniformLocation(g_gles.program, "ProjMtx");
+    g_gles.loc_tex  = glGetUniformLocation(g_gles.program, "Texture");
+
+    glGenVertexArrays(1, &g_gles.vao);
+    glGenBuffers(1, &g_gles.vbo);
+    glGenBuffers(1, &g_gles.ibo);
+
+    // Attribute pointers are fixed: frames are addressed by rebasing indices
+    // onto the ring offset rather than moving the pointers.
+    glBindVertexArray(g_gles.vao);
+    allocate_buffers(INITIAL_VTX_CAPACITY, INITIAL_IDX_CAPACITY);
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert),
+                          reinterpret_cast<void*>(offsetof(ImDrawVert, pos)));
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(ImDrawVert),
+                          reinterpret_cast<void*>(offsetof(ImDrawVert, uv)));
+    glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(ImDrawVert),
+                          reinterpret_cast<void*>(offsetof(ImDrawVert, col)));
+    glBindVertexArray(0);
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = "imgui_impl_gles";
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+    return true;
+}
+
+void ImGui_ImplGLES::Shutdown()
+{
+    for (ImTextureData* tex : ImGui::GetPlatformIO().Textures) {
+        if (tex->RefCount != 1) continue;
+        tex->SetStatus(ImTextureStatus_WantDestroy);
+        tex->UnusedFrames = 1;
+        update_texture(tex);
+    }
+
+    if (g_gles.vao)     glDeleteVertexArrays(1, &g_gles.vao);
+    if (g_gles.vbo)     glDeleteBuffers(1, &g_gles.vbo);
+    if (g_gles.ibo)     glDeleteBuffers(1, &g_gles.ibo);
+    if (g_gles.program) glDeleteProgram(g_gles.program);
+    g_gles = GlesRenderer{};
+
+    ImGuiIO& io = ImGui::GetIO();
+    io.BackendRendererName = nullptr;
+    io.BackendFlags &= ~(ImGuiBackendFlags_RendererHasVtxOffset |
+                         ImGuiBackendFlags_RendererHasTextures);
+}
+
+void ImGui_ImplGLES::NewFrame() {}
+
+void ImGui_ImplGLES::RenderDrawData(ImDrawData* dd)
+{
+    g_gles.draw_calls = 0;
+
+    int fb_w = static_cast<int>(dd->DisplaySize.x * dd->FramebufferScale.x);
+    int fb_h = static_cast<int>(dd->DisplaySize.y * dd->FramebufferScale.y);
+    if (fb_w <= 0 || fb_h <= 0) return;
+
+    if (dd->Textures)
+        for (ImTextureData* tex : *dd->Textures)
+            if (tex->Status != ImTextureStatus_OK)
+                update_texture(tex);
+
+    if (dd->TotalVtxCount == 0) return;
+
+    // Upload the whole frame in one map per buffer. Indices are widened to
+    // 32 bits and rebased onto the frame's ring offset, so every command of
+    // every list addresses one shared vertex range.
+    glBindVertexArray(g_gles.vao);
+    GLbitfield inval = reserve(dd->TotalVtxCount, dd->TotalIdxCount);
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | inval;
+
+    glBindBuffer(GL_ARRAY_BUFFER, g_gles.vbo);
+    auto* vtx_dst = static_cast<ImDrawVert*>(glMapBufferRange(
+        GL_ARRAY_BUFFER, static_cast<GLintptr>(g_gles.vtx_head) * sizeof(ImDrawVert),
+        static_cast<GLsizeiptr>(dd->TotalVtxCount) * sizeof(ImDrawVert), flags));
+    auto* idx_dst = static_cast<GLuint*>(glMapBufferRange(
+        GL_ELEMENT_ARRAY_BUFFER, static_cast<GLintptr>(g_gles.idx_head) * sizeof(GLuint),
+        static_cast<GLsizeiptr>(dd->TotalIdxCount) * sizeof(GLuint), flags));
+    if (!vtx_dst || !idx_dst) {
+        if (vtx_dst) glUnmapBuffer(GL_ARRAY_BUFFER);
+        if (idx_dst) glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        glBindVertexArray(0);
+        return;
+    }
+
+    GLuint vtx_base = static_cast<GLuint>(g_gles.vtx_head);
+    for (const ImDrawList* list : dd->CmdLists) {
+        std::memcpy(vtx_dst, list->VtxBuffer.Data, list->VtxBuffer.Size * sizeof(ImDrawVert));
+        vtx_dst += list->VtxBuffer.Size;
+
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            if (cmd.UserCallback) continue;
+            const ImDrawIdx* src = list->IdxBuffer.Data + cmd.IdxOffset;
+            GLuint base = vtx_base + cmd.VtxOffset;
+            for (unsigned int i = 0; i < cmd.ElemCount; ++i)
+                idx_dst[i] = base + src[i];
+            idx_dst += cmd.ElemCount;
+        }
+        vtx_base += static_cast<GLuint>(list->VtxBuffer.Size);
+    }
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+
+    setup_render_state(dd, fb_w, fb_h);
+
+    // Walk commands, extending a pending batch while texture and clip rect
+    // stay the same; indices are contiguous across lists by construction.
+    ImVec2 clip_off   = dd->DisplayPos;
+    ImVec2 clip_scale = dd->FramebufferScale;
+
+    GLuint bound_tex = 0;
+    int    bound_clip[4] = { -1, -1, -1, -1 };
+
+    GLuint batch_tex = 0;
+    int    batch_clip[4] = {};
+    int    batch_start = 0, batch_count = 0;
+
+    auto flush = [&]() {
+        if (batch_count == 0) return;
+        if (batch_tex != bound_tex) {
+            glBindTexture(GL_TEXTURE_2D, batch_tex);
+            bound_tex = batch_tex;
+        }
+        if (std::memcmp(batch_clip, bound_clip, sizeof(bound_clip)) != 0) {
+            glScissor(batch_clip[0], batch_clip[1], batch_clip[2], batch_clip[3]);
+            std::memcpy(bound_clip, batch_clip, sizeof(bound_clip));
+        }
+        glDrawElements(GL_TRIANGLES, batch_count, GL_UNSIGNED_INT,
+                       reinterpret_cast<void*>(static_cast<uintptr_t>(batch_start) * sizeof(GLuint)));
+        ++g_gles.draw_calls;
+        batch_count = 0;
+    };
+
+    int idx_pos = g_gles.idx_head;
+    for (const ImDrawList* list : dd->CmdLists) {
+        for (const ImDrawCmd& cmd : list->CmdBuffer) {
+            if (cmd.UserCallback) {
+                flush();
+                if (cmd.UserCallback != ImDrawCallback_ResetRenderState)
+                    cmd.UserCallback(list, &cmd);
+                // Callbacks may touch any state — re-establish ours
+                setup_render_state(dd, fb_w, fb_h);
+                bound_tex = 0;
+                bound_clip[0] = -1;
+                continue;
+            }
+
+            ImVec2 cmin((cmd.ClipRect.x - clip_off.x) * clip_scale.x,
+                        (cmd.ClipRect.y - clip_off.y) * clip_scale.y);
+            ImVec2 cmax((cmd.ClipRect.z - clip_off.x) * clip_scale.x,
+                        (cmd.ClipRect.w - clip_off.y) * clip_scale.y);
+            int start = idx_pos;
+            idx_pos += static_cast<int>(cmd.ElemCount);
+            if (cmax.x <= cmin.x || cmax.y <= cmin.y) {
+                flush();
+                continue;
+            }
+
+            GLuint tex = static_cast<GLuint>(cmd.GetTexID());
+            int clip[4] = {
+                static_cast<int>(cmin.x), static_cast<int>(fb_h - cmax.y),
+                static_cast<int>(cmax.x - cmin.x), static_cast<int>(cmax.y - cmin.y),
+            };
+            bool same = batch_count > 0 && tex == batch_tex &&
+                        std::memcmp(clip, batch_clip, sizeof(clip)) == 0 &&
+                        start == batch_start + batch_count;
+            if (!same) {
+                flush();
+                batch_tex   = tex;
+                batch_start = start;
+                std::memcpy(batch_clip, clip, sizeof(clip));
+            }
+            batch_count += static_cast<int>(cmd.ElemCount);
+        }
+    }
+    flush();
+
+    glBindVertexArray(0);
+    g_gles.vtx_head += dd->TotalVtxCount;
+    g_gles.idx_head += dd->TotalIdxCount;
+}
+
+int ImGui_ImplGLES::LastDrawCalls()
+{
+    return g_gles.draw_calls;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+struct ImDrawData;
+
+// Purpose-built OpenGL ES 3.0 renderer for the overlay. Unlike the stock
+// imgui_impl_opengl3 backend it keeps one persistently allocated streaming
+// vertex/index buffer pair, sets GL state once per frame without saving and
+// restoring it, and merges consecutive draw commands that share a texture
+// and clip rect into a single glDrawElements call.
+namespace ImGui_ImplGLES {
+    // sdf_text: threshold the font atlas as a distance field (see UseSdfFont).
+    bool Init(bool sdf_text);
+    void Shutdown();
+    void NewFrame();
+    void RenderDrawData(ImDrawData* draw_data);
+
+    // Number of glDrawElements calls issued by the last RenderDrawData.
+    int  LastDrawCalls();
+}
@@ -0,0 +1,116 @@
+#include "latency.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+static constexpr const char* PM_QOS_DEVICE = "/dev/cpu_dma_latency";
+static constexpr const char* CPU_SYSFS_DIR = "/sys/devices/system/cpu";
+static constexpr const char* EPP_FILE      = "cpufreq/energy_performance_preference";
+
+struct LatencyHint::Impl {
+    int qos_fd = -1;
+
+    // (sysfs path, original value) for every CPU whose EPP we changed
+    std::vector<std::pair<std::string, std::string>> saved_epp;
+};
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+static bool read_line(const std::string& path, std::string* out)
+{
+    FILE* f = std::fopen(path.c_str(), "r");
+    if (!f) return false;
+    char buf[64];
+    bool ok = std::fgets(buf, sizeof(buf), f) != nullptr;
+    std::fclose(f);
+    if (!ok) return false;
+    *out = buf;
+    while (!out->empty() && (out->back() == '\n' || out->back() == ' '))
+        out->pop_back();
+    return true;
+}
+
+static bool write_line(const std::string& path, const std::string& value)
+{
+    int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    bool ok = write(fd, value.c_str(), value.size()) == static_cast<ssize_t>(value.size());
+    close(fd);
+    return ok;
+}
+
+static std::vector<std::string> cpu_epp_paths()
+{
+    std::vector<std::string> paths;
+    DIR* dir = opendir(CPU_SYSFS_DIR);
+    if (!dir) return paths;
+    while (dirent* ent = readdir(dir)) {
+        const char* name = ent->d_name;
+        if (std::strncmp(name, "cpu", 3) != 0 || name[3] < '0' || name[3] > '9')
+            continue;
+        std::string path = std::string(CPU_SYSFS_DIR) + "/" + name + "/" + EPP_FILE;
+        if (access(path.c_str(), F_OK) == 0)
+            paths.push_back(std::move(path));
+    }
+    closedir(dir);
+    return paths;
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+LatencyHint::LatencyHint() : impl_(std::make_unique<Impl>()) {}
+LatencyHint::~LatencyHint() { shutdown(); }
+
+bool LatencyHint::init(int max_us, bool performance_epp)
+{
+    // The request stays active for as long as the fd is open.
+    impl_->qos_fd = open(PM_QOS_DEVICE, O_RDWR | O_CLOEXEC);
+    if (impl_->qos_fd >= 0) {
+        int32_t value = max_us;
+        if (write(impl_->qos_fd, &value, sizeof(value)) != sizeof(value)) {
+            std::fprintf(stderr, "latency: PM QoS write failed: %s\n", std::strerror(errno));
+            close(impl_->qos_fd);
+            impl_->qos_fd = -1;
+        }
+    } else {
+        std::fprintf(stderr, "latency: cannot open %s: %s\n",
+                     PM_QOS_DEVICE, std::strerror(errno));
+    }
+
+    if (performance_epp) {
+        int failed = 0;
+        for (const auto& path : cpu_epp_paths()) {
+            std::string old;
+            if (!read_line(path, &old)) { ++failed; continue; }
+            if (old == "performance") continue;
+            if (!write_line(path, "performance")) { ++failed; continue; }
+            impl_->saved_epp.emplace_back(path, old);
+        }
+        if (failed > 0)
+            std::fprintf(stderr, "latency: could not set EPP on %d CPUs\n", failed);
+    }
+
+    return impl_->qos_fd >= 0 || !impl_->saved_epp.empty();
+}
+
+void LatencyHint::shutdown()
+{
+    for (const auto& [path, value] : impl_->saved_epp)
+        write_line(path, value);
+    impl_->saved_epp.clear();
+
+    if (impl_->qos_fd >= 0) {
+        close(impl_->qos_fd);
+        impl_->qos_fd = -1;
+    }
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <memory>
+
+// Session-scoped low wake-latency hint. Holds a PM QoS request on
+// /dev/cpu_dma_latency (keeps CPUs out of deep C-states) and optionally
+// switches the cpufreq energy-performance preference to "performance".
+// Both are released on shutdown; the PM QoS request also dies with the
+// process if it is killed.
+struct LatencyHint {
+    LatencyHint();
+    ~LatencyHint();
+
+    LatencyHint(const LatencyHint&) = delete;
+    LatencyHint& operator=(const LatencyHint&) = delete;
+
+    // Request a maximum wake-up latency of max_us microseconds. With
+    // performance_epp, also raise the energy-performance preference of all
+    // CPUs. Missing permissions are reported but not fatal — returns true
+    // if at least one of the hints is in effect.
+    bool init(int max_us, bool performance_epp);
+    void shutdown();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
@@ -1,22 +1,41 @@
 #include "audio.h"
+#include "batch.h"
+#include "bench.h"
+#include "config.h"
+#include "delivery.h"
+#include "experiment.h"
 #include "font.h"
+#include "imgui_impl_gles.h"
 #include "imgui_impl_wayland.h"
+#include "latency.h"
+#include "metrics.h"
 #include "overlay.h"
 #include "paste.h"
+#include "profiler.h"
+#include "results.h"
 #include "transcriber.h"
+#include "ui.h"
 
 #include "imgui.h"
 #include "imgui_impl_opengl3.h"
 
 #include <GLES3/gl3.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
 #include <chrono>
+#include <csignal>
 #include <cstdio>
+#include <cstdint>
 #include <cstdlib>
 #include <thread>
 #include <cstring>
+#include <fcntl.h>
+#include <mutex>
 #include <string>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <vector>
 #include <xkbcommon/xkbcommon-keysyms.h>
 
@@ -28,6 +47,47 @@ static bool file_exists(const std::string& path)
     return stat(path.c_str(), &st) == 0 && S_ISREG(st.st_mode);
 }
 
+// Model files to look for, fastest first, limited by LIVE_WHISPER_ACCURACY:
+//   fast      q5_1, q8_0, f16
+//   balanced  q8_0, f16   (default; q8_0 is within noise of f16)
+//   exact     f16 only
+static std::vector<std::string> model_candidates()
+{
+    // A config or experiment setting overrides the environment
+    static const char* const TIERS[] = {"fast", "balanced", "exact"};
+    std::string tier = "balanced";
+    if (const char* env = std::getenv("LIVE_WHISPER_ACCURACY")) tier = env;
+    if (int level = config::current().accuracy; level >= 0) tier = TIERS[level];
+
+    std::vector<const char*> types;
+    if (tier == "fast") {
+        types = {"q5_1", "q8_0"};
+    } else if (tier == "exact") {
+        types = {};
+    } else {
+        if (tier != "balanced")
+            std::fprintf(stderr, "Unknown LIVE_WHISPER_ACCURACY '%s', using balanced\n", tier.c_str());
+        types = {"q8_0"};
+    }
+
+    // ggml-tiny.bin -> ggml-tiny-q8_0.bin, as whisper.cpp's quantize names them
+    std::string stem = std::string(MODEL_NAME).substr(0, std::strlen(MODEL_NAME) - 4);
+    std::vector<std::string> names;
+    for (const char* type : types) names.push_back(stem + "-" + type + ".bin");
+    names.push_back(MODEL_NAME);
+    return names;
+}
+
+// First existing candidate in dir.
+static std::string find_in_dir(const std::string& dir, const std::vector<std::string>& names)
+{
+    for (const std::string& name : names) {
+        std::string path = dir + "/" + name;
+        if (file_exists(path)) return path;
+    }
+    return {};
+}
+
 static std::string find_model()
 {
     // 1. Environment variable override (exact path)
@@ -35,11 +95,11 @@ static std::string find_model()
         if (file_exists(env)) return env;
     }
 
+    std::vector<std::string> names = model_candidates();
+    std::vector<std::string> dirs;
+
     // 2. Compile-time install prefix
-    {
-        std::string path = std::string(LIVE_WHISPER_DATADIR) + "/" + MODEL_NAME;
-        if (file_exists(path)) return path;
-    }
+    dirs.push_back(LIVE_WHISPER_DATADIR);
 
     // 3. XDG_DATA_HOME (defaults to ~/.local/share)
     {
@@ -49,124 +109,501 @@ static std::string find_model()
         } else if (const char* home = std::getenv("HOME")) {
             base = std::string(home) + "/.local/share";
         }
-        if (!base.empty()) {
-            std::string path = base + "/live-whisper/" + MODEL_NAME;
-            if (file_exists(path)) return path;
-        }
+        if (!base.empty()) dirs.push_back(base + "/live-whisper");
     }
 
     // 4. System data dirs
-    for (const char* dir : {"/usr/local/share/live-whisper", "/usr/share/live-whisper"}) {
-        std::string path = std::string(dir) + "/" + MODEL_NAME;
-        if (file_exists(path)) return path;
-    }
+    dirs.push_back("/usr/local/share/live-whisper");
+    dirs.push_back("/usr/share/live-whisper");
 
     // 5. Relative path (development fallback)
-    {
-        std::string path = std::string("models/") + MODEL_NAME;
-        if (file_exists(path)) return path;
-    }
+    dirs.push_back("models");
 
+    for (const std::string& dir : dirs) {
+        std::string path = find_in_dir(dir, names);
+        if (!path.empty()) return path;
+    }
     return {};
 }
 
-static constexpr int    OVERLAY_HEIGHT = 350;
-static constexpr int    SAMPLE_RATE    = 16000;
-static constexpr int    READ_BUF_SIZE  = SAMPLE_RATE / 10;  // 100ms chunks
+// find_model(), reporting the search path when nothing is found.
+static std::string find_model_or_report()
+{
+    std::string model_path = find_model();
+    if (model_path.empty()) {
+        std::fprintf(stderr,
+            "Could not find %s. Searched:\n"
+            "  $LIVE_WHISPER_MODEL          (env var, exact path)\n"
+            "  %s/\n"
+            "  $XDG_DATA_HOME/live-whisper/\n"
+            "  /usr/local/share/live-whisper/\n"
+            "  /usr/share/live-whisper/\n"
+            "  models/                       (relative, for development)\n"
+            "\n"
+            "Install with: cmake --install build --prefix ~/.local\n",
+            MODEL_NAME, LIVE_WHISPER_DATADIR);
+    }
+    return model_path;
+}
+
+static bool init_transcriber(Transcriber& transcriber, Transcriber::Decoding decoding)
+{
+    std::string model_path = find_model_or_report();
+    if (model_path.empty()) return false;
+    if (!transcriber.init(model_path)) {
+        std::fprintf(stderr, "Failed to init transcriber with %s\n", model_path.c_str());
+        return false;
+    }
+    transcriber.set_decoding(decoding);
+    return true;
+}
+
 static constexpr float  BASE_FONT_SIZE = 10.0f;
+static constexpr int    LOW_LATENCY_US = 10;  // allows C1, rules out deep C-states
+static constexpr int    INDICATOR_HEIGHT = 40;  // delivery progress strip
+
+// Move captured audio to the transcriber in chunks of read_buf_size,
+// applying the current ring and chunk sizes first
+static void pump_audio(AudioCapture& audio, Transcriber& transcriber, std::vector<float>& buf)
+{
+    const config::Tuning tuning = config::current();
+    audio.set_ring_seconds(static_cast<uint32_t>(tuning.ring_buf_secs));
+    buf.resize(static_cast<size_t>(tuning.read_buf_size));
+
+    uint32_t chunk = static_cast<uint32_t>(buf.size());
+    uint32_t avail = audio.available();
+    while (avail > 0) {
+        uint32_t got = audio.read(buf.data(), avail < chunk ? avail : chunk);
+        if (got == 0) break;
+        transcriber.process(buf.data(), got);
+        avail = audio.available();
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Delivery cancellation: the running instance keeps its pid in a file while
+// it types; `--cancel` sends it SIGUSR1.
+// ---------------------------------------------------------------------------
+static paste::Progress g_delivery;
+
+static void handle_cancel_signal(int) { g_delivery.cancel = true; }
+
+static std::string pidfile_path()
+{
+    const char* runtime = std::getenv("XDG_RUNTIME_DIR");
+    return std::string(runtime ? runtime : "/tmp") + "/live-whisper.pid";
+}
+
+static void write_pidfile()
+{
+    // The /tmp fallback is a guessable name: never follow a planted symlink
+    int fd = open(pidfile_path().c_str(),
+                  O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        std::fprintf(stderr, "Cannot write pidfile %s\n",
+                     pidfile_path().c_str());
+        return;
+    }
+    if (FILE* f = fdopen(fd, "w")) {
+        std::fprintf(f, "%d\n", static_cast<int>(getpid()));
+        std::fclose(f);
+    } else {
+        close(fd);
+    }
+}
+
+static int cancel_delivery()
+{
+    int pid = 0;
+    if (FILE* f = std::fopen(pidfile_path().c_str(), "r")) {
+        if (std::fscanf(f, "%d", &pid) != 1) pid = 0;
+        std::fclose(f);
+    }
+
+    // A stale file may name an unrelated process by now
+    char comm[64] = {};
+    std::string comm_path = "/proc/" + std::to_string(pid) + "/comm";
+    if (FILE* f = pid > 0 ? std::fopen(comm_path.c_str(), "r") : nullptr) {
+        if (!std::fgets(comm, sizeof(comm), f)) comm[0] = '\0';
+        std::fclose(f);
+    }
+    if (std::strncmp(comm, "live-whisper", 12) != 0) {
+        std::fprintf(stderr, "No delivery in progress\n");
+        return 1;
+    }
+    return kill(pid, SIGUSR1) == 0 ? 0 : 1;
+}
 
-static void apply_style(float scale)
+// ---------------------------------------------------------------------------
+// Command line
+// ---------------------------------------------------------------------------
+struct Options {
+    bool        headless    = false;
+    std::string output      = "-";   // headless result stream: "-" or FIFO path
+    bool        type_live   = false; // headless: type results into the focused window
+    bool        low_latency = false;
+    bool        epp         = false;
+    std::string bench_wav;           // replay this file instead of the mic
+    int         contention_cores = -1;  // with bench_wav: stressor threads, 0 = all
+    bench::StressKind stress_kind = bench::StressKind::Mixed;
+    std::string soak_wav;            // loop this file through a long accelerated session
+    int         soak_minutes = 60;
+    double      soak_speed   = 8.0;
+    bool        raster_font = false; // rasterise the TTF instead of the SDF atlas
+    bool        stock_renderer = false;  // imgui_impl_opengl3 instead of ImGui_ImplGLES
+    int         bench_render_frames = 0;
+    bool        echo_cancel = false; // cancel system playback picked up by the mic
+    std::string bench_echo_near;     // echo rig inputs
+    std::string bench_echo_far;
+    bool        paste_failed = false; // record that the last paste went wrong
+    bool        clipboard_ok = false; // allow clipboard paste for the last window class
+    bool        fast_keys_ok = false; // allow fast typing for the last window class
+    Transcriber::Decoding decoding = Transcriber::Decoding::Full;
+    std::string profile_dir;          // write collapsed stacks here on exit
+    int         profile_hz = 99;
+    std::string batch_output;         // --batch: JSON lines destination
+    std::vector<std::string> batch_inputs;
+    int         batch_workers = 0;    // 0 = one per core
+    std::string worker_socket;        // internal: run as a batch worker
+    std::string worker_model;
+    int         worker_threads = 1;
+    int         worker_node = -1;
+    bool        numa = true;          // --batch: place workers on NUMA nodes
+    bool        cancel = false;       // stop the delivery of a running instance
+    std::string variant;              // force this experiment variant
+};
+
+static void print_usage(const char* argv0)
 {
-    auto& style = ImGui::GetStyle();
-
-    // Scale all default sizes for HiDPI, then override specific values
-    style.ScaleAllSizes(scale);
-
-    // Geometry (set after ScaleAllSizes — these are direct overrides)
-    style.WindowRounding    = 12.0f;
-    style.WindowBorderSize  = 0.0f;
-    style.WindowPadding     = ImVec2(16.0f, 12.0f);
-    style.FrameRounding     = 6.0f;
-    style.FramePadding      = ImVec2(12.0f, 8.0f);
-    style.ItemSpacing       = ImVec2(8.0f, 8.0f);
-    style.ScrollbarSize     = 10.0f;
-    style.ScrollbarRounding = 4.0f;
-    style.GrabRounding      = 4.0f;
-
-    // Colors — dark translucent overlay
-    auto& c = style.Colors;
-    c[ImGuiCol_WindowBg]          = ImVec4(0.08f, 0.08f, 0.10f, 1.00f);
-    c[ImGuiCol_Border]            = ImVec4(0.20f, 0.20f, 0.25f, 0.50f);
-
-    // Text
-    c[ImGuiCol_Text]              = ImVec4(0.90f, 0.90f, 0.93f, 1.00f);
-    c[ImGuiCol_TextDisabled]      = ImVec4(0.45f, 0.45f, 0.50f, 1.00f);
-
-    // Frame (text input background)
-    c[ImGuiCol_FrameBg]           = ImVec4(0.12f, 0.12f, 0.15f, 1.00f);
-    c[ImGuiCol_FrameBgHovered]    = ImVec4(0.16f, 0.16f, 0.20f, 1.00f);
-    c[ImGuiCol_FrameBgActive]     = ImVec4(0.14f, 0.14f, 0.18f, 1.00f);
-
-    // Scrollbar
-    c[ImGuiCol_ScrollbarBg]       = ImVec4(0.08f, 0.08f, 0.10f, 0.50f);
-    c[ImGuiCol_ScrollbarGrab]     = ImVec4(0.25f, 0.25f, 0.30f, 1.00f);
-    c[ImGuiCol_ScrollbarGrabHovered] = ImVec4(0.35f, 0.35f, 0.40f, 1.00f);
-    c[ImGuiCol_ScrollbarGrabActive]  = ImVec4(0.40f, 0.40f, 0.45f, 1.00f);
-
-    // Separator
-    c[ImGuiCol_Separator]         = ImVec4(0.22f, 0.22f, 0.28f, 1.00f);
-
-    // Header (for the status bar area)
-    c[ImGuiCol_Header]            = ImVec4(0.15f, 0.15f, 0.20f, 1.00f);
-    c[ImGuiCol_HeaderHovered]     = ImVec4(0.20f, 0.20f, 0.26f, 1.00f);
-    c[ImGuiCol_HeaderActive]      = ImVec4(0.18f, 0.18f, 0.24f, 1.00f);
-
-    // Text selection
-    c[ImGuiCol_TextSelectedBg]    = ImVec4(0.22f, 0.35f, 0.55f, 0.60f);
-    c[ImGuiCol_NavHighlight]      = ImVec4(0.30f, 0.50f, 0.80f, 1.00f);
+    std::fprintf(stderr,
+        "Usage: %s [options]\n"
+        "\n"
+        "  --headless        no overlay; stream results as JSON lines\n"
+        "  --output PATH     headless output: - for stdout (default) or a FIFO path\n"
+        "  --type-live       headless: also type the text into the focused window\n"
+        "                    as it settles, correcting revised words in place\n"
+        "  --low-latency     hold a PM QoS wake-latency request while recording\n"
+        "  --epp             with --low-latency, also set cpufreq EPP to performance\n"
+        "  --bench FILE.wav  replay FILE and report jitter and pass latency\n"
+        "                    (compares against --low-latency if given)\n"
+        "  --contention N    with --bench, replay idle and again while N threads\n"
+        "                    (0 = all cores) load the machine; report first-partial,\n"
+        "                    staleness and final latency (--low-latency applies to both)\n"
+        "  --stress KIND     contention load: cpu, memory or mixed (default)\n"
+        "  --bench-soak FILE.wav\n"
+        "                    loop FILE through the transcriber and offscreen UI for\n"
+        "                    --soak-minutes (default 60) of audio at --soak-speed\n"
+        "                    (default 8) times real time; fail on resource growth\n"
+        "  --raster-font     rasterise the font instead of using the SDF atlas\n"
+        "  --stock-renderer  use ImGui's stock OpenGL3 backend\n"
+        "  --bench-render N  render N offscreen frames with both renderers and compare\n"
+        "  --prefix-decode   force the stable tokens of the last pass and only\n"
+        "                    decode the new tail\n"
+        "  --echo-cancel     cancel system playback (monitor source) from the mic\n"
+        "  --bench-echo NEAR FAR\n"
+        "                    mix a synthetic echo of FAR.wav into NEAR.wav and\n"
+        "                    report how much the echo canceller removes\n"
+        "  --paste-failed    the last paste did not arrive intact; avoid its\n"
+        "                    method for that kind of window from now on\n"
+        "  --clipboard-ok    allow clipboard paste for the kind of window the\n"
+        "                    last text went to\n"
+        "  --fast-keys-ok    allow fast typing for the kind of window the last\n"
+        "                    text went to\n"
+        "  --profile DIR     sample the inference and UI threads; write collapsed\n"
+        "                    stacks (flamegraph input) to DIR on exit; needs a\n"
+        "                    build with -DLIVE_WHISPER_PROFILER=ON\n"
+        "  --profile-hz N    samples per second of thread CPU time (default 99)\n"
+        "  --batch OUT FILE.wav...\n"
+        "                    transcribe whole files with a pool of worker\n"
+        "                    processes; JSON lines to OUT (- for stdout)\n"
+        "  --workers N       batch worker processes (default: one per core, or\n"
+        "                    one per NUMA node using all its cores)\n"
+        "  --no-numa         batch: leave workers unbound on multi-socket machines\n"
+        "  --cancel          stop a running instance typing its text\n"
+        "  --variant NAME    run this session with a config variant instead of\n"
+        "                    the experiment's assignment\n"
+        "  -h, --help        show this help\n",
+        argv0);
 }
 
-int main()
+static bool parse_args(int argc, char** argv, Options* opts)
+{
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            std::exit(0);
+        } else if (arg == "--headless") {
+            opts->headless = true;
+        } else if (arg == "--output" && i + 1 < argc) {
+            opts->output = argv[++i];
+            opts->headless = true;
+        } else if (arg == "--type-live") {
+            opts->type_live = true;
+            opts->headless = true;
+        } else if (arg == "--low-latency") {
+            opts->low_latency = true;
+        } else if (arg == "--epp") {
+            opts->epp = true;
+        } else if (arg == "--bench" && i + 1 < argc) {
+            opts->bench_wav = argv[++i];
+        } else if (arg == "--contention" && i + 1 < argc) {
+            opts->contention_cores = std::atoi(argv[++i]);
+        } else if (arg == "--stress" && i + 1 < argc) {
+            std::string kind = argv[++i];
+            if (kind == "cpu") {
+                opts->stress_kind = bench::StressKind::Cpu;
+            } else if (kind == "memory" || kind == "mem") {
+                opts->stress_kind = bench::StressKind::Memory;
+            } else if (kind == "mixed") {
+                opts->stress_kind = bench::StressKind::Mixed;
+            } else {
+                std::fprintf(stderr, "Unknown --stress %s\n", kind.c_str());
+                return false;
+            }
+        } else if (arg == "--bench-soak" && i + 1 < argc) {
+            opts->soak_wav = argv[++i];
+        } else if (arg == "--soak-minutes" && i + 1 < argc) {
+            opts->soak_minutes = std::atoi(argv[++i]);
+        } else if (arg == "--soak-speed" && i + 1 < argc) {
+            opts->soak_speed = std::atof(argv[++i]);
+        } else if (arg == "--raster-font") {
+            opts->raster_font = true;
+        } else if (arg == "--stock-renderer") {
+            opts->stock_renderer = true;
+        } else if (arg == "--bench-render" && i + 1 < argc) {
+            opts->bench_render_frames = std::atoi(argv[++i]);
+        } else if (arg == "--prefix-decode") {
+            opts->decoding = Transcriber::Decoding::ForcedPrefix;
+        } else if (arg == "--echo-cancel") {
+            opts->echo_cancel = true;
+        } else if (arg == "--bench-echo" && i + 2 < argc) {
+            opts->bench_echo_near = argv[++i];
+            opts->bench_echo_far  = argv[++i];
+        } else if (arg == "--profile" && i + 1 < argc) {
+            opts->profile_dir = argv[++i];
+        } else if (arg == "--profile-hz" && i + 1 < argc) {
+            opts->profile_hz = std::atoi(argv[++i]);
+        } else if (arg == "--paste-failed") {
+            opts->paste_failed = true;
+        } else if (arg == "--clipboard-ok") {
+            opts->clipboard_ok = true;
+        } else if (arg == "--fast-keys-ok") {
+            opts->fast_keys_ok = true;
+        } else if (arg == "--cancel") {
+            opts->cancel = true;
+        } else if (arg == "--variant" && i + 1 < argc) {
+            opts->variant = argv[++i];
+        } else if (arg == "--workers" && i + 1 < argc) {
+            opts->batch_workers = std::atoi(argv[++i]);
+        } else if (arg == "--batch" && i + 2 < argc) {
+            opts->batch_output = argv[++i];
+            while (i + 1 < argc && std::strncmp(argv[i + 1], "--", 2) != 0)
+                opts->batch_inputs.push_back(argv[++i]);
+        } else if (arg == "--worker" && i + 1 < argc) {
+            opts->worker_socket = argv[++i];
+        } else if (arg == "--model" && i + 1 < argc) {
+            opts->worker_model = argv[++i];
+        } else if (arg == "--worker-threads" && i + 1 < argc) {
+            opts->worker_threads = std::atoi(argv[++i]);
+        } else if (arg == "--worker-node" && i + 1 < argc) {
+            opts->worker_node = std::atoi(argv[++i]);
+        } else if (arg == "--no-numa") {
+            opts->numa = false;
+        } else {
+            print_usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Headless mode: no overlay, results go to a JSON-lines stream until
+// SIGINT/SIGTERM, then the remaining audio is flushed as a final result.
+// ---------------------------------------------------------------------------
+static std::atomic<bool> g_quit{false};
+
+static void handle_quit_signal(int) { g_quit = true; }
+
+static int run_headless(const Options& opts)
 {
+    std::signal(SIGINT,  handle_quit_signal);
+    std::signal(SIGTERM, handle_quit_signal);
+    std::signal(SIGPIPE, SIG_IGN);  // reader went away — the stream reports it
+
+    ResultStream stream;
+    if (!stream.init(opts.output)) {
+        std::fprintf(stderr, "Failed to open result stream %s\n", opts.output.c_str());
+        return 1;
+    }
+
+    AudioCapture audio;
+    if (!audio.init(opts.echo_cancel)) {
+        std::fprintf(stderr, "Failed to init audio capture\n");
+        return 1;
+    }
+
+    Transcriber transcriber;
+    if (!init_transcriber(transcriber, opts.decoding)) return 1;
+
+    metrics::Server metrics_server;
+    metrics_server.init(metrics::socket_path());
+    profiler::register_thread("main");
+
+    LatencyHint latency;
+    if (opts.low_latency)
+        latency.init(LOW_LATENCY_US, opts.epp);
+
+    // Live typing follows the stable prefix of partials and the whole text
+    // of finals; the keys are sent from this thread, off the inference path
+    paste::LiveTyper typer;
+    std::mutex live_mutex;
+    std::string live_text;
+    bool live_dirty = false;
+    bool type_live = opts.type_live;
+    auto type_pending = [&] {
+        std::string text;
+        {
+            std::lock_guard<std::mutex> lock(live_mutex);
+            if (!live_dirty) return;
+            text = live_text;
+            live_dirty = false;
+        }
+        if (type_live && !typer.update(text)) {
+            std::fprintf(stderr, "No virtual keyboard; live typing disabled\n");
+            type_live = false;
+        }
+    };
+
+    transcriber.set_result_callback([&](const Transcriber::Result& r) {
+        if (r.final)
+            stream.final(r.text, r.audio_seconds);
+        else
+            stream.partial(r.text, r.stable, r.audio_seconds);
+        if (opts.type_live) {
+            std::lock_guard<std::mutex> lock(live_mutex);
+            live_text = r.final ? r.text : r.stable;
+            live_dirty = true;
+        }
+    });
+    transcriber.start();
+
+    std::vector<float> audio_buf;
+    while (!g_quit.load()) {
+        pump_audio(audio, transcriber, audio_buf);
+        type_pending();
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+
+    audio.shutdown();
+    transcriber.finish();
+    type_pending();
+    latency.shutdown();
+    transcriber.shutdown();
+    stream.shutdown();
+
+    if (stream.dropped() > 0)
+        std::fprintf(stderr, "%llu result events dropped (slow reader)\n",
+                     static_cast<unsigned long long>(stream.dropped()));
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options opts;
+    if (!parse_args(argc, argv, &opts)) return 2;
+    if (opts.cancel) return cancel_delivery();
+    if (!opts.worker_socket.empty())
+        return batch::run_worker(opts.worker_socket, opts.worker_model, opts.worker_threads,
+                                 opts.worker_node);
+    if (!opts.profile_dir.empty()) {
+        if (!profiler::start(opts.profile_dir, opts.profile_hz)) return 1;
+        std::atexit(profiler::stop);  // covers every return path below
+    }
+    if (opts.paste_failed) {
+        DeliveryCache cache;
+        cache.load();
+        return cache.mark_last_failed() && cache.save() ? 0 : 1;
+    }
+    if (opts.clipboard_ok || opts.fast_keys_ok) {
+        DeliveryCache cache;
+        cache.load();
+        bool ok = (!opts.clipboard_ok || cache.allow_last(paste::Method::Clipboard))
+               && (!opts.fast_keys_ok || cache.allow_last(paste::Method::FastKeys));
+        return ok && cache.save() ? 0 : 1;
+    }
+
+    // Runtime tuning, kept current for the rest of the session
+    config::load();
+    if (config::watch()) std::atexit(config::unwatch);
+
+    if (opts.bench_render_frames > 0) return bench::run_render(opts.bench_render_frames);
+    if (!opts.bench_echo_near.empty())
+        return bench::run_echo(opts.bench_echo_near, opts.bench_echo_far);
+    if (!opts.batch_output.empty()) {
+        std::string model_path = find_model_or_report();
+        if (model_path.empty()) return 1;
+        return batch::run_coordinator(opts.batch_inputs, opts.batch_output, model_path,
+                                      opts.batch_workers, opts.numa);
+    }
+    if (!opts.soak_wav.empty()) {
+        Transcriber transcriber;
+        if (!init_transcriber(transcriber, opts.decoding)) return 1;
+        return bench::run_soak(transcriber, opts.soak_wav, opts.soak_minutes,
+                               opts.soak_speed > 0.0 ? opts.soak_speed : 1.0);
+    }
+    if (!opts.bench_wav.empty()) {
+        Transcriber transcriber;
+        if (!init_transcriber(transcriber, opts.decoding)) return 1;
+        if (opts.contention_cores >= 0) {
+            LatencyHint latency;
+            if (opts.low_latency)
+                latency.init(LOW_LATENCY_US, opts.epp);
+            return bench::run_contention(transcriber, opts.bench_wav,
+                                         opts.contention_cores, opts.stress_kind);
+        }
+        return bench::run_jitter(transcriber, opts.bench_wav,
+                                 opts.low_latency ? LOW_LATENCY_US : -1, opts.epp);
+    }
+    if (opts.headless) return run_headless(opts);
+
+    // Interactive sessions take part in the experiment, if one is configured
+    experiment::begin(opts.variant);
+
     // Capture focus before overlay appears
-    std::string focus_addr = paste::capture_focus();
+    paste::Target focus = paste::capture_focus();
 
     // Init overlay
     Overlay overlay;
-    if (!overlay.init(OVERLAY_HEIGHT)) {
+    if (!overlay.init(config::current().overlay_height)) {
         std::fprintf(stderr, "Failed to init overlay\n");
         return 1;
     }
 
     // Init audio
     AudioCapture audio;
-    if (!audio.init()) {
+    if (!audio.init(opts.echo_cancel)) {
         std::fprintf(stderr, "Failed to init audio capture\n");
         return 1;
     }
 
     // Init transcriber
     Transcriber transcriber;
-    std::string model_path = find_model();
-    if (model_path.empty()) {
-        std::fprintf(stderr,
-            "Could not find %s. Searched:\n"
-            "  $LIVE_WHISPER_MODEL          (env var, exact path)\n"
-            "  %s/\n"
-            "  $XDG_DATA_HOME/live-whisper/\n"
-            "  /usr/local/share/live-whisper/\n"
-            "  /usr/share/live-whisper/\n"
-            "  models/                       (relative, for development)\n"
-            "\n"
-            "Install with: cmake --install build --prefix ~/.local\n",
-            MODEL_NAME, LIVE_WHISPER_DATADIR);
-        return 1;
-    }
-    if (!transcriber.init(model_path)) {
-        std::fprintf(stderr, "Failed to init transcriber with %s\n", model_path.c_str());
-        return 1;
-    }
+    if (!init_transcriber(transcriber, opts.decoding)) return 1;
     transcriber.start();
+    auto session_start = std::chrono::steady_clock::now();
+
+    // Live metrics for live-whisper-stat
+    metrics::Server metrics_server;
+    metrics_server.init(metrics::socket_path());
+    metrics::register_thread("ui");
+    profiler::register_thread("ui");
+    metrics::Histogram* frame_ms = metrics::histogram("frame_ms");
+
+    LatencyHint latency;
+    if (opts.low_latency)
+        latency.init(LOW_LATENCY_US, opts.epp);
 
     // Init ImGui
     IMGUI_CHECKVERSION();
@@ -178,42 +615,99 @@ int main()
     float scale = static_cast<float>(overlay.scale());
     if (scale < 1.0f) scale = 1.0f;
 
-    apply_style(scale);
-    ImGui::UseCustomFont(io, BASE_FONT_SIZE * scale);
+    ui::apply_style(scale);
+    if (opts.raster_font)
+        ImGui::UseCustomFont(io, BASE_FONT_SIZE * scale);
+    else
+        ImGui::UseSdfFont(io, BASE_FONT_SIZE * scale);
 
     ImGui_ImplWayland::Init(&overlay);
-    ImGui_ImplOpenGL3_Init("#version 300 es");
+    bool stock_renderer = opts.stock_renderer;
+    if (!stock_renderer && !ImGui_ImplGLES::Init(ImGui::SdfFontActive())) {
+        std::fprintf(stderr, "Falling back to the stock OpenGL3 renderer\n");
+        stock_renderer = true;
+    }
+    if (stock_renderer)
+        ImGui_ImplOpenGL3_Init("#version 300 es");
 
     // Text buffer for the editable area
     static char text_buf[64 * 1024] = {};
     bool accepted = false;
     bool user_edited = false;
-    bool auto_enter = true;
-    std::string last_transcription;
-
-    // Audio read buffer
-    std::vector<float> audio_buf(READ_BUF_SIZE);
-
-    // Live text update callback — only auto-update if user hasn't manually edited
-    transcriber.set_callback([&](const std::string& text) {
-        if (!user_edited) {
-            std::strncpy(text_buf, text.c_str(), sizeof(text_buf) - 1);
-            text_buf[sizeof(text_buf) - 1] = '\0';
-        }
-        last_transcription = text;
+    auto accept_time = std::chrono::steady_clock::time_point{};
+
+    Transcript transcript;
+    ui::State state;
+    state.text       = text_buf;
+    state.text_cap   = sizeof(text_buf);
+    state.transcript = &transcript;
+
+    // Audio read buffer, sized by pump_audio()
+    std::vector<float> audio_buf;
+
+    // Results arrive on the inference thread; only the UI thread touches
+    // text_buf, so the latest one is parked here until the next frame.
+    std::mutex pending_mutex;
+    bool       pending_ready = false;
+    std::string pending_text;
+    std::vector<Transcriber::TextSpan> pending_spans;
+    uint32_t   pending_segment = 0;
+    experiment::Outcome outcome;  // first_partial_ms under pending_mutex
+    transcriber.set_result_callback([&](const Transcriber::Result& r) {
+        std::lock_guard<std::mutex> lk(pending_mutex);
+        if (outcome.first_partial_ms < 0.0 && !r.text.empty())
+            outcome.first_partial_ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - session_start).count();
+        pending_text    = r.text;
+        pending_spans   = r.spans;
+        pending_segment = r.segment;
+        pending_ready   = true;
     });
+    uint32_t live_segment = 0;
+    bool     live_stale   = false;  // the user edited around the current span
+    std::vector<Transcriber::TextSpan> live_spans;  // timings of state.live_text
+
+    // Span re-decode in flight: its replacement lands in text_buf at
+    // [redecode_pos, redecode_pos + redecode_len) unless an edit intervenes
+    std::atomic<int> redecode_id{0};  // bumped per request and per edit
+    int         redecode_pos = 0;
+    int         redecode_len = 0;
+    bool        redecode_ready = false;
+    std::string redecode_text;
+    auto        notice_until = std::chrono::steady_clock::time_point{};
+    bool        cover_text   = false;  // text changed: check the fonts cover it
+
+    // Begin an ImGui frame / render it at physical framebuffer resolution
+    auto begin_frame = [&] {
+        overlay.make_current();
+        if (stock_renderer)
+            ImGui_ImplOpenGL3_NewFrame();
+        else
+            ImGui_ImplGLES::NewFrame();
+        ImGui_ImplWayland::NewFrame();
+        ImGui::NewFrame();
+        if (stock_renderer)
+            ImGui::SdfFontNewFrame();
+    };
+    auto render_frame = [&] {
+        glViewport(0, 0, overlay.fb_width(), overlay.fb_height());
+        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+        glClear(GL_COLOR_BUFFER_BIT);
+
+        ImGui::Render();
+        if (stock_renderer)
+            ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        else
+            ImGui_ImplGLES::RenderDrawData(ImGui::GetDrawData());
+    };
 
     // Main loop
     while (overlay.dispatch()) {
-        // Read audio and feed to transcriber
-        uint32_t avail = audio.available();
-        while (avail > 0) {
-            uint32_t to_read = avail < READ_BUF_SIZE ? avail : READ_BUF_SIZE;
-            uint32_t got = audio.read(audio_buf.data(), to_read);
-            if (got == 0) break;
-            transcriber.process(audio_buf.data(), got);
-            avail = audio.available();
-        }
+        auto frame_start = std::chrono::steady_clock::now();
+
+        // Read audio and feed to transcriber; pick up config changes
+        pump_audio(audio, transcriber, audio_buf);
+        overlay.set_height(config::current().overlay_height);
 
         // Check for Enter/Escape from raw events before ImGui consumes them
         for (const auto& ev : overlay.peek_events()) {
@@ -223,100 +717,190 @@ int main()
             }
             if (ev.keysym == XKB_KEY_Return || ev.keysym == XKB_KEY_KP_Enter) {
                 accepted = true;
+                accept_time = std::chrono::steady_clock::now();
                 overlay.request_close();
             }
         }
 
-        // Begin ImGui frame
-        overlay.make_current();
-        ImGui_ImplOpenGL3_NewFrame();
-        ImGui_ImplWayland::NewFrame();
-        ImGui::NewFrame();
+        // Merge fonts for characters the last frame had no glyphs for, and
+        // keep checking until the lookups for them have come back
+        if (cover_text) cover_text = ImGui::FontCoverText(text_buf);
+
+        begin_frame();
+
+        // Splice the latest result into its span. A new segment (speech
+        // after an edit) gets a new span at the caret, or at the end if the
+        // user never edited; results for a span the user edited around are
+        // dropped.
+        {
+            std::lock_guard<std::mutex> lk(pending_mutex);
+            if (pending_ready && (pending_segment != live_segment || !live_stale)) {
+                if (pending_segment != live_segment) {
+                    live_segment   = pending_segment;
+                    live_stale     = false;
+                    transcript.settle();
+                    state.live_pos = user_edited ? state.cursor
+                                                 : static_cast<int>(transcript.size());
+                    state.live_len = 0;
+                }
+                state.live_text  = std::move(pending_text);
+                state.live_dirty = true;
+                cover_text       = true;
+                live_spans = std::move(pending_spans);
+            }
+            pending_ready = false;
+
+            if (redecode_ready) {
+                redecode_ready = false;
+                if (!redecode_text.empty()) {
+                    state.live_pos   = redecode_pos;
+                    state.live_len   = redecode_len;
+                    state.live_text  = std::move(redecode_text);
+                    state.live_dirty = true;
+                    cover_text       = true;
+                    state.notice.clear();
+                } else {
+                    state.notice = "Re-decode found no speech";
+                    notice_until = frame_start + std::chrono::seconds(3);
+                }
+            }
+        }
+        if (!state.notice.empty() && notice_until != std::chrono::steady_clock::time_point{}
+            && frame_start > notice_until)
+            state.notice.clear();
 
         // Full-window overlay UI
-        ImGui::SetNextWindowPos(ImVec2(0, 0));
-        ImGui::SetNextWindowSize(io.DisplaySize);
-        ImGui::Begin("##overlay", nullptr,
-                     ImGuiWindowFlags_NoTitleBar |
-                     ImGuiWindowFlags_NoResize |
-                     ImGuiWindowFlags_NoMove |
-                     ImGuiWindowFlags_NoScrollbar |
-                     ImGuiWindowFlags_NoCollapse |
-                     ImGuiWindowFlags_NoBringToFrontOnFocus);
-
-        // Header bar
-        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.55f, 0.55f, 0.60f, 1.0f));
-        ImGui::Text("LIVE-WHISPER");
-        ImGui::PopStyleColor();
-        ImGui::SameLine(io.DisplaySize.x - ImGui::CalcTextSize("Enter: accept  |  Esc: cancel").x
-                        - ImGui::GetStyle().WindowPadding.x);
-        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.40f, 0.40f, 0.45f, 1.0f));
-        ImGui::Text("Enter: accept  |  Esc: cancel");
-        ImGui::PopStyleColor();
-
-        ImGui::Spacing();
-        ImGui::Separator();
-        ImGui::Spacing();
-
-        // Text area fills remaining space minus status line
-        float status_height = ImGui::GetFrameHeightWithSpacing() + ImGui::GetStyle().ItemSpacing.y;
-        float text_height = ImGui::GetContentRegionAvail().y - status_height;
-        if (ImGui::InputTextMultiline("##text", text_buf, sizeof(text_buf),
-                                      ImVec2(-1.0f, text_height),
-                                      ImGuiInputTextFlags_AllowTabInput |
-                                      ImGuiInputTextFlags_WordWrap)) {
-            // User typed or edited — stop auto-updating
-            user_edited = true;
+        state.recording_seconds = transcriber.recording_seconds();
+        if (ui::draw(state)) {
+            // Pause passes while the user types; speech afterwards is
+            // inserted at the caret as a new segment
+            user_edited      = true;
+            live_stale       = true;
+            state.live_dirty = false;
+            transcript.settle();
+            cover_text       = true;
+            ++redecode_id;
+            ++outcome.edits;
+            transcriber.pause();
         }
 
-        // Status line
-        float secs = transcriber.recording_seconds();
-        int mins = static_cast<int>(secs) / 60;
-        int s    = static_cast<int>(secs) % 60;
-        ImGui::TextDisabled("Recording %d:%02d", mins, s);
-
-        ImGui::SameLine(ImGui::GetContentRegionAvail().x + ImGui::GetCursorPosX()
-                        - ImGui::CalcTextSize("Send Enter").x - ImGui::GetFrameHeight()
-                        - ImGui::GetStyle().ItemSpacing.x);
-        ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.45f, 0.45f, 0.50f, 1.0f));
-        ImGui::PushStyleColor(ImGuiCol_CheckMark, ImVec4(0.45f, 0.45f, 0.50f, 1.0f));
-        ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.15f, 0.15f, 0.18f, 1.0f));
-        ImGui::PushStyleColor(ImGuiCol_FrameBgHovered, ImVec4(0.20f, 0.20f, 0.24f, 1.0f));
-        ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(3.0f, 3.0f));
-        ImGui::Checkbox("Send Enter", &auto_enter);
-        ImGui::PopStyleVar();
-        ImGui::PopStyleColor(4);
-
-        ImGui::End();
-
-        // Render at physical framebuffer resolution
-        glViewport(0, 0, overlay.fb_width(), overlay.fb_height());
-        glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        // Ctrl+R: re-decode the audio behind the selected words. Only the
+        // live span has timings, so the selection must lie inside it. The
+        // fix counts as an edit: passes pause so they cannot overwrite it.
+        if (state.redecode_requested) {
+            state.redecode_requested = false;
+            size_t a = static_cast<size_t>(std::max(0, state.sel_begin - state.live_origin));
+            size_t b = static_cast<size_t>(std::max(0, state.sel_end - state.live_origin));
+            size_t from = SIZE_MAX, to = 0;
+            float t0 = 0.0f, t1 = 0.0f;
+            if (!live_stale && !state.live_dirty && state.sel_begin >= state.live_origin) {
+                for (const Transcriber::TextSpan& span : live_spans) {
+                    if (span.end <= a || span.begin >= b) continue;
+                    if (from == SIZE_MAX) t0 = span.t0;
+                    from = std::min(from, span.begin);
+                    to   = std::max(to, span.end);
+                    t1   = span.t1;
+                }
+            }
+            if (from < to) {
+                user_edited  = true;
+                live_stale   = true;
+                transcript.settle();
+                redecode_pos = state.live_origin + static_cast<int>(from);
+                redecode_len = static_cast<int>(to - from);
+                int id = ++redecode_id;
+                ++outcome.redecodes;
+                transcriber.pause();
+                transcriber.redecode(t0, t1, state.live_text.substr(0, from),
+                                     [&, id](const std::string& text) {
+                    std::lock_guard<std::mutex> lk(pending_mutex);
+                    if (id != redecode_id) return;
+                    redecode_text  = text;
+                    redecode_ready = true;
+                });
+                state.notice = "Re-decoding selection...";
+                notice_until = {};
+            } else {
+                state.notice = "Select words transcribed since the last edit";
+                notice_until = frame_start + std::chrono::seconds(3);
+            }
+        }
 
-        ImGui::Render();
-        ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+        render_frame();
+        frame_ms->record(std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - frame_start).count());
         overlay.swap_buffers();
     }
 
-    // Tear down overlay first so keyboard grab is released
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplWayland::Shutdown();
-    ImGui::DestroyContext();
-    overlay.shutdown();
+    // Type text if accepted, before tearing anything down: the stale pass is
+    // aborted but not waited for, and the overlay shrinks to a passive strip,
+    // which releases the keyboard grab, while a worker types. Audio and the
+    // transcriber wind down behind it. `live-whisper --cancel` stops the
+    // typing between key batches.
+    transcriber.cancel();
+    bool deliver = accepted && text_buf[0] != '\0';
+    std::string text = text_buf;
+    std::atomic<bool> delivered{false};
+    std::thread worker;
+    if (deliver) {
+        overlay.set_indicator(INDICATOR_HEIGHT);
+        // Handler first: once the pid is published `--cancel` may fire
+        std::signal(SIGUSR1, handle_cancel_signal);
+        write_pidfile();
+        bool auto_enter = state.auto_enter;
+        worker = std::thread([&, auto_enter] {
+            bool ok = paste::refocus_and_deliver(focus, text, &g_delivery);
+            if (ok && auto_enter) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(50));
+                paste::type_text("\n");
+            }
+            delivered = true;
+        });
+    }
 
     audio.shutdown();
     transcriber.stop();
-    transcriber.shutdown();
-
-    // Type text if accepted (overlay is gone, target window can receive input)
-    if (accepted && text_buf[0] != '\0') {
-        paste::refocus_and_type(focus_addr, text_buf);
-        if (auto_enter) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(50));
-            paste::type_text("\n");
+    latency.shutdown();
+    // The process exits next; freeing the model would only delay that
+    transcriber.abandon();
+
+    // Words in the final text: edits per word approximate the error rate
+    outcome.accepted = accepted;
+    for (const char* p = text_buf; *p; ++p)
+        if (!std::isspace(static_cast<unsigned char>(*p))
+            && (p == text_buf || std::isspace(static_cast<unsigned char>(p[-1]))))
+            ++outcome.words;
+
+    if (deliver) {
+        while (!delivered.load() && overlay.dispatch()) {
+            begin_frame();
+            ui::draw_progress(g_delivery.done.load(), g_delivery.total.load());
+            render_frame();
+            overlay.swap_buffers();
+        }
+        worker.join();
+        unlink(pidfile_path().c_str());
+
+        if (g_delivery.cancel.load())
+            std::fprintf(stderr, "Delivery cancelled after %zu of %zu characters\n",
+                         g_delivery.done.load(), g_delivery.total.load());
+        if (g_delivery.done.load() > 0) {
+            outcome.accept_ms = std::chrono::duration<double, std::milli>(
+                g_delivery.first_key - accept_time).count();
+            metrics::histogram("accept_ms")->record(outcome.accept_ms);
         }
     }
+    experiment::finish(outcome, transcriber.recording_seconds());
+
+    ImGui::FontShutdown();
+    ImGui::SdfFontShutdown();
+    if (stock_renderer)
+        ImGui_ImplOpenGL3_Shutdown();
+    else
+        ImGui_ImplGLES::Shutdown();
+    ImGui_ImplWayland::Shutdown();
+    ImGui::DestroyContext();
+    overlay.shutdown();
 
     return 0;
 }
@@ -0,0 +1,419 @@
+#include "metrics.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+static constexpr int    CLIENT_TIMEOUT_MS = 200;
+static constexpr double PERCENTILES[]     = {50.0, 90.0, 99.0};
+
+static const timespec g_start = [] {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts;
+}();
+
+// ---------------------------------------------------------------------------
+// Allocation counting: replace global operator new so every C++ heap
+// allocation costs one relaxed atomic add.
+// ---------------------------------------------------------------------------
+static std::atomic<uint64_t> g_allocs{0};
+static std::atomic<uint64_t> g_alloc_bytes{0};
+
+void* operator new(std::size_t size)
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    g_allocs.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept
+{
+    return operator new(size, tag);
+}
+
+// The default operator delete releases with free(), matching the above.
+
+namespace metrics {
+
+// ---------------------------------------------------------------------------
+// Registry
+// ---------------------------------------------------------------------------
+struct ThreadEntry {
+    std::string name;
+    pthread_t   thread;
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::map<std::string, std::unique_ptr<Counter>>   counters;
+    std::map<std::string, std::unique_ptr<Gauge>>     gauges;
+    std::map<std::string, std::unique_ptr<Histogram>> histograms;
+    std::map<std::string, std::string>                labels;
+    std::vector<ThreadEntry> threads;
+};
+
+static Registry& registry()
+{
+    static Registry* r = new Registry;  // never destroyed: metrics outlive statics
+    return *r;
+}
+
+template <typename T>
+static T* lookup(std::map<std::string, std::unique_ptr<T>>& map, const char* name)
+{
+    std::lock_guard<std::mutex> lk(registry().mutex);
+    auto& slot = map[name];
+    if (!slot) slot = std::make_unique<T>();
+    return slot.get();
+}
+
+Counter*   counter(const char* name)   { return lookup(registry().counters, name); }
+Gauge*     gauge(const char* name)     { return lookup(registry().gauges, name); }
+Histogram* histogram(const char* name) { return lookup(registry().histograms, name); }
+
+uint64_t allocations()    { return g_allocs.load(std::memory_order_relaxed); }
+uint64_t allocated_bytes() { return g_alloc_bytes.load(std::memory_order_relaxed); }
+
+void set_label(const char* name, const std::string& value)
+{
+    std::lock_guard<std::mutex> lk(registry().mutex);
+    registry().labels[name] = value;
+}
+
+void Histogram::record(double v)
+{
+    buckets[bucket_index(v)].fetch_add(1, std::memory_order_relaxed);
+    count.fetch_add(1, std::memory_order_relaxed);
+    sum_micro.fetch_add(static_cast<uint64_t>(v > 0.0 ? v * 1e6 : 0.0),
+                        std::memory_order_relaxed);
+
+    double prev = max.load(std::memory_order_relaxed);
+    while (v > prev && !max.compare_exchange_weak(prev, v, std::memory_order_relaxed)) {}
+}
+
+void register_thread(const char* name)
+{
+    std::lock_guard<std::mutex> lk(registry().mutex);
+    registry().threads.push_back({name, pthread_self()});
+}
+
+void unregister_thread()
+{
+    std::lock_guard<std::mutex> lk(registry().mutex);
+    auto& threads = registry().threads;
+    pthread_t self = pthread_self();
+    for (size_t i = 0; i < threads.size(); ++i) {
+        if (pthread_equal(threads[i].thread, self)) {
+            threads.erase(threads.begin() + i);
+            return;
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Snapshots
+// ---------------------------------------------------------------------------
+static double hist_percentile(const Histogram& h, double p)
+{
+    uint64_t total = h.count.load(std::memory_order_relaxed);
+    if (total == 0) return 0.0;
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    uint64_t seen = 0;
+    for (int i = 0; i < HIST_BUCKETS; ++i) {
+        seen += h.buckets[i].load(std::memory_order_relaxed);
+        if (seen >= target && seen > 0) return bucket_upper(i);
+    }
+    return bucket_upper(HIST_BUCKETS - 1);
+}
+
+long rss_kb()
+{
+    FILE* f = std::fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    long size = 0, resident = 0;
+    int n = std::fscanf(f, "%ld %ld", &size, &resident);
+    std::fclose(f);
+    return n == 2 ? resident * (sysconf(_SC_PAGESIZE) / 1024) : 0;
+}
+
+static double thread_cpu_ms(pthread_t thread)
+{
+    clockid_t clock;
+    timespec ts;
+    if (pthread_getcpuclockid(thread, &clock) != 0) return 0.0;
+    if (clock_gettime(clock, &ts) != 0) return 0.0;
+    return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+// Flat list of (name, value) pairs shared by both output formats; histogram
+// buckets are carried separately as they are a list.
+struct Sample {
+    std::string name;
+    double      value;
+};
+
+static void collect(std::vector<Sample>* samples,
+                    std::vector<std::pair<std::string, std::string>>* bucket_lists,
+                    std::vector<std::pair<std::string, std::string>>* labels)
+{
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lk(r.mutex);
+
+    labels->assign(r.labels.begin(), r.labels.end());
+
+    for (const auto& [name, c] : r.counters)
+        samples->push_back({name, static_cast<double>(c->value.load())});
+    for (const auto& [name, g] : r.gauges)
+        samples->push_back({name, g->value.load()});
+
+    for (const auto& [name, h] : r.histograms) {
+        samples->push_back({name + ".count", static_cast<double>(h->count.load())});
+        samples->push_back({name + ".sum", h->sum_micro.load() / 1e6});
+        samples->push_back({name + ".max", h->max.load()});
+        for (double p : PERCENTILES) {
+            char key[16];
+            std::snprintf(key, sizeof(key), ".p%.0f", p);
+            samples->push_back({name + key, hist_percentile(*h, p)});
+        }
+
+        std::string list;
+        for (int i = 0; i < HIST_BUCKETS; ++i) {
+            if (i) list += ' ';
+            list += std::to_string(h->buckets[i].load());
+        }
+        bucket_lists->push_back({name, list});
+    }
+
+    samples->push_back({"allocs", static_cast<double>(g_allocs.load())});
+    samples->push_back({"alloc_bytes", static_cast<double>(g_alloc_bytes.load())});
+    samples->push_back({"rss_kb", static_cast<double>(rss_kb())});
+
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    samples->push_back({"cpu_ms.process", ts.tv_sec * 1e3 + ts.tv_nsec / 1e6});
+    for (const ThreadEntry& t : r.threads)
+        samples->push_back({"cpu_ms." + t.name, thread_cpu_ms(t.thread)});
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    samples->push_back({"mono_s", ts.tv_sec + ts.tv_nsec / 1e9});  // for rates
+    samples->push_back({"uptime_s", (ts.tv_sec - g_start.tv_sec)
+                                    + (ts.tv_nsec - g_start.tv_nsec) / 1e9});
+}
+
+std::string snapshot_text()
+{
+    std::vector<Sample> samples;
+    std::vector<std::pair<std::string, std::string>> bucket_lists;
+    std::vector<std::pair<std::string, std::string>> labels;
+    collect(&samples, &bucket_lists, &labels);
+
+    std::string out;
+    char line[256];
+    for (const Sample& s : samples) {
+        std::snprintf(line, sizeof(line), "%s %.6g\n", s.name.c_str(), s.value);
+        out += line;
+    }
+    for (const auto& [name, list] : bucket_lists)
+        out += name + ".buckets " + list + "\n";
+    for (const auto& [name, value] : labels)
+        out += name + " " + value + "\n";
+    return out;
+}
+
+std::string snapshot_json()
+{
+    std::vector<Sample> samples;
+    std::vector<std::pair<std::string, std::string>> bucket_lists;
+    std::vector<std::pair<std::string, std::string>> labels;
+    collect(&samples, &bucket_lists, &labels);
+
+    std::string out = "{";
+    char buf[64];
+    for (const Sample& s : samples) {
+        if (out.size() > 1) out += ',';
+        std::snprintf(buf, sizeof(buf), "%.6g", s.value);
+        out += "\"" + s.name + "\":" + buf;
+    }
+    for (const auto& [name, list] : bucket_lists) {
+        std::string arr = list;
+        for (char& c : arr)
+            if (c == ' ') c = ',';
+        out += ",\"" + name + ".buckets\":[" + arr + "]";
+    }
+    for (const auto& [name, value] : labels) {
+        std::string quoted;
+        for (char c : value) {
+            if (c == '"' || c == '\\') quoted += '\\';
+            quoted += c;
+        }
+        out += ",\"" + name + "\":\"" + quoted + "\"";
+    }
+    out += "}\n";
+    return out;
+}
+
+// ---------------------------------------------------------------------------
+// Server: one thread polling the listening socket and a wake-up pipe.
+// Requests are tiny and answered inline.
+// ---------------------------------------------------------------------------
+struct Server::Impl {
+    int         listen_fd = -1;
+    int         wake[2]   = {-1, -1};
+    std::string path;
+    dev_t       bound_dev = 0;   // identity of the socket file we created,
+    ino_t       bound_ino = 0;   // so shutdown never unlinks a successor's
+    std::thread thread;
+
+    void serve_loop();
+    void answer(int fd);
+};
+
+void Server::Impl::answer(int fd)
+{
+    char req[32] = {};
+    size_t got = 0;
+    while (got < sizeof(req) - 1) {
+        pollfd pfd{fd, POLLIN, 0};
+        if (poll(&pfd, 1, CLIENT_TIMEOUT_MS) <= 0) break;
+        ssize_t n = read(fd, req + got, sizeof(req) - 1 - got);
+        if (n <= 0) break;
+        got += static_cast<size_t>(n);
+        if (std::memchr(req, '\n', got)) break;
+    }
+
+    std::string body = std::strncmp(req, "json", 4) == 0 ? snapshot_json() : snapshot_text();
+    size_t off = 0;
+    while (off < body.size()) {
+        ssize_t n = send(fd, body.data() + off, body.size() - off, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        off += static_cast<size_t>(n);
+    }
+}
+
+void Server::Impl::serve_loop()
+{
+    for (;;) {
+        pollfd fds[2] = {{listen_fd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) continue;
+        answer(fd);
+        close(fd);
+    }
+}
+
+Server::Server() : impl_(std::make_unique<Impl>()) {}
+Server::~Server() { shutdown(); }
+
+bool Server::init(const std::string& path)
+{
+    sockaddr_un addr{};
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "metrics: socket path too long: %s\n", path.c_str());
+        return false;
+    }
+
+    impl_->listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (impl_->listen_fd < 0) {
+        std::fprintf(stderr, "metrics: socket failed: %s\n", std::strerror(errno));
+        return false;
+    }
+
+    addr.sun_family = AF_UNIX;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+
+    // A leftover socket from a crashed run would make bind() fail, but one
+    // that still accepts belongs to a live instance and must be left alone
+    int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (probe >= 0) {
+        if (connect(probe, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0) {
+            std::fprintf(stderr, "metrics: %s is served by another instance\n",
+                         path.c_str());
+            close(probe);
+            close(impl_->listen_fd);
+            impl_->listen_fd = -1;
+            return false;
+        }
+        if (errno == ECONNREFUSED) unlink(path.c_str());
+        close(probe);
+    }
+
+    if (bind(impl_->listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+        || listen(impl_->listen_fd, 4) != 0) {
+        std::fprintf(stderr, "metrics: cannot listen on %s: %s\n",
+                     path.c_str(), std::strerror(errno));
+        close(impl_->listen_fd);
+        impl_->listen_fd = -1;
+        return false;
+    }
+    impl_->path = path;
+    struct stat st{};
+    if (stat(path.c_str(), &st) == 0) {
+        impl_->bound_dev = st.st_dev;
+        impl_->bound_ino = st.st_ino;
+    }
+
+    if (pipe2(impl_->wake, O_CLOEXEC) != 0) {
+        shutdown();
+        return false;
+    }
+    impl_->thread = std::thread([this] { impl_->serve_loop(); });
+    return true;
+}
+
+void Server::shutdown()
+{
+    if (impl_->thread.joinable()) {
+        char c = 0;
+        (void)!write(impl_->wake[1], &c, 1);
+        impl_->thread.join();
+    }
+    for (int& fd : impl_->wake) {
+        if (fd >= 0) close(fd);
+        fd = -1;
+    }
+    if (impl_->listen_fd >= 0) {
+        close(impl_->listen_fd);
+        impl_->listen_fd = -1;
+        struct stat st{};
+        if (stat(impl_->path.c_str(), &st) == 0 && impl_->bound_ino != 0
+            && st.st_dev == impl_->bound_dev && st.st_ino == impl_->bound_ino) {
+            unlink(impl_->path.c_str());
+        }
+    }
+}
+
+} // namespace metrics
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <string>
+
+// Process-wide counters, gauges and histograms, cheap enough to update from
+// the audio callback and the render loop, and a Unix-socket endpoint that
+// serves a snapshot of them to live-whisper-stat.
+namespace metrics {
+
+// ---------------------------------------------------------------------------
+// Histogram bucket layout, shared with tools/live_whisper_stat.cpp so it can
+// compute percentiles over the difference of two snapshots. Four buckets per
+// octave from 0.01 to about 141000: a pass or an Enter-to-key time of two
+// minutes in ms still lands below the top bucket.
+// ---------------------------------------------------------------------------
+static constexpr int    HIST_BUCKETS     = 96;
+static constexpr int    HIST_PER_OCTAVE  = 4;
+static constexpr double HIST_FIRST_BOUND = 0.01;  // upper bound of bucket 0
+
+inline double bucket_upper(int i)
+{
+    return HIST_FIRST_BOUND * std::pow(2.0, static_cast<double>(i) / HIST_PER_OCTAVE);
+}
+
+inline int bucket_index(double v)
+{
+    if (!(v > HIST_FIRST_BOUND)) return 0;
+    int i = static_cast<int>(std::ceil(std::log2(v / HIST_FIRST_BOUND) * HIST_PER_OCTAVE));
+    return i < HIST_BUCKETS ? i : HIST_BUCKETS - 1;
+}
+
+struct Counter {
+    std::atomic<uint64_t> value{0};
+    void add(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+};
+
+struct Gauge {
+    std::atomic<double> value{0.0};
+    void set(double v) { value.store(v, std::memory_order_relaxed); }
+};
+
+struct Histogram {
+    std::atomic<uint64_t> buckets[HIST_BUCKETS] = {};
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> sum_micro{0};   // sum of values * 1e6
+    std::atomic<double>   max{0.0};
+
+    void record(double v);
+};
+
+// Look up (creating on first use) a named metric. Pointers stay valid for
+// the life of the process; resolve them once, outside hot paths.
+Counter*   counter(const char* name);
+Gauge*     gauge(const char* name);
+Histogram* histogram(const char* name);
+
+// Process totals, as reported in snapshots: C++ heap allocations since
+// start and resident set size.
+uint64_t allocations();
+uint64_t allocated_bytes();
+long     rss_kb();
+
+// Attach a string label (e.g. the experiment variant) to every snapshot.
+void set_label(const char* name, const std::string& value);
+
+// Report CPU time of the calling thread under the given name until
+// unregister_thread() is called from the same thread.
+void register_thread(const char* name);
+void unregister_thread();
+
+// Snapshot of all metrics plus RSS, allocation counts and per-thread CPU
+// time, as "name value" lines or as one JSON object.
+std::string snapshot_text();
+std::string snapshot_json();
+
+// Default socket path: $XDG_RUNTIME_DIR/live-whisper.sock (or /tmp).
+inline std::string socket_path()
+{
+    const char* dir = std::getenv("XDG_RUNTIME_DIR");
+    return std::string(dir ? dir : "/tmp") + "/live-whisper.sock";
+}
+
+// Serve snapshots on a Unix stream socket. A client sends "text\n" or
+// "json\n" and receives one snapshot before the server closes the
+// connection.
+struct Server {
+    Server();
+    ~Server();
+
+    Server(const Server&) = delete;
+    Server& operator=(const Server&) = delete;
+
+    bool init(const std::string& path);
+    void shutdown();
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+} // namespace metrics
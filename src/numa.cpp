@@ -0,0 +1,94 @@
+#include "numa.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static constexpr int MAX_NODES = 1024;   // nodemask width passed to the kernel
+
+// "0-3,8,10-11" -> {0,1,2,3,8,10,11}
+static std::vector<int> parse_cpulist(const std::string& list)
+{
+    std::vector<int> cpus;
+    size_t pos = 0;
+    while (pos < list.size()) {
+        size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string range = list.substr(pos, end - pos);
+        int a = 0, b = 0;
+        int n = std::sscanf(range.c_str(), "%d-%d", &a, &b);
+        if (n == 1) b = a;
+        if (n >= 1)
+            for (int c = a; c <= b; ++c) cpus.push_back(c);
+        pos = end + 1;
+    }
+    return cpus;
+}
+
+namespace numa {
+
+std::vector<Node> nodes()
+{
+    std::vector<Node> out;
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) return out;
+
+    DIR* dir = opendir("/sys/devices/system/node");
+    if (!dir) return out;
+    while (dirent* ent = readdir(dir)) {
+        int id = -1;
+        if (std::sscanf(ent->d_name, "node%d", &id) != 1 || id < 0 || id >= MAX_NODES) continue;
+
+        std::ifstream in(std::string("/sys/devices/system/node/") + ent->d_name + "/cpulist");
+        std::string list;
+        if (!std::getline(in, list)) continue;
+
+        Node node;
+        node.id = id;
+        for (int cpu : parse_cpulist(list))
+            if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) node.cpus.push_back(cpu);
+        if (!node.cpus.empty()) out.push_back(std::move(node));
+    }
+    closedir(dir);
+
+    std::sort(out.begin(), out.end(), [](const Node& a, const Node& b) { return a.id < b.id; });
+    return out;
+}
+
+bool bind_process(int id)
+{
+    for (const Node& node : nodes()) {
+        if (node.id != id) continue;
+
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : node.cpus) CPU_SET(cpu, &set);
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            std::fprintf(stderr, "numa: cannot bind to node %d CPUs: %s\n", id, std::strerror(errno));
+            return false;
+        }
+
+        // Preferred rather than bound: a full node spills over instead of
+        // failing allocations
+        unsigned long mask[MAX_NODES / (8 * sizeof(unsigned long))] = {};
+        mask[id / (8 * sizeof(unsigned long))] |= 1ul << (id % (8 * sizeof(unsigned long)));
+        if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MAX_NODES) != 0) {
+            std::fprintf(stderr, "numa: cannot prefer node %d memory: %s\n", id, std::strerror(errno));
+            return false;
+        }
+        return true;
+    }
+    std::fprintf(stderr, "numa: no usable node %d\n", id);
+    return false;
+}
+
+} // namespace numa
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <vector>
+
+// NUMA topology from sysfs and process placement, without libnuma.
+namespace numa {
+
+struct Node {
+    int              id = 0;
+    std::vector<int> cpus;   // online CPUs of the node this process may use
+};
+
+// Nodes with usable CPUs. A single node on UMA machines; empty if the
+// kernel exposes no topology.
+std::vector<Node> nodes();
+
+// Run the calling process on the node's CPUs and prefer its memory for new
+// allocations. Threads created afterwards inherit both, so call this before
+// loading the model and starting compute threads.
+bool bind_process(int node);
+
+} // namespace numa
@@ -522,6 +522,29 @@ void Overlay::shutdown()
     }
 }
 
+void Overlay::set_indicator(int height)
+{
+    if (!impl_->layer_surface) return;
+    impl_->requested_height = height;
+    zwlr_layer_surface_v1_set_keyboard_interactivity(impl_->layer_surface,
+        ZWLR_LAYER_SURFACE_V1_KEYBOARD_INTERACTIVITY_NONE);
+    zwlr_layer_surface_v1_set_size(impl_->layer_surface,
+                                   static_cast<uint32_t>(impl_->configured_width), height);
+    wl_surface_commit(impl_->surface);
+    wl_display_roundtrip(impl_->display);  // configure resizes the EGL window
+    impl_->events.clear();
+    impl_->closed = false;
+}
+
+void Overlay::set_height(int height)
+{
+    if (!impl_->layer_surface || height == impl_->requested_height) return;
+    impl_->requested_height = height;
+    zwlr_layer_surface_v1_set_size(impl_->layer_surface,
+                                   static_cast<uint32_t>(impl_->configured_width), height);
+    wl_surface_commit(impl_->surface);   // the configure event resizes the EGL window
+}
+
 bool Overlay::dispatch()
 {
     if (impl_->closed) return false;
@@ -41,6 +41,14 @@ struct Overlay {
     bool init(int height = 200);
     void shutdown();
 
+    // Turn the overlay into a passive strip of the given height: keyboard
+    // focus goes back to other windows and the surface stays open until
+    // request_close() again.
+    void set_indicator(int height);
+
+    // Change the surface height; takes effect with the compositor's configure.
+    void set_height(int height);
+
     // Dispatch Wayland events. Returns false if the surface was closed.
     bool dispatch();
 
@@ -1,16 +1,22 @@
 #include "paste.h"
+#include "delivery.h"
+#include "metrics.h"
 
 #include <wayland-client.h>
 #include <xkbcommon/xkbcommon.h>
 #include "virtual-keyboard-unstable-v1-client-protocol.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
+#include <thread>
 #include <string>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <vector>
 
 // ---------------------------------------------------------------------------
@@ -90,18 +96,9 @@ static int create_keymap_fd(const std::string& keymap_str, uint32_t* out_size)
     return fd;
 }
 
-// Resolve a Unicode codepoint to an evdev keycode + required modifier mask.
-static bool resolve_char(xkb_keymap* keymap, xkb_state* state,
-                         uint32_t codepoint, ResolvedKey* out)
+// Resolve a keysym to an evdev keycode + required modifier mask.
+static bool resolve_keysym(xkb_keymap* keymap, xkb_keysym_t target, ResolvedKey* out)
 {
-    xkb_keysym_t target = xkb_utf32_to_keysym(codepoint);
-    if (target == XKB_KEY_NoSymbol) return false;
-
-    // Special case: newline → Return key
-    if (codepoint == '\n') {
-        target = XKB_KEY_Return;
-    }
-
     xkb_keycode_t min = xkb_keymap_min_keycode(keymap);
     xkb_keycode_t max = xkb_keymap_max_keycode(keymap);
 
@@ -130,6 +127,18 @@ static bool resolve_char(xkb_keymap* keymap, xkb_state* state,
     return false;
 }
 
+// Resolve a Unicode codepoint to an evdev keycode + required modifier mask.
+static bool resolve_char(xkb_keymap* keymap, xkb_state* state,
+                         uint32_t codepoint, ResolvedKey* out)
+{
+    // Special case: newline → Return key
+    if (codepoint == '\n') return resolve_keysym(keymap, XKB_KEY_Return, out);
+
+    xkb_keysym_t target = xkb_utf32_to_keysym(codepoint);
+    if (target == XKB_KEY_NoSymbol) return false;
+    return resolve_keysym(keymap, target, out);
+}
+
 // Extract UTF-32 codepoints from a UTF-8 string.
 static std::vector<uint32_t> utf8_to_codepoints(const std::string& s)
 {
@@ -177,15 +186,275 @@ static const wl_registry_listener vkbd_registry_listener = {
     vkbd_registry_global_remove,
 };
 
+// ---------------------------------------------------------------------------
+// Virtual keyboard session: one Wayland connection, keymap uploaded once.
+// ---------------------------------------------------------------------------
+static constexpr int FAST_BATCH_KEYS   = 32;   // fast typing: roundtrip every N chars
+static constexpr int CLIPBOARD_SETTLE_MS = 300; // let the target read the selection
+
+struct VirtualKeyboard {
+    wl_display*              display  = nullptr;
+    wl_registry*             registry = nullptr;
+    VkbdRegistryData         rdata;
+    zwp_virtual_keyboard_v1* vkbd     = nullptr;
+    xkb_context*             xkb_ctx  = nullptr;
+    xkb_keymap*              keymap   = nullptr;
+    xkb_state*               state    = nullptr;
+    uint32_t                 time_ms  = 0;
+
+    bool init()
+    {
+        display = wl_display_connect(nullptr);
+        if (!display) {
+            std::fprintf(stderr, "paste: wl_display_connect failed\n");
+            return false;
+        }
+
+        registry = wl_display_get_registry(display);
+        wl_registry_add_listener(registry, &vkbd_registry_listener, &rdata);
+        wl_display_roundtrip(display);
+
+        if (!rdata.seat || !rdata.mgr) {
+            std::fprintf(stderr, "paste: missing seat or virtual-keyboard-manager\n");
+            return false;
+        }
+
+        vkbd = zwp_virtual_keyboard_manager_v1_create_virtual_keyboard(rdata.mgr, rdata.seat);
+
+        std::string keymap_str = get_default_keymap_string();
+        if (keymap_str.empty()) {
+            std::fprintf(stderr, "paste: failed to get keymap\n");
+            return false;
+        }
+
+        uint32_t keymap_size;
+        int keymap_fd = create_keymap_fd(keymap_str, &keymap_size);
+        if (keymap_fd < 0) {
+            std::fprintf(stderr, "paste: failed to create keymap fd\n");
+            return false;
+        }
+
+        zwp_virtual_keyboard_v1_keymap(vkbd, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1,
+                                       keymap_fd, keymap_size);
+        close(keymap_fd);
+        wl_display_roundtrip(display);
+
+        // XKB state for resolving characters to keycodes
+        xkb_ctx = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        keymap = xkb_keymap_new_from_string(xkb_ctx, keymap_str.c_str(),
+                                            XKB_KEYMAP_FORMAT_TEXT_V1,
+                                            XKB_KEYMAP_COMPILE_NO_FLAGS);
+        if (!keymap) return false;
+        state = xkb_state_new(keymap);
+        return true;
+    }
+
+    void shutdown()
+    {
+        if (state)   xkb_state_unref(state);
+        if (keymap)  xkb_keymap_unref(keymap);
+        if (xkb_ctx) xkb_context_unref(xkb_ctx);
+        state = nullptr; keymap = nullptr; xkb_ctx = nullptr;
+
+        if (vkbd) {
+            zwp_virtual_keyboard_v1_destroy(vkbd);
+            wl_display_roundtrip(display);
+            vkbd = nullptr;
+        }
+        if (rdata.mgr)  zwp_virtual_keyboard_manager_v1_destroy(rdata.mgr);
+        if (rdata.seat) wl_seat_destroy(rdata.seat);
+        rdata = {};
+        if (registry) wl_registry_destroy(registry);
+        registry = nullptr;
+        if (display) wl_display_disconnect(display);
+        display = nullptr;
+    }
+
+    xkb_mod_mask_t mod_mask(const char* name) const
+    {
+        xkb_mod_index_t idx = xkb_keymap_mod_get_index(keymap, name);
+        return idx == XKB_MOD_INVALID ? 0 : (1u << idx);
+    }
+
+    // Press and release one key with the given modifiers held. With sync,
+    // wait for the compositor after each edge (the slow, safe path).
+    void tap(const ResolvedKey& rk, bool sync)
+    {
+        uint32_t evdev_key = rk.keycode - 8;  // xkb keycode to evdev
+
+        if (rk.mods != 0)
+            zwp_virtual_keyboard_v1_modifiers(vkbd, rk.mods, 0, 0, 0);
+
+        zwp_virtual_keyboard_v1_key(vkbd, time_ms++, evdev_key, 1);
+        if (sync) wl_display_roundtrip(display);
+
+        zwp_virtual_keyboard_v1_key(vkbd, time_ms++, evdev_key, 0);
+
+        if (rk.mods != 0)
+            zwp_virtual_keyboard_v1_modifiers(vkbd, 0, 0, 0, 0);
+        if (sync) wl_display_roundtrip(display);
+    }
+
+    // Type text, checking for cancellation between batches of keys.
+    // Returns false if cancelled.
+    bool type(const std::string& text, bool fast, paste::Progress* progress)
+    {
+        std::vector<uint32_t> cps = utf8_to_codepoints(text);
+        if (progress) progress->total = cps.size();
+
+        int batched = 0;
+        for (size_t i = 0; i < cps.size(); ++i) {
+            if (batched == 0 && progress && progress->cancel.load()) {
+                // Every tap releases its key and modifiers; say so once more
+                // in case the target missed an edge
+                zwp_virtual_keyboard_v1_modifiers(vkbd, 0, 0, 0, 0);
+                wl_display_roundtrip(display);
+                return false;
+            }
+            ResolvedKey rk;
+            if (i == 0 && progress) progress->first_key = std::chrono::steady_clock::now();
+            if (resolve_char(keymap, state, cps[i], &rk)) tap(rk, !fast);
+            if (++batched == FAST_BATCH_KEYS) {
+                if (fast) wl_display_roundtrip(display);
+                batched = 0;
+            }
+            if (progress) progress->done = i + 1;
+        }
+        wl_display_roundtrip(display);
+        return true;
+    }
+
+    // Press BackSpace n times, batched like fast typing.
+    bool erase(size_t n, bool fast)
+    {
+        if (n == 0) return true;
+        ResolvedKey rk;
+        if (!resolve_keysym(keymap, XKB_KEY_BackSpace, &rk)) return false;
+        for (size_t i = 0; i < n; ++i) {
+            tap(rk, !fast);
+            if (fast && (i + 1) % FAST_BATCH_KEYS == 0) wl_display_roundtrip(display);
+        }
+        wl_display_roundtrip(display);
+        return true;
+    }
+};
+
+// Window classes that paste with Ctrl+Shift+V rather than Ctrl+V.
+static bool is_terminal_class(const std::string& window_class)
+{
+    static const char* const terminals[] = {
+        "kitty", "foot", "Alacritty", "alacritty", "wezterm", "ghostty",
+        "konsole", "terminal", "Terminal", "xterm", "tilix", "st-256color",
+    };
+    for (const char* t : terminals)
+        if (window_class.find(t) != std::string::npos) return true;
+    return false;
+}
+
+// GTK/Qt/Chromium/Electron apps where Ctrl+V is paste, matched as
+// substrings of the class.
+static bool is_ctrl_v_class(const std::string& window_class)
+{
+    static const char* const apps[] = {
+        "firefox", "librewolf", "chromium", "chrome", "brave", "Slack", "slack",
+        "discord", "vesktop", "Signal", "signal", "telegram", "obsidian",
+        "thunderbird", "libreoffice", "org.gnome.", "org.kde.", "gedit",
+        "kate", "code", "Code", "codium", "zed",
+    };
+    for (const char* a : apps)
+        if (window_class.find(a) != std::string::npos) return true;
+    return false;
+}
+
+// Write text to a command's stdin.
+static bool pipe_to_cmd(const char* cmd, const std::string& text)
+{
+    FILE* pipe = popen(cmd, "w");
+    if (!pipe) return false;
+    std::fwrite(text.data(), 1, text.size(), pipe);
+    return pclose(pipe) == 0;
+}
+
+// What the clipboard holds, going by the MIME types it offers.
+enum class ClipboardContent {
+    Empty,
+    Text,    // plain text only: saving and restoring it loses nothing
+    Other,   // an image, rich text, files...
+};
+
+static ClipboardContent clipboard_content()
+{
+    static const char* const plain[] = {
+        "text/plain", "text/plain;charset=utf-8", "text/plain;charset=UTF-8",
+        "UTF8_STRING", "TEXT", "STRING", "COMPOUND_TEXT",
+    };
+    // Prints nothing (and fails) when the clipboard is empty
+    std::string types = exec_cmd("wl-paste --list-types 2>/dev/null");
+    bool any = false;
+    size_t pos = 0;
+    while (pos < types.size()) {
+        size_t end = types.find('\n', pos);
+        if (end == std::string::npos) end = types.size();
+        std::string type = types.substr(pos, end - pos);
+        pos = end + 1;
+        if (type.empty()) continue;
+        any = true;
+        bool is_plain = false;
+        for (const char* p : plain)
+            if (type == p) is_plain = true;
+        if (!is_plain) return ClipboardContent::Other;
+    }
+    return any ? ClipboardContent::Text : ClipboardContent::Empty;
+}
+
+// Put text on the clipboard and send the paste shortcut. Once the target
+// has had time to read it, a previous text clipboard is restored and an
+// empty one cleared. Refuses to touch a clipboard holding anything but
+// plain text, as it could not be put back.
+static bool clipboard_paste(VirtualKeyboard& kb, const std::string& text,
+                            const std::string& window_class, paste::Progress* progress)
+{
+    ClipboardContent content = clipboard_content();
+    if (content == ClipboardContent::Other) {
+        std::fprintf(stderr, "paste: clipboard holds non-text data, not replacing it\n");
+        return false;
+    }
+    std::string saved;
+    if (content == ClipboardContent::Text)
+        saved = exec_cmd("wl-paste --no-newline --type text 2>/dev/null");
+    if (!pipe_to_cmd("wl-copy --type text/plain 2>/dev/null", text)) {
+        std::fprintf(stderr, "paste: wl-copy failed\n");
+        return false;
+    }
+
+    ResolvedKey rk;
+    if (!resolve_char(kb.keymap, kb.state, 'v', &rk)) return false;
+    rk.mods = kb.mod_mask(XKB_MOD_NAME_CTRL);
+    if (is_terminal_class(window_class))
+        rk.mods |= kb.mod_mask(XKB_MOD_NAME_SHIFT);
+    if (progress) progress->first_key = std::chrono::steady_clock::now();
+    kb.tap(rk, true);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(CLIPBOARD_SETTLE_MS));
+    if (content == ClipboardContent::Empty)
+        exec_cmd("wl-copy --clear 2>/dev/null");
+    else
+        pipe_to_cmd("wl-copy --type text/plain 2>/dev/null", saved);
+    return true;
+}
+
 // ---------------------------------------------------------------------------
 // Public API
 // ---------------------------------------------------------------------------
 namespace paste {
 
-std::string capture_focus()
+Target capture_focus()
 {
     std::string output = exec_cmd("hyprctl -j activewindow");
-    return json_string_value(output, "address");
+    Target target;
+    target.address      = json_string_value(output, "address");
+    target.window_class = json_string_value(output, "class");
+    return target;
 }
 
 bool refocus(const std::string& addr)
@@ -195,115 +464,208 @@ bool refocus(const std::string& addr)
     return std::system(cmd.c_str()) == 0;
 }
 
-bool type_text(const std::string& text)
+const char* method_name(Method method)
 {
-    if (text.empty()) return true;
+    switch (method) {
+    case Method::Keys:      return "keys";
+    case Method::FastKeys:  return "fast-keys";
+    case Method::Clipboard: return "clipboard";
+    }
+    return "keys";
+}
 
-    // Connect to Wayland
-    wl_display* display = wl_display_connect(nullptr);
-    if (!display) {
-        std::fprintf(stderr, "paste: wl_display_connect failed\n");
-        return false;
+Method slower(Method method)
+{
+    switch (method) {
+    case Method::Clipboard: return Method::FastKeys;
+    case Method::FastKeys:  return Method::Keys;
+    case Method::Keys:      return Method::Keys;
     }
+    return Method::Keys;
+}
 
-    VkbdRegistryData rdata;
-    wl_registry* registry = wl_display_get_registry(display);
-    wl_registry_add_listener(registry, &vkbd_registry_listener, &rdata);
-    wl_display_roundtrip(display);
+bool paste_shortcut_known(const std::string& window_class)
+{
+    return is_terminal_class(window_class) || is_ctrl_v_class(window_class);
+}
 
-    if (!rdata.seat || !rdata.mgr) {
-        std::fprintf(stderr, "paste: missing seat or virtual-keyboard-manager\n");
-        wl_registry_destroy(registry);
-        wl_display_disconnect(display);
-        return false;
-    }
+bool fast_keys_known(const std::string& window_class)
+{
+    // Terminals read keys straight into the pty
+    return is_terminal_class(window_class);
+}
 
-    // Create virtual keyboard
-    zwp_virtual_keyboard_v1* vkbd =
-        zwp_virtual_keyboard_manager_v1_create_virtual_keyboard(rdata.mgr, rdata.seat);
-
-    // Set up XKB keymap
-    std::string keymap_str = get_default_keymap_string();
-    if (keymap_str.empty()) {
-        std::fprintf(stderr, "paste: failed to get keymap\n");
-        zwp_virtual_keyboard_v1_destroy(vkbd);
-        wl_registry_destroy(registry);
-        wl_display_disconnect(display);
-        return false;
-    }
+bool deliver(Method method, const std::string& text, const std::string& window_class,
+             Progress* progress)
+{
+    if (text.empty()) return true;
 
-    uint32_t keymap_size;
-    int keymap_fd = create_keymap_fd(keymap_str, &keymap_size);
-    if (keymap_fd < 0) {
-        std::fprintf(stderr, "paste: failed to create keymap fd\n");
-        zwp_virtual_keyboard_v1_destroy(vkbd);
-        wl_registry_destroy(registry);
-        wl_display_disconnect(display);
-        return false;
+    VirtualKeyboard kb;
+    bool ok = kb.init();
+    if (ok) {
+        switch (method) {
+        case Method::Keys:      ok = kb.type(text, false, progress); break;
+        case Method::FastKeys:  ok = kb.type(text, true, progress);  break;
+        case Method::Clipboard:
+            ok = clipboard_paste(kb, text, window_class, progress);
+            if (ok && progress) progress->done = progress->total = utf8_to_codepoints(text).size();
+            break;
+        }
     }
+    kb.shutdown();
+    return ok;
+}
 
-    zwp_virtual_keyboard_v1_keymap(vkbd, WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1,
-                                   keymap_fd, keymap_size);
-    close(keymap_fd);
-    wl_display_roundtrip(display);
+bool type_text(const std::string& text)
+{
+    return deliver(Method::Keys, text, {});
+}
 
-    // Build XKB state for resolving characters to keycodes
-    xkb_context* xkb_ctx = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
-    xkb_keymap* keymap = xkb_keymap_new_from_string(
-        xkb_ctx, keymap_str.c_str(), XKB_KEYMAP_FORMAT_TEXT_V1,
-        XKB_KEYMAP_COMPILE_NO_FLAGS);
-    xkb_state* state = xkb_state_new(keymap);
+bool refocus_and_type(const std::string& addr, const std::string& text)
+{
+    if (!refocus(addr)) return false;
+    usleep(50000);  // 50ms for focus to settle
+    return type_text(text);
+}
 
-    // Type each character
-    auto codepoints = utf8_to_codepoints(text);
-    uint32_t time_ms = 0;
+bool refocus_and_deliver(const Target& target, const std::string& text, Progress* progress)
+{
+    if (!refocus(target.address)) return false;
+    usleep(50000);  // 50ms for focus to settle
+    if (text.empty()) return true;
 
-    for (uint32_t cp : codepoints) {
-        ResolvedKey rk;
-        if (!resolve_char(keymap, state, cp, &rk)) continue;
+    DeliveryCache cache;
+    cache.load();
+
+    // A clipboard holding an image or rich text could not be restored;
+    // type instead, without counting it against clipboard paste
+    Method first = cache.choose(target.window_class);
+    if (first == Method::Clipboard && clipboard_content() == ClipboardContent::Other)
+        first = slower(first);
+
+    // Fall back towards plain typing if a method cannot run at all
+    for (Method method = first;; ) {
+        auto t0 = std::chrono::steady_clock::now();
+        bool ok = deliver(method, text, target.window_class, progress);
+        if (!ok && progress && progress->cancel.load()) return false;
+        double secs = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t0).count();
+
+        cache.record(target.window_class, method, ok,
+                     secs > 0.0 ? text.size() / secs : 0.0);
+        if (ok || method == Method::Keys) {
+            cache.save();
+            return ok;
+        }
+        std::fprintf(stderr, "paste: %s failed for %s, falling back\n",
+                     method_name(method), target.window_class.c_str());
+        method = slower(method);
+    }
+}
 
-        uint32_t evdev_key = rk.keycode - 8;  // xkb keycode to evdev
+// ---------------------------------------------------------------------------
+// Live typing
+// ---------------------------------------------------------------------------
+EditScript edit_script(const std::string& typed, const std::string& target)
+{
+    size_t prefix = 0;
+    size_t lim = std::min(typed.size(), target.size());
+    while (prefix < lim && typed[prefix] == target[prefix]) ++prefix;
+    // Back up to a codepoint boundary: backspace removes whole codepoints
+    while (prefix > 0 && (static_cast<unsigned char>(target[prefix]) & 0xC0) == 0x80) --prefix;
+
+    EditScript script;
+    for (size_t i = prefix; i < typed.size(); ++i)
+        if ((static_cast<unsigned char>(typed[i]) & 0xC0) != 0x80) ++script.erase;
+    script.insert = target.substr(prefix);
+    return script;
+}
 
-        // Press modifiers if needed
-        if (rk.mods != 0) {
-            zwp_virtual_keyboard_v1_modifiers(vkbd, rk.mods, 0, 0, 0);
+struct LiveTyper::Impl {
+    VirtualKeyboard kb;
+    bool            ready = false;
+    std::string     typed;
+    uint64_t        keys = 0;
+    std::unordered_map<uint32_t, bool> typeable;   // resolve_char scans the keymap
+
+    metrics::Counter* typed_keys  = metrics::counter("live_typed_keys");
+    metrics::Counter* erased_keys = metrics::counter("live_erased_keys");
+
+    // text without the characters the keymap cannot produce, so that the
+    // model matches what actually reached the window
+    std::string filter(const std::string& text)
+    {
+        std::string out;
+        out.reserve(text.size());
+        const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+        size_t i = 0;
+        while (i < text.size()) {
+            uint32_t cp;
+            size_t len;
+            if (p[i] < 0x80)      { cp = p[i]; len = 1; }
+            else if (p[i] < 0xE0) { cp = p[i] & 0x1F; len = 2; }
+            else if (p[i] < 0xF0) { cp = p[i] & 0x0F; len = 3; }
+            else                  { cp = p[i] & 0x07; len = 4; }
+            len = std::min(len, text.size() - i);
+            for (size_t k = 1; k < len; ++k)
+                cp = (cp << 6) | (p[i + k] & 0x3F);
+
+            auto it = typeable.find(cp);
+            if (it == typeable.end()) {
+                ResolvedKey rk;
+                it = typeable.emplace(cp, resolve_char(kb.keymap, kb.state, cp, &rk)).first;
+            }
+            if (it->second) out.append(text, i, len);
+            i += len;
         }
+        return out;
+    }
+};
 
-        // Key press
-        zwp_virtual_keyboard_v1_key(vkbd, time_ms++, evdev_key, 1);
-        wl_display_roundtrip(display);
+LiveTyper::LiveTyper() : impl_(std::make_unique<Impl>()) {}
 
-        // Key release
-        zwp_virtual_keyboard_v1_key(vkbd, time_ms++, evdev_key, 0);
+LiveTyper::~LiveTyper()
+{
+    if (impl_->ready) impl_->kb.shutdown();
+}
 
-        // Release modifiers
-        if (rk.mods != 0) {
-            zwp_virtual_keyboard_v1_modifiers(vkbd, 0, 0, 0, 0);
+bool LiveTyper::update(const std::string& text)
+{
+    Impl& m = *impl_;
+    if (!m.ready) {
+        if (!m.kb.init()) {
+            m.kb.shutdown();
+            return false;
         }
-        wl_display_roundtrip(display);
+        m.ready = true;
     }
 
-    // Cleanup
-    xkb_state_unref(state);
-    xkb_keymap_unref(keymap);
-    xkb_context_unref(xkb_ctx);
-
-    zwp_virtual_keyboard_v1_destroy(vkbd);
-    wl_display_roundtrip(display);
+    std::string want = m.filter(text);
+    EditScript script = edit_script(m.typed, want);
+    if (script.erase == 0 && script.insert.empty()) return true;
 
-    zwp_virtual_keyboard_manager_v1_destroy(rdata.mgr);
-    wl_seat_destroy(rdata.seat);
-    wl_registry_destroy(registry);
-    wl_display_disconnect(display);
+    if (!m.kb.erase(script.erase, true)) {
+        std::fprintf(stderr, "paste: keymap has no BackSpace\n");
+        return false;
+    }
+    m.kb.type(script.insert, true, nullptr);
+    m.typed = std::move(want);
 
+    size_t inserted = utf8_to_codepoints(script.insert).size();
+    m.keys += script.erase + inserted;
+    m.erased_keys->add(script.erase);
+    m.typed_keys->add(inserted);
     return true;
 }
 
-bool refocus_and_type(const std::string& addr, const std::string& text)
+const std::string& LiveTyper::typed() const
 {
-    if (!refocus(addr)) return false;
-    usleep(50000);  // 50ms for focus to settle
-    return type_text(text);
+    return impl_->typed;
+}
+
+uint64_t LiveTyper::keys() const
+{
+    return impl_->keys;
 }
 
 } // namespace paste
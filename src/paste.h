@@ -1,19 +1,107 @@
 #pragma once
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 namespace paste {
 
-// Capture the currently focused window address via hyprctl.
-std::string capture_focus();
+// The window that had focus before the overlay appeared.
+struct Target {
+    std::string address;       // hyprctl window address
+    std::string window_class;  // e.g. "kitty", "firefox", "Slack"
+};
+
+// Ways of getting text into the target, fastest first.
+enum class Method {
+    Clipboard,  // wl-copy + Ctrl+V (Ctrl+Shift+V in terminals)
+    FastKeys,   // virtual keyboard, one roundtrip per batch of keys
+    Keys,       // virtual keyboard, roundtrip after every key edge
+};
+
+// Progress of a delivery, read by whoever shows it. Setting cancel stops
+// typing before the next batch of keys, with all modifiers released.
+struct Progress {
+    std::atomic<size_t> done{0};    // characters delivered so far
+    std::atomic<size_t> total{0};
+    std::atomic<bool>   cancel{false};
+    std::chrono::steady_clock::time_point first_key;  // set before done turns non-zero
+};
+
+const char* method_name(Method method);
+
+// Next slower method; Method::Keys is the slowest.
+Method slower(Method method);
+
+// Whether the paste shortcut clipboard delivery sends (Ctrl+V, or
+// Ctrl+Shift+V in terminals) is known to paste in windows of this class.
+// Elsewhere it may do something else entirely (scroll in Emacs).
+bool paste_shortcut_known(const std::string& window_class);
+
+// Whether windows of this class are known to take fast typing (keys in
+// batches between roundtrips) without dropping any. Electron and some
+// toolkit apps lose keys that arrive faster than they process them.
+bool fast_keys_known(const std::string& window_class);
+
+// Capture the currently focused window address and class via hyprctl.
+Target capture_focus();
 
 // Refocus a window by its address.
 bool refocus(const std::string& addr);
 
+// Deliver text into the focused window with the given method. Returns false
+// on failure or when cancelled through progress.
+bool deliver(Method method, const std::string& text, const std::string& window_class,
+             Progress* progress = nullptr);
+
 // Type text into the focused window via zwp_virtual_keyboard_v1.
 bool type_text(const std::string& text);
 
 // Refocus the given window and type text.
 bool refocus_and_type(const std::string& addr, const std::string& text);
 
+// Refocus the target and deliver text with the fastest method known to work
+// for its window class (see DeliveryCache), recording the outcome. A
+// cancelled delivery is neither recorded nor retried with another method.
+bool refocus_and_deliver(const Target& target, const std::string& text,
+                         Progress* progress = nullptr);
+
+// Keys that turn already-typed text into target with the caret at the end:
+// `erase` backspaces, one per codepoint, back to the first difference,
+// then `insert` is typed. Without moving the caret a common suffix cannot
+// be kept, so only the common prefix is.
+struct EditScript {
+    size_t      erase = 0;
+    std::string insert;
+};
+
+EditScript edit_script(const std::string& typed, const std::string& target);
+
+// Types text into the focused window while it is still being revised. It
+// remembers what it has typed and sends each revision as an EditScript over
+// one virtual keyboard session, so a corrected word costs a few backspaces
+// and the word rather than the whole text again. Assumes nobody else moves
+// the caret or types into the window meanwhile.
+struct LiveTyper {
+    LiveTyper();
+    ~LiveTyper();
+
+    LiveTyper(const LiveTyper&) = delete;
+    LiveTyper& operator=(const LiveTyper&) = delete;
+
+    // Make the window show text. Characters the keymap cannot produce are
+    // left out. Returns false if the virtual keyboard is unavailable.
+    bool update(const std::string& text);
+
+    const std::string& typed() const;
+    uint64_t keys() const;      // key taps sent, backspaces included
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
 } // namespace paste
@@ -0,0 +1,603 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <link.h>
+#include <linux/perf_event.h>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <pthread.h>
+#include <string>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <thread>
+#include <ucontext.h>
+#include <unistd.h>
+#include <vector>
+
+#ifdef LIVE_WHISPER_PROFILER
+
+static constexpr int MAX_DEPTH    = 64;
+static constexpr int RING_SAMPLES = 1024;   // per thread, between drains
+static constexpr int DRAIN_MS     = 200;
+
+// ---------------------------------------------------------------------------
+// Per-thread sampling state. Written by the signal handler on the thread
+// itself, read by the drain thread (single producer, single consumer).
+// ---------------------------------------------------------------------------
+struct Sample {
+    int   depth;
+    void* frames[MAX_DEPTH];
+};
+
+struct ThreadProfile {
+    std::string      name;
+    pid_t            tid = 0;
+    uintptr_t        stack_lo = 0;  // the frame walk never leaves [lo, hi)
+    uintptr_t        stack_hi = 0;
+    bool             children = false;  // sample threads it starts, under its name
+    bool             child    = false;  // started by such a thread; folded away on exit
+    std::atomic<int> perf_fd{-1};   // re-armed by the handler
+    timer_t          timer{};
+    bool             has_timer = false;
+
+    Sample                ring[RING_SAMPLES];
+    std::atomic<uint32_t> head{0};
+    std::atomic<uint32_t> tail{0};
+    std::atomic<uint64_t> dropped{0};
+
+    // Folded by the drain thread: stack (leaf first) -> sample count
+    std::map<std::vector<void*>, uint64_t> stacks;
+};
+
+struct Profiler {
+    std::mutex                                  mutex;
+    std::vector<std::unique_ptr<ThreadProfile>> threads;   // kept until stop()
+    // Stacks of exited child threads, by name: ggml may start its workers
+    // per graph, and a ring per thread that ever ran would add up
+    std::map<std::string, std::unique_ptr<ThreadProfile>> retired;
+    std::string                                 dir;
+    long                                        period_ns = 0;
+
+    std::thread             drain_thread;
+    std::condition_variable drain_cv;
+    bool                    draining = false;
+};
+
+static std::atomic<bool>            g_running{false};
+static Profiler*                    g_profiler = nullptr;
+static thread_local ThreadProfile*  t_profile  = nullptr;
+
+// ---------------------------------------------------------------------------
+// Signal handler: unwind into the ring and re-arm the perf event.
+//
+// The unwind follows the frame-pointer chain from the interrupted context.
+// It only reads the thread's own stack, checked against its bounds, and
+// takes no locks: backtrace() goes through libgcc's FDE lookup and the
+// dl_iterate_phdr lock, so a sample landing in an unwind or a dlopen()
+// could deadlock. The build keeps frame pointers (CMakeLists.txt); the walk
+// ends at the first frame without one (libc, a leaf that omitted it).
+// ---------------------------------------------------------------------------
+static int unwind(const ucontext_t* uc, const ThreadProfile* tp, void** frames)
+{
+    uintptr_t pc, fp;
+#if defined(__x86_64__)
+    pc = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RIP]);
+    fp = static_cast<uintptr_t>(uc->uc_mcontext.gregs[REG_RBP]);
+#elif defined(__aarch64__)
+    pc = static_cast<uintptr_t>(uc->uc_mcontext.pc);
+    fp = static_cast<uintptr_t>(uc->uc_mcontext.regs[29]);
+#else
+    (void)uc;
+    (void)tp;
+    (void)frames;
+    return 0;
+#endif
+    // The symboliser looks up return address - 1; the interrupted pc is
+    // not a return address
+    int depth = 0;
+    frames[depth++] = reinterpret_cast<void*>(pc + 1);
+
+    // Each frame: [fp] = caller's fp, [fp + 8] = return address
+    while (depth < MAX_DEPTH) {
+        if (fp < tp->stack_lo || fp > tp->stack_hi - 2 * sizeof(uintptr_t)
+            || fp % sizeof(uintptr_t) != 0)
+            break;
+        const auto* frame = reinterpret_cast<const uintptr_t*>(fp);
+        if (frame[1] == 0) break;
+        frames[depth++] = reinterpret_cast<void*>(frame[1]);
+        if (frame[0] <= fp) break;   // stacks grow down; callers sit higher
+        fp = frame[0];
+    }
+    return depth;
+}
+
+static void on_sample(int, siginfo_t*, void* context)
+{
+    int saved_errno = errno;
+    ThreadProfile* tp = t_profile;
+    if (tp) {
+        uint32_t head = tp->head.load(std::memory_order_relaxed);
+        if (head - tp->tail.load(std::memory_order_acquire) < RING_SAMPLES) {
+            Sample& s = tp->ring[head % RING_SAMPLES];
+            s.depth = unwind(static_cast<const ucontext_t*>(context), tp, s.frames);
+            tp->head.store(head + 1, std::memory_order_release);
+        } else {
+            tp->dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        int fd = tp->perf_fd.load(std::memory_order_relaxed);
+        if (fd >= 0)
+            ioctl(fd, PERF_EVENT_IOC_REFRESH, 1);
+    }
+    errno = saved_errno;
+}
+
+static void drain(ThreadProfile* tp)
+{
+    uint32_t tail = tp->tail.load(std::memory_order_relaxed);
+    uint32_t head = tp->head.load(std::memory_order_acquire);
+    for (; tail != head; ++tail) {
+        const Sample& s = tp->ring[tail % RING_SAMPLES];
+        if (s.depth <= 0) continue;
+        std::vector<void*> key(s.frames, s.frames + s.depth);
+        ++tp->stacks[key];
+    }
+    tp->tail.store(tail, std::memory_order_release);
+}
+
+static void drain_loop(Profiler* p)
+{
+    std::unique_lock<std::mutex> lk(p->mutex);
+    while (p->draining) {
+        p->drain_cv.wait_for(lk, std::chrono::milliseconds(DRAIN_MS));
+        for (auto& tp : p->threads) drain(tp.get());
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Sampling sources
+// ---------------------------------------------------------------------------
+static int open_perf_event(pid_t tid, long period_ns)
+{
+    perf_event_attr attr{};
+    attr.size           = sizeof(attr);
+    attr.type           = PERF_TYPE_SOFTWARE;
+    attr.config         = PERF_COUNT_SW_TASK_CLOCK;
+    attr.sample_period  = static_cast<uint64_t>(period_ns);
+    attr.disabled       = 1;
+    attr.exclude_kernel = 1;   // allowed at perf_event_paranoid = 2
+    attr.exclude_hv     = 1;
+
+    int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    if (fd < 0) return -1;
+
+    // Deliver SIGPROF to the sampled thread itself on every overflow
+    f_owner_ex owner{F_OWNER_TID, tid};
+    if (fcntl(fd, F_SETFL, O_ASYNC) != 0
+        || fcntl(fd, F_SETSIG, SIGPROF) != 0
+        || fcntl(fd, F_SETOWN_EX, &owner) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool create_cpu_timer(pid_t tid, long period_ns, timer_t* timer)
+{
+    clockid_t clock;
+    if (pthread_getcpuclockid(pthread_self(), &clock) != 0) return false;
+
+    sigevent sev{};
+    sev.sigev_notify = SIGEV_THREAD_ID;
+    sev.sigev_signo  = SIGPROF;
+#ifdef sigev_notify_thread_id
+    sev.sigev_notify_thread_id = tid;
+#else
+    sev._sigev_un._tid = tid;
+#endif
+    if (timer_create(clock, &sev, timer) != 0) return false;
+
+    itimerspec its{};
+    its.it_interval.tv_sec  = period_ns / 1000000000L;
+    its.it_interval.tv_nsec = period_ns % 1000000000L;
+    its.it_value = its.it_interval;
+    if (timer_settime(*timer, 0, &its, nullptr) != 0) {
+        timer_delete(*timer);
+        return false;
+    }
+    return true;
+}
+
+static void stop_sampling(ThreadProfile* tp)
+{
+    int fd = tp->perf_fd.exchange(-1);
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        close(fd);
+    }
+    if (tp->has_timer) {
+        timer_delete(tp->timer);
+        tp->has_timer = false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Symbolisation: function symbols of the executable from its own .symtab
+// (covers static functions, unlike dladdr), dladdr for shared libraries.
+// ---------------------------------------------------------------------------
+struct ElfSymbol {
+    uintptr_t   addr;
+    uintptr_t   size;
+    std::string name;
+};
+
+struct Symbolizer {
+    std::vector<ElfSymbol> exe_symbols;   // sorted by address
+    uintptr_t              exe_bias = 0;
+    uintptr_t              exe_begin = 0, exe_end = 0;
+    std::map<void*, std::string> cache;
+
+    void load_executable();
+    std::string lookup(void* pc);
+};
+
+static int find_exe_mapping(dl_phdr_info* info, size_t, void* data)
+{
+    auto* sym = static_cast<Symbolizer*>(data);
+    // The first entry is the main program
+    sym->exe_bias = info->dlpi_addr;
+    for (int i = 0; i < info->dlpi_phnum; ++i) {
+        const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+        if (ph.p_type != PT_LOAD) continue;
+        uintptr_t begin = info->dlpi_addr + ph.p_vaddr;
+        uintptr_t end   = begin + ph.p_memsz;
+        if (sym->exe_begin == 0 || begin < sym->exe_begin) sym->exe_begin = begin;
+        if (end > sym->exe_end) sym->exe_end = end;
+    }
+    return 1;
+}
+
+void Symbolizer::load_executable()
+{
+    dl_iterate_phdr(find_exe_mapping, this);
+
+    int fd = open("/proc/self/exe", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ElfW(Ehdr)))) {
+        close(fd);
+        return;
+    }
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) return;
+
+    const auto* base = static_cast<const uint8_t*>(map);
+    const auto* eh = reinterpret_cast<const ElfW(Ehdr)*>(base);
+    if (std::memcmp(eh->e_ident, ELFMAG, SELFMAG) == 0 && eh->e_shoff != 0) {
+        const auto* sh = reinterpret_cast<const ElfW(Shdr)*>(base + eh->e_shoff);
+        for (int i = 0; i < eh->e_shnum; ++i) {
+            if (sh[i].sh_type != SHT_SYMTAB) continue;
+            const auto* syms = reinterpret_cast<const ElfW(Sym)*>(base + sh[i].sh_offset);
+            const char* strtab = reinterpret_cast<const char*>(base + sh[sh[i].sh_link].sh_offset);
+            size_t n = sh[i].sh_size / sizeof(ElfW(Sym));
+            for (size_t k = 0; k < n; ++k) {
+                if (ELF64_ST_TYPE(syms[k].st_info) != STT_FUNC || syms[k].st_value == 0)
+                    continue;
+                exe_symbols.push_back({syms[k].st_value, syms[k].st_size,
+                                       strtab + syms[k].st_name});
+            }
+        }
+    }
+    munmap(map, st.st_size);
+
+    std::sort(exe_symbols.begin(), exe_symbols.end(),
+              [](const ElfSymbol& a, const ElfSymbol& b) { return a.addr < b.addr; });
+}
+
+static std::string demangle(const char* name)
+{
+    int status = 0;
+    char* out = abi::__cxa_demangle(name, nullptr, nullptr, &status);
+    if (status != 0 || !out) return name;
+    std::string s(out);
+    std::free(out);
+    return s;
+}
+
+std::string Symbolizer::lookup(void* pc)
+{
+    auto cached = cache.find(pc);
+    if (cached != cache.end()) return cached->second;
+
+    // Return addresses point after the call; look up the call itself
+    uintptr_t addr = reinterpret_cast<uintptr_t>(pc) - 1;
+    std::string name;
+
+    if (addr >= exe_begin && addr < exe_end && !exe_symbols.empty()) {
+        uintptr_t rel = addr - exe_bias;
+        auto it = std::upper_bound(exe_symbols.begin(), exe_symbols.end(), rel,
+                                   [](uintptr_t a, const ElfSymbol& s) { return a < s.addr; });
+        if (it != exe_symbols.begin()) {
+            --it;
+            if (it->size == 0 || rel < it->addr + it->size)
+                name = demangle(it->name.c_str());
+        }
+    }
+    if (name.empty()) {
+        Dl_info info;
+        if (dladdr(reinterpret_cast<void*>(addr), &info) && info.dli_sname) {
+            name = demangle(info.dli_sname);
+        } else if (info.dli_fname) {
+            const char* slash = std::strrchr(info.dli_fname, '/');
+            char buf[64];
+            std::snprintf(buf, sizeof(buf), "+0x%zx",
+                          static_cast<size_t>(addr - reinterpret_cast<uintptr_t>(info.dli_fbase)));
+            name = std::string(slash ? slash + 1 : info.dli_fname) + buf;
+        } else {
+            name = "[unknown]";
+        }
+    }
+
+    // ';' separates frames in the collapsed format
+    std::replace(name.begin(), name.end(), ';', ':');
+    cache[pc] = name;
+    return name;
+}
+
+// All threads sampled under one name (a thread and the workers it started)
+// go into one file
+static void write_folded(const std::vector<const ThreadProfile*>& group, const std::string& dir,
+                         Symbolizer& sym)
+{
+    const std::string& tp_name = group.front()->name;
+    std::string name = tp_name;
+    std::replace(name.begin(), name.end(), '/', '_');
+    std::string path = dir + "/live-whisper." + std::to_string(getpid()) + "." + name + ".folded";
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) {
+        std::fprintf(stderr, "profiler: cannot write %s: %s\n", path.c_str(), std::strerror(errno));
+        return;
+    }
+
+    // Symbolised stacks can collide (inlined or unknown frames); merge them
+    std::map<std::string, uint64_t> folded;
+    uint64_t total = 0, dropped = 0;
+    for (const ThreadProfile* tp : group) {
+        for (const auto& [frames, count] : tp->stacks) {
+            std::string line = tp_name;
+            for (auto it = frames.rbegin(); it != frames.rend(); ++it)
+                line += ";" + sym.lookup(*it);
+            folded[line] += count;
+            total += count;
+        }
+        dropped += tp->dropped.load();
+    }
+    for (const auto& [line, count] : folded)
+        std::fprintf(f, "%s %llu\n", line.c_str(), static_cast<unsigned long long>(count));
+    std::fclose(f);
+
+    std::fprintf(stderr, "profiler: %s: %zu threads, %llu samples (%llu dropped) -> %s\n",
+                 tp_name.c_str(), group.size(), static_cast<unsigned long long>(total),
+                 static_cast<unsigned long long>(dropped), path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Public API
+// ---------------------------------------------------------------------------
+namespace profiler {
+
+bool start(const std::string& dir, int hz)
+{
+    if (g_running.load() || hz <= 0) return false;
+
+    if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+        std::fprintf(stderr, "profiler: cannot create %s: %s\n", dir.c_str(), std::strerror(errno));
+        return false;
+    }
+
+    struct sigaction sa{};
+    sa.sa_sigaction = on_sample;
+    sa.sa_flags     = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&sa.sa_mask);
+    if (sigaction(SIGPROF, &sa, nullptr) != 0) {
+        std::fprintf(stderr, "profiler: sigaction failed: %s\n", std::strerror(errno));
+        return false;
+    }
+
+    g_profiler = new Profiler;
+    g_profiler->dir       = dir;
+    g_profiler->period_ns = 1000000000L / hz;
+    g_profiler->draining  = true;
+    g_profiler->drain_thread = std::thread(drain_loop, g_profiler);
+    g_running = true;
+    return true;
+}
+
+void stop()
+{
+    if (!g_running.exchange(false)) return;
+    Profiler* p = g_profiler;
+
+    {
+        std::lock_guard<std::mutex> lk(p->mutex);
+        for (auto& tp : p->threads) stop_sampling(tp.get());
+        p->draining = false;
+    }
+    p->drain_cv.notify_all();
+    p->drain_thread.join();
+
+    // Child threads exiting now fold into retired under the lock
+    std::lock_guard<std::mutex> lk(p->mutex);
+    Symbolizer sym;
+    sym.load_executable();
+    std::map<std::string, std::vector<const ThreadProfile*>> groups;
+    for (auto& tp : p->threads) {
+        drain(tp.get());
+        groups[tp->name].push_back(tp.get());
+    }
+    for (auto& [name, tp] : p->retired) groups[name].push_back(tp.get());
+    for (const auto& [name, group] : groups) write_folded(group, p->dir, sym);
+
+    // Threads still registered keep a pointer to their profile; the handler
+    // is left installed but has nothing to sample once events are closed.
+    // Leak the profiles rather than race a late signal.
+    g_profiler = nullptr;
+}
+
+static void register_thread(const char* name, bool with_children, bool child)
+{
+    if (!g_running.load() || t_profile) return;
+    Profiler* p = g_profiler;
+
+    auto tp = std::make_unique<ThreadProfile>();
+    tp->name     = name;
+    tp->tid      = static_cast<pid_t>(syscall(SYS_gettid));
+    tp->children = with_children;
+    tp->child    = child;
+
+    pthread_attr_t attr;
+    if (pthread_getattr_np(pthread_self(), &attr) == 0) {
+        void* addr = nullptr;
+        size_t size = 0;
+        if (pthread_attr_getstack(&attr, &addr, &size) == 0) {
+            tp->stack_lo = reinterpret_cast<uintptr_t>(addr);
+            tp->stack_hi = tp->stack_lo + size;
+        }
+        pthread_attr_destroy(&attr);
+    }
+
+    // The handler must see the profile before the first sample arrives
+    t_profile = tp.get();
+
+    int fd = open_perf_event(tp->tid, p->period_ns);
+    if (fd >= 0) {
+        tp->perf_fd = fd;
+        ioctl(fd, PERF_EVENT_IOC_REFRESH, 1);
+    } else {
+        tp->has_timer = create_cpu_timer(tp->tid, p->period_ns, &tp->timer);
+        if (!tp->has_timer) {
+            std::fprintf(stderr, "profiler: cannot sample thread %s: %s\n",
+                         name, std::strerror(errno));
+            t_profile = nullptr;
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lk(p->mutex);
+    p->threads.push_back(std::move(tp));
+}
+
+void register_thread(const char* name, bool with_children)
+{
+    register_thread(name, with_children, false);
+}
+
+void unregister_thread()
+{
+    ThreadProfile* tp = t_profile;
+    if (!tp) return;
+    Profiler* p = g_profiler;
+    if (!p) {
+        t_profile = nullptr;
+        return;
+    }
+
+    std::lock_guard<std::mutex> lk(p->mutex);
+    stop_sampling(tp);
+    // A signal still pending must not write into a ring about to go away
+    t_profile = nullptr;
+    if (!tp->child) return;
+
+    drain(tp);
+    auto& retired = p->retired[tp->name];
+    if (!retired) {
+        retired       = std::make_unique<ThreadProfile>();
+        retired->name = tp->name;
+    }
+    for (const auto& [frames, count] : tp->stacks) retired->stacks[frames] += count;
+    retired->dropped += tp->dropped.load();
+    p->threads.erase(std::find_if(p->threads.begin(), p->threads.end(),
+                                  [tp](const auto& t) { return t.get() == tp; }));
+}
+
+} // namespace profiler
+
+// ---------------------------------------------------------------------------
+// Thread-start hook: threads started by a thread registered with children
+// (ggml's compute workers under the inference thread, whether from its own
+// pool or OpenMP's) are sampled under the same name. The definition in the
+// executable takes precedence over libc's for every library in the process.
+// ---------------------------------------------------------------------------
+namespace {
+
+struct ThreadStart {
+    void* (*fn)(void*);
+    void*       arg;
+    std::string name;
+};
+
+void* profiled_thread(void* data)
+{
+    std::unique_ptr<ThreadStart> start(static_cast<ThreadStart*>(data));
+    profiler::register_thread(start->name.c_str(), true, true);
+    void* ret = start->fn(start->arg);
+    profiler::unregister_thread();
+    return ret;
+}
+
+} // namespace
+
+extern "C" int pthread_create(pthread_t* thread, const pthread_attr_t* attr,
+                              void* (*fn)(void*), void* arg) noexcept
+{
+    using CreateFn = int (*)(pthread_t*, const pthread_attr_t*, void* (*)(void*), void*);
+    static const auto real = reinterpret_cast<CreateFn>(dlsym(RTLD_NEXT, "pthread_create"));
+
+    ThreadProfile* parent = t_profile;
+    if (!g_running.load() || !parent || !parent->children) return real(thread, attr, fn, arg);
+
+    auto* start = new ThreadStart{fn, arg, parent->name};
+    int err = real(thread, attr, profiled_thread, start);
+    if (err != 0) delete start;
+    return err;
+}
+
+#else // !LIVE_WHISPER_PROFILER
+
+// ---------------------------------------------------------------------------
+// Built without the profiler: no frame pointers to walk, no thread hook.
+// ---------------------------------------------------------------------------
+namespace profiler {
+
+bool start(const std::string&, int)
+{
+    std::fprintf(stderr, "profiler: not built in; reconfigure with "
+                         "-DLIVE_WHISPER_PROFILER=ON\n");
+    return false;
+}
+
+void stop() {}
+void register_thread(const char*, bool) {}
+void unregister_thread() {}
+
+} // namespace profiler
+
+#endif // LIVE_WHISPER_PROFILER
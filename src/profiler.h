@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+
+// In-process sampling profiler for the inference and UI threads. Built
+// only with -DLIVE_WHISPER_PROFILER=ON; otherwise start() reports that and
+// fails, and the rest are no-ops.
+//
+// Each registered thread gets its own CPU-time sampling source — a
+// perf_event_open task-clock event, or a POSIX timer on the thread's CPU
+// clock where perf events are not permitted — that signals the thread
+// itself. The handler walks the frame-pointer chain into a per-thread ring
+// (no locks, no unwinder); a background thread folds the rings into stack
+// counts, so a session of any length costs a fixed amount of memory. On
+// stop the stacks are symbolised from the executable's own symbol table and
+// written as collapsed-stack files (one per thread name) for flamegraph.pl
+// or speedscope.
+namespace profiler {
+
+// Start sampling at hz samples per second of thread CPU time. Files are
+// written to dir as live-whisper.<pid>.<thread>.folded on stop().
+bool start(const std::string& dir, int hz);
+
+// Stop sampling and write the collapsed stacks.
+void stop();
+
+// Sample the calling thread under the given name until unregister_thread().
+// With with_children, threads it starts from then on (ggml's workers) are
+// sampled under the same name too. No-op when the profiler is not running.
+void register_thread(const char* name, bool with_children = false);
+void unregister_thread();
+
+} // namespace profiler
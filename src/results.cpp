@@ -0,0 +1,304 @@
+#include "results.h"
+#include "metrics.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fcntl.h>
+#include <mutex>
+#include <poll.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+static constexpr size_t MAX_PENDING_BYTES = 256 * 1024;  // ~1000 partials of a long session
+static constexpr int    WRITE_POLL_MS     = 100;
+static constexpr int    SHUTDOWN_GRACE_MS = 1000; // on exit, give a stalled reader this long
+
+struct ResultStream::Impl {
+    int  fd          = -1;
+    int  saved_flags = -1;    // original fd flags, restored on shutdown
+    bool owns_fd     = false;
+
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point stopped;  // set before running clears
+
+    // Pending output, one event per line — appended by producers, drained
+    // by writer_loop(). Lines are only ever dropped whole.
+    struct Line {
+        std::string text;
+        bool        final = false;
+    };
+    std::deque<Line>        pending;
+    size_t                  pending_bytes = 0;
+    std::mutex              mutex;
+    std::condition_variable cv;
+    std::atomic<bool>       running{false};
+    std::atomic<uint64_t>   dropped{0};
+    uint64_t                reported_drops = 0;
+
+    std::thread thread;
+
+    void push(const char* type, const std::string& text,
+              const std::string* stable, float audio_seconds);
+    void writer_loop();
+    bool write_line(const std::string& line);
+};
+
+// ---------------------------------------------------------------------------
+// Helpers
+// ---------------------------------------------------------------------------
+void append_json_string(std::string& out, const std::string& s)
+{
+    out += '"';
+    for (unsigned char c : s) {
+        switch (c) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out += buf;
+            } else {
+                out += static_cast<char>(c);
+            }
+        }
+    }
+    out += '"';
+}
+
+// ---------------------------------------------------------------------------
+// Producer side: format one event and queue it. When the reader is too far
+// behind, queued partials are evicted oldest first to make room; a partial
+// that still does not fit is dropped, a final never is. Never blocks on I/O.
+// ---------------------------------------------------------------------------
+void ResultStream::Impl::push(const char* type, const std::string& text,
+                              const std::string* stable, float audio_seconds)
+{
+    if (!running.load()) return;
+
+    double t = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+
+    std::string line;
+    line.reserve(text.size() + (stable ? stable->size() : 0) + 96);
+
+    char head[128];
+    std::snprintf(head, sizeof(head), "{\"type\":\"%s\",\"t\":%.3f,\"audio\":%.3f,",
+                  type, t, static_cast<double>(audio_seconds));
+    line += head;
+    line += "\"text\":";
+    append_json_string(line, text);
+    if (stable) {
+        line += ",\"stable\":";
+        append_json_string(line, *stable);
+    }
+
+    {
+        std::lock_guard<std::mutex> lk(mutex);
+
+        // Let the reader know it missed events since the last delivered one
+        uint64_t d = dropped.load();
+        if (d != reported_drops) {
+            char buf[48];
+            std::snprintf(buf, sizeof(buf), ",\"dropped\":%llu",
+                          static_cast<unsigned long long>(d));
+            line += buf;
+        }
+        line += "}\n";
+
+        bool is_final = !stable;
+        for (auto it = pending.begin();
+             it != pending.end() && pending_bytes + line.size() > MAX_PENDING_BYTES; ) {
+            if (it->final) {
+                ++it;
+                continue;
+            }
+            pending_bytes -= it->text.size();
+            it = pending.erase(it);
+            ++dropped;
+        }
+        if (!is_final && pending_bytes + line.size() > MAX_PENDING_BYTES) {
+            ++dropped;
+            return;
+        }
+        reported_drops = d;
+        pending_bytes += line.size();
+        pending.push_back({std::move(line), is_final});
+    }
+    cv.notify_one();
+}
+
+// ---------------------------------------------------------------------------
+// Writer thread: drain pending lines to the non-blocking fd, waiting for
+// POLLOUT in short slices. After shutdown() it keeps going while the reader
+// makes progress and gives up once it has stalled for SHUTDOWN_GRACE_MS;
+// lines it never got to are counted as dropped.
+// ---------------------------------------------------------------------------
+
+// Write one whole line. Each line goes out in its own write(), so a line of
+// up to PIPE_BUF bytes reaches a pipe whole or not at all. Returns false if
+// the reader is gone, or stalled past the grace period during shutdown.
+bool ResultStream::Impl::write_line(const std::string& line)
+{
+    auto last_progress = std::chrono::steady_clock::now();
+    size_t off = 0;
+    while (off < line.size()) {
+        ssize_t n = write(fd, line.data() + off, line.size() - off);
+        if (n > 0) {
+            off += static_cast<size_t>(n);
+            last_progress = std::chrono::steady_clock::now();
+            continue;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && errno == EAGAIN) {
+            if (!running.load() &&
+                std::chrono::steady_clock::now() - std::max(last_progress, stopped) >
+                    std::chrono::milliseconds(SHUTDOWN_GRACE_MS)) {
+                std::fprintf(stderr, "results: reader stalled, giving up on exit\n");
+                return false;
+            }
+            struct pollfd pfd{};
+            pfd.fd     = fd;
+            pfd.events = POLLOUT;
+            poll(&pfd, 1, WRITE_POLL_MS);
+            continue;
+        }
+        // EPIPE or other hard error — reader is gone for good
+        std::fprintf(stderr, "results: write failed: %s\n", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void ResultStream::Impl::writer_loop()
+{
+    metrics::register_thread("results");
+    Line line;
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lk(mutex);
+            cv.wait(lk, [this] { return !pending.empty() || !running.load(); });
+            if (pending.empty()) break;
+            line = std::move(pending.front());
+            pending.pop_front();
+            pending_bytes -= line.text.size();
+        }
+
+        if (!write_line(line.text)) {
+            std::lock_guard<std::mutex> lk(mutex);
+            running = false;
+            dropped += 1 + pending.size();
+            pending.clear();
+            pending_bytes = 0;
+            break;
+        }
+    }
+    metrics::unregister_thread();
+}
+
+// ---------------------------------------------------------------------------
+// Public interface
+// ---------------------------------------------------------------------------
+
+ResultStream::ResultStream() : impl_(std::make_unique<Impl>()) {}
+ResultStream::~ResultStream() { shutdown(); }
+
+bool ResultStream::init(const std::string& path)
+{
+    if (path.empty() || path == "-") {
+        impl_->fd = STDOUT_FILENO;
+        impl_->owns_fd = false;
+    } else {
+        if (mkfifo(path.c_str(), 0600) != 0 && errno != EEXIST) {
+            std::fprintf(stderr, "results: mkfifo %s failed: %s\n",
+                         path.c_str(), std::strerror(errno));
+            return false;
+        }
+        // O_RDWR keeps the open from failing (or blocking) while no reader
+        // is attached yet; output simply accumulates in the pipe buffer.
+        impl_->fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+        if (impl_->fd < 0) {
+            std::fprintf(stderr, "results: open %s failed: %s\n",
+                         path.c_str(), std::strerror(errno));
+            return false;
+        }
+        impl_->owns_fd = true;
+    }
+
+    impl_->saved_flags = fcntl(impl_->fd, F_GETFL);
+    if (impl_->saved_flags >= 0)
+        fcntl(impl_->fd, F_SETFL, impl_->saved_flags | O_NONBLOCK);
+
+    impl_->start = std::chrono::steady_clock::now();
+    impl_->running = true;
+    impl_->thread = std::thread([this] { impl_->writer_loop(); });
+    return true;
+}
+
+void ResultStream::shutdown()
+{
+    if (impl_->thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lk(impl_->mutex);
+            impl_->stopped = std::chrono::steady_clock::now();
+            impl_->running = false;
+
+            // Partials queued before the last final are superseded by it;
+            // drop them so a slow reader gets the final within the grace
+            auto& q = impl_->pending;
+            size_t last_final = q.size();
+            for (size_t i = 0; i < q.size(); ++i)
+                if (q[i].final) last_final = i;
+            if (last_final < q.size()) {
+                std::deque<Impl::Line> kept;
+                for (size_t i = 0; i < q.size(); ++i) {
+                    if (q[i].final || i > last_final) {
+                        kept.push_back(std::move(q[i]));
+                        continue;
+                    }
+                    impl_->pending_bytes -= q[i].text.size();
+                    ++impl_->dropped;
+                }
+                q.swap(kept);
+            }
+        }
+        impl_->cv.notify_all();
+        impl_->thread.join();
+    }
+
+    if (impl_->fd >= 0) {
+        if (impl_->saved_flags >= 0)
+            fcntl(impl_->fd, F_SETFL, impl_->saved_flags);
+        if (impl_->owns_fd)
+            close(impl_->fd);
+        impl_->fd = -1;
+    }
+}
+
+void ResultStream::partial(const std::string& text, const std::string& stable,
+                           float audio_seconds)
+{
+    impl_->push("partial", text, &stable, audio_seconds);
+}
+
+void ResultStream::final(const std::string& text, float audio_seconds)
+{
+    impl_->push("final", text, nullptr, audio_seconds);
+}
+
+uint64_t ResultStream::dropped() const
+{
+    return impl_->dropped.load();
+}
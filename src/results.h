@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Newline-delimited JSON stream of transcription results for headless mode.
+// Events are queued into a bounded buffer and written by a background thread
+// on a non-blocking fd, so a slow (or absent) reader makes partials drop
+// instead of stalling inference. Finals are kept; events are dropped only as
+// whole lines.
+struct ResultStream {
+    ResultStream();
+    ~ResultStream();
+
+    ResultStream(const ResultStream&) = delete;
+    ResultStream& operator=(const ResultStream&) = delete;
+
+    // Open the output. "-" means stdout; any other path is used as a named
+    // pipe and created if it does not exist.
+    bool init(const std::string& path);
+    void shutdown();
+
+    // Queue a partial result: the full text so far and its prefix that did
+    // not change since the previous pass.
+    void partial(const std::string& text, const std::string& stable, float audio_seconds);
+
+    // Queue a final result: text that will not be revised any more.
+    void final(const std::string& text, float audio_seconds);
+
+    // Number of events dropped because the reader fell behind or, on
+    // shutdown, stalled.
+    uint64_t dropped() const;
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// Append s to out as a quoted, escaped JSON string.
+void append_json_string(std::string& out, const std::string& s);
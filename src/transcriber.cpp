@@ -1,8 +1,13 @@
 #include "transcriber.h"
+#include "config.h"
+#include "metrics.h"
+#include "profiler.h"
 #include "whisper.h"
 
 #include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cmath>
 #include <condition_variable>
 #include <cstdio>
 #include <mutex>
@@ -12,16 +17,38 @@
 #include <fcntl.h>
 #include <vector>
 
+// Pass intervals, minimum and commit lengths and the thread count are
+// runtime tuning (config.h), re-read at every pass
 static constexpr int SAMPLE_RATE         = 16000;
-static constexpr int INITIAL_INTERVAL_MS = 300;                  // first partial fires quickly
-static constexpr int STREAM_INTERVAL_MS  = 400;                  // subsequent partials
-static constexpr int MIN_SAMPLES         = SAMPLE_RATE / 4;      // need >= 0.25s of audio
-static constexpr int COMMIT_SAMPLES      = SAMPLE_RATE * 25;     // commit chunk every 25s
 
-static int inference_thread_count() {
-    unsigned n = std::thread::hardware_concurrency();
-    return static_cast<int>(std::max(4u, std::min(n, 16u)));
-}
+// Resuming after pause(): speech is a run of loud 30ms frames once edits
+// stop; loud is set by speech_threshold_db and speech_over_floor (config.h)
+static constexpr int   EDIT_IDLE_MS      = 800;
+static constexpr int   SPEECH_FRAME      = SAMPLE_RATE * 30 / 1000;
+static constexpr int   SPEECH_FRAMES     = 6;                    // 180ms above threshold
+static constexpr int   SPEECH_PREROLL    = SAMPLE_RATE * 3 / 10; // keep 300ms before onset
+
+// Boundary trigger: 10ms frames; speech is 3 loud frames in a row, a dip
+// is a frame 12dB under the recent speech level (or under the speech
+// threshold) and lasts boundary_dip_ms (config.h)
+static constexpr int   BOUNDARY_FRAME    = SAMPLE_RATE / 100;
+static constexpr int   BOUNDARY_SPEECH   = 3;
+static constexpr float BOUNDARY_DIP      = 0.25f;
+static constexpr float BOUNDARY_DECAY    = 0.995f;               // speech level, per frame
+
+// Span re-decoding
+static constexpr size_t SESSION_SAMPLES  = SAMPLE_RATE * 600;    // keep 10 min for re-decode
+static constexpr size_t SESSION_TRIM     = SAMPLE_RATE * 60;     // drop in 1 min steps
+static constexpr int    REDECODE_PAD     = SAMPLE_RATE / 5;      // 200ms either side
+static constexpr int    REDECODE_BEAM    = 5;
+static constexpr size_t REDECODE_PROMPT  = 200;                  // bytes of preceding text
+static constexpr int    SAMPLES_PER_CTX  = SAMPLE_RATE / 50;     // audio per encoder frame
+static constexpr int    MAX_AUDIO_CTX    = 1500;                 // 30s window
+
+// Forced-prefix decoding
+static constexpr int STABLE_MARGIN       = 2;    // unforce the last tokens of the agreed prefix
+static constexpr int FULL_REFRESH_PASSES = 8;    // free decode every N passes to undo lock-in
+static constexpr int MAX_DECODE_TOKENS   = 224;  // half the text context, as whisper_full
 
 struct Transcriber::Impl {
     whisper_context* ctx = nullptr;
@@ -30,7 +57,12 @@ struct Transcriber::Impl {
     std::vector<float> audio_buf;
     std::mutex         audio_mutex;
 
-    // Total samples received (for recording time display)
+    // The whole recording (last SESSION_SAMPLES of it), for re-decoding.
+    // Ends at total_samples, like audio_buf.
+    std::vector<float> session_audio;
+
+    // Total samples received (for recording time display); updated under
+    // audio_mutex so it lines up with audio_buf
     std::atomic<uint64_t> total_samples{0};
 
     // Background streaming thread
@@ -40,20 +72,168 @@ struct Transcriber::Impl {
     std::atomic<bool>       running{false};
     std::atomic<bool>       abort_inference{false};
 
-    // Accumulated committed text (only touched by streaming thread)
+    // Accumulated committed text and the latest uncommitted pass output
+    // (only touched by streaming thread)
     std::string confirmed_text;
+    std::string last_partial;
+    std::string last_display;
+    std::vector<TextSpan> confirmed_spans;
+    std::vector<TextSpan> partial_spans;
+
+    TextCallback   callback;
+    ResultCallback result_callback;
+
+    // Decoding mode and the token history forced-prefix decoding builds on
+    // (only touched by the inference thread, apart from the atomic mode)
+    std::atomic<Decoding>      decoding{Decoding::Full};
+    std::vector<whisper_token> prev_tokens;    // hypothesis of the last pass
+    std::vector<whisper_token> forced_tokens;  // prefix forced on the next pass
+
+    // Token timings of a pass, in samples from the start of its audio
+    // (parallel to the token list), and where that audio starts in the
+    // recording
+    struct TokenTime { int64_t t0, t1; };
+    std::vector<TokenTime>     prev_times;
+    uint64_t                   pass_origin = 0;
+    int                        passes_since_refresh = 0;
+    int                        decode_steps = 0;   // of the last pass
+
+    metrics::Histogram* pass_hist = metrics::histogram("pass_ms");
+    metrics::Histogram* rtf_hist  = metrics::histogram("pass_rtf");
+    metrics::Counter*   encodes   = metrics::counter("encoder_runs");
+    metrics::Counter*   reuses    = metrics::counter("encoder_reuses");
+
+    // Encoder output held by the context's default state, keyed by the
+    // recording range it was computed from. Sample positions restart on
+    // reset(), which bumps the generation. Only the inference thread
+    // encodes, so only it touches the key.
+    struct EncoderKey {
+        uint64_t generation = 0;
+        uint64_t begin = 0;
+        uint64_t end   = 0;      // begin == end: nothing cached
+        bool operator==(const EncoderKey& o) const
+        {
+            return generation == o.generation && begin == o.begin && end == o.end;
+        }
+    };
+    EncoderKey            encoded;
+    std::atomic<uint64_t> generation{0};
+
+    // Range of the whisper_full() pass whose output prev_tokens and
+    // prev_times still hold. A plain pass over the same range reuses it.
+    EncoderKey            full_pass;
+
+    // Edit pause. pause() only flags it; the inference thread drops the
+    // covered audio and watches for speech (pass_samples, noise_floor and
+    // segment are only touched by that thread).
+    std::atomic<bool>    paused{false};
+    std::atomic<int64_t> last_edit_ms{0};
+    bool                 pause_applied = false;
+    size_t               pass_samples  = 0;    // audio the last delivered pass covered
+    float                noise_floor   = 0.0f;
+    uint32_t             segment       = 0;
+
+    // Boundary trigger. process() tracks frame energy (under audio_mutex)
+    // and sets boundary (under stop_mutex, waking the loop) when a dip
+    // follows new speech.
+    struct BoundaryDetector {
+        double energy = 0.0;       // of the frame being filled
+        int    filled = 0;
+        float  floor  = 0.0f;      // noise floor, as in wait_for_speech()
+        float  speech_level = 0.0f;
+        int    loud  = 0;          // consecutive loud frames
+        int    quiet = 0;          // consecutive dip frames
+        bool   speech = false;     // speech since the last boundary
+    };
+    BoundaryDetector  detector;
+    std::atomic<bool> boundary{false};
+    metrics::Counter* boundary_passes = metrics::counter("boundary_passes");
+
+    bool detect_boundary(const float* samples, uint32_t n);
 
-    TextCallback callback;
+    // Pending span re-decode (guarded by stop_mutex, which also wakes the
+    // loop) and the decoder state it runs on
+    bool             redecode_pending = false;
+    float            redecode_t0 = 0.0f;
+    float            redecode_t1 = 0.0f;
+    std::string      redecode_prompt;
+    RedecodeCallback redecode_cb;
+    whisper_state*   redecode_state = nullptr;
 
     void streaming_loop();
-    std::string run_whisper(const std::vector<float>& audio);
+    bool wait_for_speech();
+    void run_redecode();
+    std::string run_whisper(const std::vector<float>& audio, std::vector<TextSpan>* spans);
+    bool run_full(const std::vector<float>& audio, std::vector<whisper_token>* tokens,
+                  std::vector<TokenTime>* times);
+    EncoderKey pass_key(const std::vector<float>& audio) const;
+    bool encode(const std::vector<float>& audio);
+    bool decode(size_t n_samples, const std::vector<whisper_token>& forced,
+                std::vector<whisper_token>* tokens, std::vector<TokenTime>* times);
+    void clear_tokens();
+    void clear_text();
+    std::string join_confirmed(const std::string& text) const;
+    std::vector<TextSpan> join_confirmed(const std::vector<TextSpan>& spans) const;
+    void deliver(const std::string& display, const std::vector<TextSpan>& spans, bool final,
+                 float audio_seconds, float pass_ms = 0.0f);
 };
 
 // ---------------------------------------------------------------------------
-// Run whisper inference, returning concatenated segment text.
+// Strip hallucinated noise labels like [BLANK_AUDIO], (wind blowing), etc.
+// If kept_before is given it receives, for each input offset (and the end),
+// the output offset it maps to.
 // ---------------------------------------------------------------------------
-std::string Transcriber::Impl::run_whisper(const std::vector<float>& audio) {
-    if (!ctx || audio.empty()) return {};
+static std::string strip_noise_labels(const std::string& text,
+                                      std::vector<size_t>* kept_before = nullptr)
+{
+    std::string clean;
+    clean.reserve(text.size());
+    if (kept_before) kept_before->assign(text.size() + 1, 0);
+    size_t i = 0;
+    while (i < text.size()) {
+        if (text[i] == '[' || text[i] == '(') {
+            char close = (text[i] == '[') ? ']' : ')';
+            size_t end = text.find(close, i + 1);
+            if (end != std::string::npos) {
+                if (kept_before)
+                    std::fill(kept_before->begin() + i, kept_before->begin() + end + 1, clean.size());
+                i = end + 1;
+                continue;
+            }
+        }
+        if (kept_before) (*kept_before)[i] = clean.size();
+        clean += text[i++];
+    }
+    if (kept_before) kept_before->back() = clean.size();
+    return clean;
+}
+
+// ---------------------------------------------------------------------------
+// Longest common prefix of two passes, cut back to a word boundary so a word
+// that is still growing ("transcri" -> "transcribe") is not reported stable.
+// ---------------------------------------------------------------------------
+static std::string stable_prefix(const std::string& prev, const std::string& cur)
+{
+    size_t n = 0;
+    size_t lim = std::min(prev.size(), cur.size());
+    while (n < lim && prev[n] == cur[n]) ++n;
+
+    if (n == cur.size() && n == prev.size()) return cur;
+    while (n > 0 && cur[n - 1] != ' ') --n;
+    return cur.substr(0, n);
+}
+
+// ---------------------------------------------------------------------------
+// Full decode via whisper_full(), returning the text tokens of the pass. It
+// encodes on the default state too, so afterwards the cache holds this
+// audio, unless whisper_full() skipped input under a second or the audio
+// spans more than one 30s window (the state then holds the last window).
+// ---------------------------------------------------------------------------
+bool Transcriber::Impl::run_full(const std::vector<float>& audio,
+                                 std::vector<whisper_token>* tokens,
+                                 std::vector<TokenTime>* times)
+{
+    encoded = {};
 
     whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_GREEDY);
     params.print_progress   = false;
@@ -63,38 +243,397 @@ std::string Transcriber::Impl::run_whisper(const std::vector<float>& audio) {
     params.single_segment   = true;
     params.no_context       = true;
     params.language         = "en";
-    params.n_threads        = inference_thread_count();
+    params.n_threads        = config::inference_threads();
+    params.token_timestamps = true;
 
     params.abort_callback = [](void* data) -> bool {
         return static_cast<Impl*>(data)->abort_inference.load();
     };
     params.abort_callback_user_data = this;
 
+    int ret = whisper_full(ctx, params, audio.data(), static_cast<int>(audio.size()));
+    if (ret != 0) return false;
+    encodes->add();
+    if (audio.size() >= static_cast<size_t>(SAMPLE_RATE)
+        && audio.size() <= static_cast<size_t>(MAX_AUDIO_CTX) * SAMPLES_PER_CTX)
+        encoded = pass_key(audio);
+
+    // Token times are in 10ms units
+    whisper_token eot = whisper_token_eot(ctx);
+    int n_seg = whisper_full_n_segments(ctx);
+    for (int i = 0; i < n_seg; ++i) {
+        int n_tok = whisper_full_n_tokens(ctx, i);
+        for (int j = 0; j < n_tok; ++j) {
+            whisper_token_data data = whisper_full_get_token_data(ctx, i, j);
+            if (data.id >= eot) continue;
+            tokens->push_back(data.id);
+            times->push_back({data.t0 * SAMPLE_RATE / 100, data.t1 * SAMPLE_RATE / 100});
+        }
+    }
+    decode_steps = static_cast<int>(tokens->size()) + 1;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Encoder step, cached: a pass over the same recording range as the last
+// encode (no new audio, or a final pass right after a partial) decodes from
+// the existing encoder output instead of running the encoder again.
+// ---------------------------------------------------------------------------
+Transcriber::Impl::EncoderKey Transcriber::Impl::pass_key(const std::vector<float>& audio) const
+{
+    EncoderKey key;
+    key.generation = generation.load();
+    key.begin      = pass_origin;
+    key.end        = pass_origin + audio.size();
+    return key;
+}
+
+bool Transcriber::Impl::encode(const std::vector<float>& audio)
+{
+    EncoderKey key = pass_key(audio);
+    if (encoded.end > encoded.begin && encoded == key) {
+        reuses->add();
+        return true;
+    }
+
+    // A failed or aborted encode leaves the state half written
+    encoded = {};
+    int threads = config::inference_threads();
+    if (whisper_pcm_to_mel(ctx, audio.data(), static_cast<int>(audio.size()), threads) != 0)
+        return false;
+    if (abort_inference.load()) return false;
+    if (whisper_encode(ctx, 0, threads) != 0) return false;
+    if (abort_inference.load()) return false;
+    encodes->add();
+    encoded = key;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Decoder step on the encoded audio, for forced-prefix mode: evaluate the
+// prompt plus the forced tokens in a single decoder call, then greedily
+// generate only the suffix. whisper_decode() with
+// n_past = 0 discards the KV cache of the last pass.
+// ---------------------------------------------------------------------------
+bool Transcriber::Impl::decode(size_t n_samples, const std::vector<whisper_token>& forced,
+                               std::vector<whisper_token>* tokens,
+                               std::vector<TokenTime>* times)
+{
+    int threads = config::inference_threads();
+
+    std::vector<whisper_token> prompt = {
+        whisper_token_sot(ctx),
+        whisper_token_lang(ctx, whisper_lang_id("en")),
+        whisper_token_transcribe(ctx),
+        whisper_token_not(ctx),
+    };
+    prompt.insert(prompt.end(), forced.begin(), forced.end());
+
+    int n_past = static_cast<int>(prompt.size());
+    if (whisper_decode(ctx, prompt.data(), n_past, 0, threads) != 0) return false;
+    decode_steps = 1;
+
+    const int n_vocab = whisper_n_vocab(ctx);
+    const whisper_token eot = whisper_token_eot(ctx);
+    const float* logits = whisper_get_logits(ctx) + static_cast<size_t>(n_past - 1) * n_vocab;
+
+    *tokens = forced;
+    while (static_cast<int>(tokens->size()) < MAX_DECODE_TOKENS) {
+        // Greedy over text tokens and end-of-text; timestamps and other
+        // special tokens (ids above eot) are never emitted.
+        whisper_token best = eot;
+        for (whisper_token id = 0; id < eot; ++id)
+            if (logits[id] > logits[best]) best = id;
+        if (best == eot) break;
+
+        tokens->push_back(best);
+        if (abort_inference.load()) return false;
+        if (whisper_decode(ctx, &best, 1, n_past, threads) != 0) return false;
+        ++n_past;
+        ++decode_steps;
+        logits = whisper_get_logits(ctx);
+    }
+
+    // Forced tokens keep the times of the pass they came from; the tail is
+    // spread evenly over the audio after them
+    times->assign(prev_times.begin(), prev_times.begin() + static_cast<long>(forced.size()));
+    size_t n_new = tokens->size() - forced.size();
+    int64_t from = times->empty() ? 0 : times->back().t1;
+    int64_t step = n_new > 0 ? (static_cast<int64_t>(n_samples) - from) / static_cast<int64_t>(n_new) : 0;
+    for (size_t i = 0; i < n_new; ++i)
+        times->push_back({from + step * static_cast<int64_t>(i), from + step * static_cast<int64_t>(i + 1)});
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Run one inference pass over audio starting at pass_origin, returning the
+// cleaned text. In forced-prefix mode the tokens both of the last two passes
+// agree on are forced next time, decoding from the cached encoder output
+// when it covers this audio. A full pass over the same range as the last
+// whisper_full() pass (no audio since, or the final right after a partial)
+// reuses that pass's tokens and times rather than decoding again.
+// ---------------------------------------------------------------------------
+std::string Transcriber::Impl::run_whisper(const std::vector<float>& audio,
+                                           std::vector<TextSpan>* spans) {
+    spans->clear();
+    if (!ctx || audio.empty()) return {};
     if (abort_inference.load()) return {};
 
-    int ret = whisper_full(ctx, params, audio.data(), static_cast<int>(audio.size()));
-    if (ret != 0) return {};
+    std::vector<whisper_token> tokens;
+    std::vector<TokenTime> times;
+    decode_steps = 0;
+
+    bool forced_mode = decoding.load() == Decoding::ForcedPrefix
+                    && ++passes_since_refresh < FULL_REFRESH_PASSES;
+    if (!forced_mode) passes_since_refresh = 0;
+
+    EncoderKey key = pass_key(audio);
+    bool ok;
+    if (forced_mode) {
+        full_pass = {};
+        ok = encode(audio) && decode(audio.size(), forced_tokens, &tokens, &times);
+    } else if (full_pass.end > full_pass.begin && full_pass == key) {
+        reuses->add();
+        tokens = prev_tokens;
+        times  = prev_times;
+        ok = true;
+    } else {
+        full_pass = {};
+        ok = run_full(audio, &tokens, &times);
+        if (ok) full_pass = key;
+    }
+    if (!ok) return {};
+
+    // Next pass forces the agreed prefix, minus a margin the decoder may
+    // still revise as more audio arrives
+    size_t agreed = 0;
+    size_t lim = std::min(prev_tokens.size(), tokens.size());
+    while (agreed < lim && prev_tokens[agreed] == tokens[agreed]) ++agreed;
+    agreed = agreed > STABLE_MARGIN ? agreed - STABLE_MARGIN : 0;
 
     std::string text;
-    int n_seg = whisper_full_n_segments(ctx);
-    for (int i = 0; i < n_seg; ++i) {
-        const char* s = whisper_full_get_segment_text(ctx, i);
-        if (s) text += s;
+    std::vector<size_t> token_begin;
+    for (whisper_token id : tokens) {
+        token_begin.push_back(text.size());
+        if (const char* piece = whisper_token_to_str(ctx, id)) text += piece;
+    }
+    token_begin.push_back(text.size());
+
+    std::vector<size_t> kept_before;
+    std::string clean = strip_noise_labels(text, &kept_before);
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        TextSpan span;
+        span.begin = kept_before[token_begin[i]];
+        span.end   = kept_before[token_begin[i + 1]];
+        if (span.begin == span.end) continue;   // stripped
+        span.t0 = static_cast<float>(pass_origin + times[i].t0) / SAMPLE_RATE;
+        span.t1 = static_cast<float>(pass_origin + times[i].t1) / SAMPLE_RATE;
+        spans->push_back(span);
     }
 
-    // Strip hallucinated noise labels like [BLANK_AUDIO], (wind blowing), etc.
-    std::string clean;
-    clean.reserve(text.size());
-    size_t i = 0;
-    while (i < text.size()) {
-        if (text[i] == '[' || text[i] == '(') {
-            char close = (text[i] == '[') ? ']' : ')';
-            size_t end = text.find(close, i + 1);
-            if (end != std::string::npos) { i = end + 1; continue; }
+    forced_tokens.assign(tokens.begin(), tokens.begin() + agreed);
+    prev_tokens = std::move(tokens);
+    prev_times  = std::move(times);
+    return clean;
+}
+
+void Transcriber::Impl::clear_tokens()
+{
+    prev_tokens.clear();
+    prev_times.clear();
+    forced_tokens.clear();
+    full_pass = {};
+    passes_since_refresh = 0;
+}
+
+void Transcriber::Impl::clear_text()
+{
+    confirmed_text.clear();
+    last_partial.clear();
+    last_display.clear();
+    confirmed_spans.clear();
+    partial_spans.clear();
+}
+
+static int64_t now_ms()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// ---------------------------------------------------------------------------
+// Edit pause. On the first tick after pause() the audio the on-screen text
+// already covers is dropped along with the text state, so the next segment
+// starts empty. Silence keeps being trimmed; once the user has stopped
+// typing, a run of frames well above the noise floor resumes passes from
+// just before the onset. Audio spoken before the edit that no pass had
+// reached yet survives the trim and becomes the start of the new segment.
+// Returns true when passes should resume.
+// ---------------------------------------------------------------------------
+bool Transcriber::Impl::wait_for_speech()
+{
+    std::lock_guard<std::mutex> lk(audio_mutex);
+
+    if (!pause_applied) {
+        audio_buf.erase(audio_buf.begin(),
+                        audio_buf.begin() + static_cast<long>(std::min(pass_samples, audio_buf.size())));
+        pass_samples = 0;
+        clear_text();
+        clear_tokens();
+        noise_floor = 0.0f;
+        pause_applied = true;
+    }
+
+    const config::Tuning tuning = config::current();
+    const float rms_min    = std::pow(10.0f, tuning.speech_threshold_db / 20.0f);
+    const float over_floor = static_cast<float>(tuning.speech_over_floor);
+
+    size_t n_frames = audio_buf.size() / SPEECH_FRAME;
+    int run = 0;
+    size_t onset = n_frames;
+    for (size_t f = 0; f < n_frames; ++f) {
+        double e = 0.0;
+        for (int i = 0; i < SPEECH_FRAME; ++i) {
+            float x = audio_buf[f * SPEECH_FRAME + i];
+            e += x * x;
+        }
+        float rms = static_cast<float>(std::sqrt(e / SPEECH_FRAME));
+        // Track the floor down quickly and up slowly
+        noise_floor = noise_floor == 0.0f || rms < noise_floor ? rms : noise_floor * 1.002f;
+
+        if (rms > std::max(rms_min, noise_floor * over_floor)) {
+            if (++run == SPEECH_FRAMES) {
+                onset = f + 1 - SPEECH_FRAMES;
+                break;
+            }
+        } else {
+            run = 0;
         }
-        clean += text[i++];
     }
-    return clean;
+
+    // Drop what cannot start speech, keeping pre-roll before the onset or
+    // before a run of loud frames that may still become one
+    bool typing = now_ms() - last_edit_ms.load() < EDIT_IDLE_MS;
+    size_t keep_from = (onset < n_frames ? onset : n_frames - run) * SPEECH_FRAME;
+    keep_from = keep_from > SPEECH_PREROLL ? keep_from - SPEECH_PREROLL : 0;
+    audio_buf.erase(audio_buf.begin(), audio_buf.begin() + static_cast<long>(keep_from));
+
+    if (onset == n_frames || typing) return false;
+    ++segment;
+    pause_applied = false;
+    paused = false;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Boundary trigger. A pass that starts mid-word decodes a garbled tail the
+// next pass has to fix, so instead of waiting out the timer a pass starts at
+// the first short dip in energy after new speech: a pause between words or
+// the end of an utterance. Returns true when one was found in samples.
+// ---------------------------------------------------------------------------
+bool Transcriber::Impl::detect_boundary(const float* samples, uint32_t n)
+{
+    const config::Tuning tuning = config::current();
+    if (tuning.boundary_dip_ms <= 0) return false;
+    const float rms_min    = std::pow(10.0f, tuning.speech_threshold_db / 20.0f);
+    const float over_floor = static_cast<float>(tuning.speech_over_floor);
+    const int   dip_frames = std::max(1, tuning.boundary_dip_ms * SAMPLE_RATE / 1000 / BOUNDARY_FRAME);
+
+    BoundaryDetector& d = detector;
+    bool found = false;
+    for (uint32_t i = 0; i < n; ++i) {
+        d.energy += samples[i] * samples[i];
+        if (++d.filled < BOUNDARY_FRAME) continue;
+        float rms = static_cast<float>(std::sqrt(d.energy / BOUNDARY_FRAME));
+        d.energy = 0.0;
+        d.filled = 0;
+
+        d.floor = d.floor == 0.0f || rms < d.floor ? rms : d.floor * 1.002f;
+        d.speech_level *= BOUNDARY_DECAY;
+        if (rms < std::max(rms_min, d.speech_level * BOUNDARY_DIP)) {
+            d.loud = 0;
+            if (++d.quiet >= dip_frames && d.speech) {
+                d.speech = false;
+                found = true;
+            }
+        } else if (rms > d.floor * over_floor) {
+            d.quiet = 0;
+            d.speech_level = std::max(d.speech_level, rms);
+            if (++d.loud >= BOUNDARY_SPEECH) d.speech = true;
+        } else {
+            d.quiet = 0;   // neither speech nor a dip: a soft onset or tail
+            d.loud  = 0;
+        }
+    }
+    return found;
+}
+
+// ---------------------------------------------------------------------------
+// Span re-decode. Runs between passes on its own decoder state with beam
+// search; audio_ctx limits the encoder to the span's length instead of the
+// full 30s window, so a few words cost a fraction of a streaming pass.
+// ---------------------------------------------------------------------------
+void Transcriber::Impl::run_redecode()
+{
+    float t0, t1;
+    std::string prompt;
+    RedecodeCallback cb;
+    {
+        std::lock_guard<std::mutex> lk(stop_mutex);
+        if (!redecode_pending) return;
+        redecode_pending = false;
+        t0 = redecode_t0;
+        t1 = redecode_t1;
+        prompt = std::move(redecode_prompt);
+        cb = std::move(redecode_cb);
+    }
+
+    std::vector<float> audio;
+    {
+        std::lock_guard<std::mutex> lk(audio_mutex);
+        uint64_t origin = total_samples.load() - session_audio.size();
+        auto from = static_cast<int64_t>(t0 * SAMPLE_RATE) - REDECODE_PAD;
+        auto to   = static_cast<int64_t>(t1 * SAMPLE_RATE) + REDECODE_PAD;
+        from = std::max<int64_t>(from, static_cast<int64_t>(origin));
+        to   = std::min<int64_t>(to, static_cast<int64_t>(total_samples.load()));
+        to   = std::min<int64_t>(to, from + MAX_AUDIO_CTX * SAMPLES_PER_CTX);
+        if (to > from)
+            audio.assign(session_audio.begin() + (from - static_cast<int64_t>(origin)),
+                         session_audio.begin() + (to - static_cast<int64_t>(origin)));
+    }
+
+    std::string text;
+    if (!redecode_state) redecode_state = whisper_init_state(ctx);
+    if (redecode_state && static_cast<int>(audio.size()) >= SAMPLES_PER_CTX) {
+        whisper_full_params params = whisper_full_default_params(WHISPER_SAMPLING_BEAM_SEARCH);
+        params.print_progress        = false;
+        params.print_special         = false;
+        params.print_realtime        = false;
+        params.print_timestamps      = false;
+        params.single_segment        = true;
+        params.no_context            = true;
+        params.language              = "en";
+        params.n_threads             = config::inference_threads();
+        params.beam_search.beam_size = REDECODE_BEAM;
+        params.audio_ctx = std::min(MAX_AUDIO_CTX,
+                                    static_cast<int>(audio.size()) / SAMPLES_PER_CTX + 1);
+        if (prompt.size() > REDECODE_PROMPT)
+            prompt.erase(0, prompt.size() - REDECODE_PROMPT);
+        params.initial_prompt = prompt.c_str();
+        params.abort_callback = [](void* data) -> bool {
+            return !static_cast<Impl*>(data)->running.load();
+        };
+        params.abort_callback_user_data = this;
+
+        if (whisper_full_with_state(ctx, redecode_state, params, audio.data(),
+                                    static_cast<int>(audio.size())) == 0) {
+            int n_seg = whisper_full_n_segments_from_state(redecode_state);
+            for (int i = 0; i < n_seg; ++i)
+                text += whisper_full_get_segment_text_from_state(redecode_state, i);
+            text = strip_noise_labels(text);
+        }
+    }
+    if (cb) cb(text);
 }
 
 // ---------------------------------------------------------------------------
@@ -103,60 +642,122 @@ std::string Transcriber::Impl::run_whisper(const std::vector<float>& audio) {
 // loops self-correct with more context.
 // ---------------------------------------------------------------------------
 void Transcriber::Impl::streaming_loop() {
+    metrics::register_thread("inference");
+    profiler::register_thread("inference", true);   // with ggml's workers
     bool first_iter = true;
-    std::string last_partial;
 
     while (running.load()) {
-        int interval = first_iter ? INITIAL_INTERVAL_MS : STREAM_INTERVAL_MS;
+        const config::Tuning tuning = config::current();
+        int interval = first_iter ? tuning.initial_interval_ms : tuning.stream_interval_ms;
         first_iter = false;
 
+        // The interval is a cap: a word boundary starts the pass earlier,
+        // once min_pass_gap_ms have passed. A boundary found during the gap
+        // or the last pass is kept for then.
         {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(interval);
+            auto stop_or_redecode = [this] { return !running.load() || redecode_pending; };
             std::unique_lock<std::mutex> lk(stop_mutex);
-            stop_cv.wait_for(lk, std::chrono::milliseconds(interval),
-                             [this] { return !running.load(); });
+            stop_cv.wait_for(lk, std::chrono::milliseconds(std::min(tuning.min_pass_gap_ms, interval)),
+                             stop_or_redecode);
+            stop_cv.wait_until(lk, deadline,
+                               [&] { return stop_or_redecode() || boundary.load(); });
         }
         if (!running.load()) break;
+        if (boundary.exchange(false)) boundary_passes->add();
+        run_redecode();
+        if (paused.load() && !wait_for_speech()) continue;
 
         // Snapshot audio buffer. If it exceeds the commit threshold and we
         // have partial text, save that text as confirmed and clear the buffer.
         std::vector<float> audio;
+        bool committed = false;
         {
             std::lock_guard<std::mutex> lk(audio_mutex);
 
-            if (audio_buf.size() > static_cast<size_t>(COMMIT_SAMPLES)
+            if (audio_buf.size() > static_cast<size_t>(tuning.commit_samples)
                 && !last_partial.empty())
             {
-                if (confirmed_text.empty())
-                    confirmed_text = last_partial;
-                else
-                    confirmed_text += " " + last_partial;
+                confirmed_spans = join_confirmed(partial_spans);
+                confirmed_text  = join_confirmed(last_partial);
                 audio_buf.clear();
                 last_partial.clear();
+                partial_spans.clear();
+                clear_tokens();
+                pass_samples = 0;
+                committed = true;
             }
 
             audio = audio_buf;
+            pass_origin = total_samples.load() - audio_buf.size();
         }
-        if (static_cast<int>(audio.size()) < MIN_SAMPLES) continue;
+        float audio_seconds = static_cast<float>(total_samples.load()) / SAMPLE_RATE;
+        if (committed)
+            deliver(confirmed_text, confirmed_spans, true, audio_seconds);
+        if (static_cast<int>(audio.size()) < tuning.min_samples) continue;
 
         abort_inference = false;
         if (!running.load()) break;
-        std::string text = run_whisper(audio);
-        if (abort_inference.load()) break;
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<TextSpan> spans;
+        std::string text = run_whisper(audio, &spans);
+        if (!running.load()) break;
+        if (paused.load()) continue;  // aborted or outdated by an edit
+        float pass_ms = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+        pass_hist->record(pass_ms);
+        rtf_hist->record(pass_ms * SAMPLE_RATE / 1000.0 / audio.size());
 
-        last_partial = text;
+        last_partial  = text;
+        partial_spans = std::move(spans);
+        pass_samples  = audio.size();
 
         // Build full display text: confirmed chunks + current partial
-        std::string display;
-        if (confirmed_text.empty())
-            display = text;
-        else if (text.empty())
-            display = confirmed_text;
-        else
-            display = confirmed_text + " " + text;
+        deliver(join_confirmed(text), join_confirmed(partial_spans), false, audio_seconds, pass_ms);
+    }
+
+    profiler::unregister_thread();
+    metrics::unregister_thread();
+}
+
+std::string Transcriber::Impl::join_confirmed(const std::string& text) const {
+    if (confirmed_text.empty())
+        return text;
+    if (text.empty())
+        return confirmed_text;
+    return confirmed_text + " " + text;
+}
+
+std::vector<Transcriber::TextSpan>
+Transcriber::Impl::join_confirmed(const std::vector<TextSpan>& spans) const {
+    std::vector<TextSpan> joined = confirmed_spans;
+    size_t shift = confirmed_text.empty() ? 0 : confirmed_text.size() + 1;
+    for (TextSpan span : spans) {
+        span.begin += shift;
+        span.end   += shift;
+        joined.push_back(span);
+    }
+    return joined;
+}
 
-        if (callback)
-            callback(display);
+void Transcriber::Impl::deliver(const std::string& display, const std::vector<TextSpan>& spans,
+                                bool final, float audio_seconds, float pass_ms) {
+    if (callback)
+        callback(display);
+
+    if (result_callback) {
+        Result r;
+        r.text          = display;
+        r.stable        = final ? display : stable_prefix(last_display, display);
+        r.final         = final;
+        r.audio_seconds = audio_seconds;
+        r.pass_ms       = pass_ms;
+        r.decode_steps  = pass_ms > 0.0f ? decode_steps : 0;
+        r.segment       = segment;
+        r.spans         = spans;
+        result_callback(r);
     }
+    last_display = display;
 }
 
 // ---------------------------------------------------------------------------
@@ -179,23 +780,41 @@ bool Transcriber::init(const std::string& model_path)
 
 void Transcriber::shutdown()
 {
+    if (impl_->redecode_state) {
+        whisper_free_state(impl_->redecode_state);
+        impl_->redecode_state = nullptr;
+    }
     if (impl_->ctx) {
         whisper_free(impl_->ctx);
         impl_->ctx = nullptr;
     }
 }
 
+void Transcriber::abandon()
+{
+    impl_->redecode_state = nullptr;
+    impl_->ctx = nullptr;
+}
+
 void Transcriber::start()
 {
     if (impl_->running.load()) return;
 
-    impl_->confirmed_text.clear();
+    impl_->clear_text();
+    impl_->clear_tokens();
     impl_->abort_inference = false;
     impl_->running = true;
     impl_->thread = std::thread([this] { impl_->streaming_loop(); });
 }
 
 void Transcriber::stop()
+{
+    cancel();
+    if (impl_->thread.joinable())
+        impl_->thread.join();
+}
+
+void Transcriber::cancel()
 {
     if (!impl_->running.load()) return;
 
@@ -205,20 +824,63 @@ void Transcriber::stop()
     impl_->running = false;
     impl_->abort_inference = true;
     impl_->stop_cv.notify_all();
+}
 
-    if (impl_->thread.joinable())
-        impl_->thread.join();
+void Transcriber::finish()
+{
+    stop();
+
+    std::vector<float> audio;
+    {
+        std::lock_guard<std::mutex> lk(impl_->audio_mutex);
+        impl_->pass_origin = impl_->total_samples.load() - impl_->audio_buf.size();
+        audio.swap(impl_->audio_buf);
+    }
+
+    // Too little audio for a meaningful pass — keep the last partial as is
+    std::string text = impl_->last_partial;
+    std::vector<TextSpan> spans = impl_->partial_spans;
+    float pass_ms = 0.0f;
+    if (static_cast<int>(audio.size()) >= config::current().min_samples) {
+        impl_->abort_inference = false;
+        auto t0 = std::chrono::steady_clock::now();
+        text = impl_->run_whisper(audio, &spans);
+        pass_ms = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+    }
+
+    impl_->confirmed_spans = impl_->join_confirmed(spans);
+    impl_->confirmed_text  = impl_->join_confirmed(text);
+    impl_->last_partial.clear();
+    impl_->partial_spans.clear();
+    impl_->clear_tokens();
+    impl_->deliver(impl_->confirmed_text, impl_->confirmed_spans, true, recording_seconds(), pass_ms);
 }
 
 void Transcriber::process(const float* samples, uint32_t n)
 {
     if (!impl_->ctx || n == 0) return;
 
+    bool at_boundary;
     {
         std::lock_guard<std::mutex> lk(impl_->audio_mutex);
         impl_->audio_buf.insert(impl_->audio_buf.end(), samples, samples + n);
+        impl_->total_samples += n;
+
+        std::vector<float>& session = impl_->session_audio;
+        session.insert(session.end(), samples, samples + n);
+        if (session.size() > SESSION_SAMPLES + SESSION_TRIM)
+            session.erase(session.begin(), session.begin() + static_cast<long>(session.size() - SESSION_SAMPLES));
+
+        at_boundary = impl_->detect_boundary(samples, n);
+    }
+    if (at_boundary) {
+        {
+            std::lock_guard<std::mutex> lk(impl_->stop_mutex);
+            impl_->boundary = true;
+        }
+        impl_->stop_cv.notify_all();
     }
-    impl_->total_samples += n;
 }
 
 std::string Transcriber::full_text() const
@@ -236,12 +898,51 @@ void Transcriber::reset()
     {
         std::lock_guard<std::mutex> lk(impl_->audio_mutex);
         impl_->audio_buf.clear();
+        impl_->session_audio.clear();
+        impl_->total_samples = 0;
+        impl_->detector = {};
+        ++impl_->generation;   // positions restart: cached encoder output is stale
+    }
+    impl_->clear_text();
+    impl_->clear_tokens();
+}
+
+void Transcriber::pause()
+{
+    impl_->last_edit_ms = now_ms();
+    if (!impl_->paused.exchange(true))
+        impl_->abort_inference = true;  // the running pass would be discarded anyway
+}
+
+bool Transcriber::paused() const
+{
+    return impl_->paused.load();
+}
+
+void Transcriber::redecode(float t0, float t1, const std::string& prompt, RedecodeCallback cb)
+{
+    {
+        std::lock_guard<std::mutex> lk(impl_->stop_mutex);
+        impl_->redecode_pending = true;
+        impl_->redecode_t0      = t0;
+        impl_->redecode_t1      = t1;
+        impl_->redecode_prompt  = prompt;
+        impl_->redecode_cb      = std::move(cb);
     }
-    impl_->confirmed_text.clear();
-    impl_->total_samples = 0;
+    impl_->stop_cv.notify_all();
+}
+
+void Transcriber::set_decoding(Decoding mode)
+{
+    impl_->decoding = mode;
 }
 
 void Transcriber::set_callback(TextCallback cb)
 {
     impl_->callback = std::move(cb);
 }
+
+void Transcriber::set_result_callback(ResultCallback cb)
+{
+    impl_->result_callback = std::move(cb);
+}
@@ -13,6 +13,36 @@
 struct Transcriber {
     using TextCallback = std::function<void(const std::string& text)>;
 
+    // Audio behind a piece of result text: bytes [begin, end) of the text
+    // were decoded from recording time [t0, t1) seconds (one per token).
+    struct TextSpan {
+        size_t begin = 0;
+        size_t end   = 0;
+        float  t0    = 0.0f;
+        float  t1    = 0.0f;
+    };
+
+    // Structured result of one inference pass.
+    struct Result {
+        std::string text;           // full text so far (committed + partial)
+        std::string stable;         // prefix of text unchanged since the previous pass
+        bool        final = false;  // text is committed and will not be revised
+        float       audio_seconds = 0.0f;  // recording time when the pass started
+        float       pass_ms = 0.0f;        // inference time of the pass (0 if none ran)
+        int         decode_steps = 0;      // decoder evaluations in the pass
+        uint32_t    segment = 0;           // bumped each time passes resume after pause()
+        std::vector<TextSpan> spans;       // token timings of text, in order
+    };
+    using ResultCallback   = std::function<void(const Result& result)>;
+    using RedecodeCallback = std::function<void(const std::string& text)>;
+
+    // How each pass decodes the growing buffer.
+    enum class Decoding {
+        Full,          // whisper_full(): every token from scratch
+        ForcedPrefix,  // force the previous hypothesis' stable tokens in one
+                       // batched step, generate only the rest
+    };
+
     Transcriber();
     ~Transcriber();
 
@@ -22,10 +52,23 @@ struct Transcriber {
     bool init(const std::string& model_path);
     void shutdown();
 
+    // Drop the model without freeing it, for a process about to exit: the
+    // kernel reclaims the pages faster than whisper_free() walks them.
+    // Call after stop().
+    void abandon();
+
     // Start/stop the background streaming inference thread.
     void start();
     void stop();
 
+    // Abort the running pass and tell the streaming thread to exit without
+    // waiting for it; stop() joins it later.
+    void cancel();
+
+    // Stop the streaming thread, transcribe the audio left in the buffer and
+    // deliver everything as a final result. Blocks until that pass is done.
+    void finish();
+
     // Feed audio samples (non-blocking — just appends to buffer).
     void process(const float* samples, uint32_t n);
 
@@ -38,9 +81,29 @@ struct Transcriber {
     // Reset all state (clear buffers and text).
     void reset();
 
+    // The user is editing the text: stop running passes and drop the audio
+    // the delivered text already covers. Call on every edit; audio keeps
+    // buffering. Passes resume by themselves once edits have stopped for a
+    // moment and new speech arrives, starting a new segment whose text
+    // (Result::segment) begins empty.
+    void pause();
+    bool paused() const;
+
+    // Decode recording time [t0, t1) again with beam search, prompted with
+    // the text before it, and hand the replacement text to cb (empty on
+    // failure) on the inference thread. The encoder only sees the span, so
+    // the cost follows its length. A newer request replaces a queued one.
+    void redecode(float t0, float t1, const std::string& prompt, RedecodeCallback cb);
+
+    // Select the decoding mode (takes effect on the next pass).
+    void set_decoding(Decoding mode);
+
     // Set callback for live text updates.
     void set_callback(TextCallback cb);
 
+    // Set callback for structured partial/final results.
+    void set_result_callback(ResultCallback cb);
+
 private:
     struct Impl;
     std::unique_ptr<Impl> impl_;
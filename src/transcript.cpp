@@ -0,0 +1,312 @@
+#include "transcript.h"
+
+#include <algorithm>
+#include <vector>
+
+// The byte store only grows; once it holds this many times the live text
+// (and at least COMPACT_MIN bytes) it is rewritten with just the live bytes
+static constexpr size_t COMPACT_RATIO = 4;
+static constexpr size_t COMPACT_MIN   = 1 << 20;
+
+using Origin = Transcript::Origin;
+
+struct Transcript::Impl {
+    struct Node {
+        size_t   off = 0;          // into store
+        size_t   len = 0;
+        Origin   origin = Origin::User;
+        uint32_t prio = 0;
+        int      left = -1;
+        int      right = -1;
+        size_t   bytes = 0;        // subtree totals
+        size_t   tentative = 0;
+    };
+
+    std::string       store;
+    std::vector<Node> nodes;
+    std::vector<int>  free_nodes;
+    int               root = -1;
+    uint32_t          rng = 0x9e3779b9u;
+
+    size_t bytes(int t) const { return t < 0 ? 0 : nodes[t].bytes; }
+    size_t tent(int t) const { return t < 0 ? 0 : nodes[t].tentative; }
+
+    void update(int t)
+    {
+        Node& n = nodes[t];
+        n.bytes     = bytes(n.left) + n.len + bytes(n.right);
+        n.tentative = tent(n.left) + (n.origin == Origin::Tentative ? n.len : 0) + tent(n.right);
+    }
+
+    int make(size_t off, size_t len, Origin origin)
+    {
+        // xorshift32: priorities only need to be unrelated to positions
+        rng ^= rng << 13;
+        rng ^= rng >> 17;
+        rng ^= rng << 5;
+
+        int t;
+        if (!free_nodes.empty()) {
+            t = free_nodes.back();
+            free_nodes.pop_back();
+            nodes[t] = Node{};
+        } else {
+            t = static_cast<int>(nodes.size());
+            nodes.emplace_back();
+        }
+        nodes[t].off    = off;
+        nodes[t].len    = len;
+        nodes[t].origin = origin;
+        nodes[t].prio   = rng;
+        update(t);
+        return t;
+    }
+
+    void release(int t)
+    {
+        if (t < 0) return;
+        release(nodes[t].left);
+        release(nodes[t].right);
+        free_nodes.push_back(t);
+    }
+
+    int merge(int a, int b)
+    {
+        if (a < 0) return b;
+        if (b < 0) return a;
+        if (nodes[a].prio > nodes[b].prio) {
+            int r = merge(nodes[a].right, b);
+            nodes[a].right = r;
+            update(a);
+            return a;
+        }
+        int l = merge(a, nodes[b].left);
+        nodes[b].left = l;
+        update(b);
+        return b;
+    }
+
+    // l gets the first pos bytes of t, r the rest; a piece straddling pos
+    // is cut in two
+    void split(int t, size_t pos, int* l, int* r)
+    {
+        if (t < 0) {
+            *l = *r = -1;
+            return;
+        }
+        size_t before = bytes(nodes[t].left);
+        if (pos <= before) {
+            int ll, lr;
+            split(nodes[t].left, pos, &ll, &lr);
+            nodes[t].left = lr;
+            update(t);
+            *l = ll;
+            *r = t;
+        } else if (pos >= before + nodes[t].len) {
+            int rl, rr;
+            split(nodes[t].right, pos - before - nodes[t].len, &rl, &rr);
+            nodes[t].right = rl;
+            update(t);
+            *l = t;
+            *r = rr;
+        } else {
+            size_t k = pos - before;
+            int tail = make(nodes[t].off + k, nodes[t].len - k, nodes[t].origin);
+            int right = nodes[t].right;
+            nodes[t].len   = k;
+            nodes[t].right = -1;
+            update(t);
+            *l = t;
+            *r = merge(tail, right);
+        }
+    }
+
+    // Node holding byte pos, and pos within it
+    int find(size_t pos, size_t* in_piece) const
+    {
+        int t = root;
+        while (t >= 0) {
+            size_t before = bytes(nodes[t].left);
+            if (pos < before) {
+                t = nodes[t].left;
+            } else if (pos < before + nodes[t].len) {
+                *in_piece = pos - before;
+                return t;
+            } else {
+                pos -= before + nodes[t].len;
+                t = nodes[t].right;
+            }
+        }
+        return -1;
+    }
+
+    void collect(int t, std::string* out) const
+    {
+        if (t < 0) return;
+        collect(nodes[t].left, out);
+        out->append(store, nodes[t].off, nodes[t].len);
+        collect(nodes[t].right, out);
+    }
+
+    void settle(int t)
+    {
+        if (t < 0 || nodes[t].tentative == 0) return;
+        settle(nodes[t].left);
+        settle(nodes[t].right);
+        if (nodes[t].origin == Origin::Tentative) nodes[t].origin = Origin::Committed;
+        update(t);
+    }
+
+    // Rewrite the store with only the bytes still referenced, in order
+    void compact()
+    {
+        std::string packed;
+        packed.reserve(bytes(root));
+        relocate(root, &packed);
+        store.swap(packed);
+    }
+
+    void relocate(int t, std::string* packed)
+    {
+        if (t < 0) return;
+        relocate(nodes[t].left, packed);
+        size_t off = packed->size();
+        packed->append(store, nodes[t].off, nodes[t].len);
+        nodes[t].off = off;
+        relocate(nodes[t].right, packed);
+    }
+};
+
+Transcript::Transcript() : impl_(std::make_unique<Impl>()) {}
+Transcript::~Transcript() = default;
+
+size_t Transcript::size() const
+{
+    return impl_->bytes(impl_->root);
+}
+
+void Transcript::insert(size_t pos, const char* text, size_t n, Origin origin)
+{
+    if (n == 0) return;
+    Impl& m = *impl_;
+    pos = std::min(pos, size());
+
+    size_t off = m.store.size();
+    m.store.append(text, n);
+
+    int l, r;
+    m.split(m.root, pos, &l, &r);
+
+    // Typing extends the piece before the caret when that piece was the
+    // last thing stored
+    int last = l;
+    std::vector<int> spine;
+    while (last >= 0) {
+        spine.push_back(last);
+        last = m.nodes[last].right;
+    }
+    if (!spine.empty()) {
+        Impl::Node& prev = m.nodes[spine.back()];
+        if (prev.origin == origin && prev.off + prev.len == off) {
+            prev.len += n;
+            for (auto it = spine.rbegin(); it != spine.rend(); ++it) m.update(*it);
+            m.root = m.merge(l, r);
+            return;
+        }
+    }
+    m.root = m.merge(m.merge(l, m.make(off, n, origin)), r);
+}
+
+void Transcript::erase(size_t pos, size_t n)
+{
+    Impl& m = *impl_;
+    if (n == 0 || pos >= size()) return;
+
+    int l, mid, r;
+    m.split(m.root, pos, &l, &mid);
+    m.split(mid, n, &mid, &r);
+    m.release(mid);
+    m.root = m.merge(l, r);
+
+    if (m.store.size() > COMPACT_MIN && m.store.size() > COMPACT_RATIO * size())
+        m.compact();
+}
+
+bool Transcript::tentative(size_t* pos, size_t* len) const
+{
+    const Impl& m = *impl_;
+    if (m.tent(m.root) == 0) return false;
+
+    // First tentative byte: leftmost node with tentative bytes
+    size_t first = 0;
+    for (int t = m.root; t >= 0; ) {
+        const Impl::Node& n = m.nodes[t];
+        if (m.tent(n.left) > 0) {
+            t = n.left;
+        } else if (n.origin == Origin::Tentative) {
+            first += m.bytes(n.left);
+            break;
+        } else {
+            first += m.bytes(n.left) + n.len;
+            t = n.right;
+        }
+    }
+    // One past the last: mirror image
+    size_t end = size();
+    for (int t = m.root; t >= 0; ) {
+        const Impl::Node& n = m.nodes[t];
+        if (m.tent(n.right) > 0) {
+            t = n.right;
+        } else if (n.origin == Origin::Tentative) {
+            end -= m.bytes(n.right);
+            break;
+        } else {
+            end -= m.bytes(n.right) + n.len;
+            t = n.left;
+        }
+    }
+    *pos = first;
+    *len = end - first;
+    return true;
+}
+
+size_t Transcript::set_tentative(size_t pos, const char* text, size_t n)
+{
+    size_t len = 0;
+    if (tentative(&pos, &len)) erase(pos, len);
+    insert(pos, text, n, Origin::Tentative);
+    return std::min(pos, size());
+}
+
+void Transcript::settle()
+{
+    impl_->settle(impl_->root);
+}
+
+char Transcript::at(size_t pos) const
+{
+    size_t k;
+    int t = impl_->find(pos, &k);
+    return t < 0 ? '\0' : impl_->store[impl_->nodes[t].off + k];
+}
+
+std::string Transcript::text() const
+{
+    std::string out;
+    out.reserve(size());
+    impl_->collect(impl_->root, &out);
+    return out;
+}
+
+void Transcript::resync(const char* text, size_t n)
+{
+    std::string cur = this->text();
+    size_t prefix = 0;
+    size_t lim = std::min(cur.size(), n);
+    while (prefix < lim && cur[prefix] == text[prefix]) ++prefix;
+    size_t suffix = 0;
+    while (suffix < lim - prefix && cur[cur.size() - 1 - suffix] == text[n - 1 - suffix]) ++suffix;
+
+    erase(prefix, cur.size() - prefix - suffix);
+    insert(prefix, text + prefix, n - prefix - suffix, Origin::User);
+}
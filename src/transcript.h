@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Piece table behind the transcript field. Every byte is tagged with where
+// it came from; the live span of the current segment is the Tentative
+// bytes. Pieces sit in an implicit treap keyed by byte offset over an
+// append-only byte store, so inserts and erases cost O(log pieces) plus the
+// bytes inserted, whatever the length of the transcript.
+//
+// The text field itself still needs one contiguous buffer; ui.cpp mirrors
+// its splices and the user's edits here.
+struct Transcript {
+    enum class Origin : uint8_t {
+        Committed,   // transcriber text no longer revised
+        Tentative,   // the live span, replaced by every pass
+        User,        // typed or pasted by the user
+    };
+
+    Transcript();
+    ~Transcript();
+
+    Transcript(const Transcript&) = delete;
+    Transcript& operator=(const Transcript&) = delete;
+
+    size_t size() const;
+
+    void insert(size_t pos, const char* text, size_t n, Origin origin);
+    void erase(size_t pos, size_t n);
+
+    // Range from the first to the last Tentative byte; false if none.
+    bool tentative(size_t* pos, size_t* len) const;
+
+    // Replace the Tentative bytes with text, or insert it at `pos` if there
+    // are none. Returns where the new span starts.
+    size_t set_tentative(size_t pos, const char* text, size_t n);
+
+    // Freeze the live span: Tentative bytes become Committed.
+    void settle();
+
+    char   at(size_t pos) const;
+    std::string text() const;
+
+    // Match text when an edit's range is unknown (undo, several edits in
+    // one frame): keeps the common prefix and suffix with their origins and
+    // replaces the rest with User bytes. O(length).
+    void resync(const char* text, size_t n);
+
+private:
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
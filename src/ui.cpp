@@ -0,0 +1,301 @@
+#include "ui.h"
+
+#include "imgui.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace ui {
+
+// ---------------------------------------------------------------------------
+// Live span splicing
+// ---------------------------------------------------------------------------
+
+// live_text trimmed and padded with a space where it would otherwise run
+// into the text around the span. Sets live_origin for the result.
+static std::string padded_live_text(const char* buf, int len, State& state)
+{
+    const std::string& t = state.live_text;
+    size_t b = t.find_first_not_of(" \t\n");
+    state.live_origin = state.live_pos;
+    if (b == std::string::npos) return {};
+    std::string out = t.substr(b, t.find_last_not_of(" \t\n") + 1 - b);
+
+    int after = state.live_pos + state.live_len;
+    if (state.live_pos > 0 && !std::isspace(static_cast<unsigned char>(buf[state.live_pos - 1])))
+        out.insert(0, 1, ' ');
+    if (after < len && !std::isspace(static_cast<unsigned char>(buf[after])))
+        out += ' ';
+    state.live_origin = state.live_pos + (out[0] == ' ' ? 1 : 0) - static_cast<int>(b);
+    return out;
+}
+
+// Bytes of text that fit in `room`, not splitting a UTF-8 sequence.
+static int fit_utf8(const std::string& text, int room)
+{
+    int n = static_cast<int>(text.size());
+    if (n <= room) return n;
+    n = room < 0 ? 0 : room;
+    while (n > 0 && (static_cast<unsigned char>(text[n]) & 0xC0) == 0x80) --n;
+    return n;
+}
+
+// Mirror a splice of n bytes of text over the live span into the model.
+static void mirror_splice(State& state, const char* text, int n)
+{
+    if (state.transcript) state.transcript->set_tentative(state.live_pos, text, n);
+}
+
+// Mirror a user edit. The field only reports that something changed, so the
+// range comes from the caret: the edit replaced [from, from + removed) of
+// the old text (the selection, or what backspace/delete took) with the bytes
+// before the new caret. Whatever does not fit that shape, like undo or
+// several edits within one frame, shows up as a length or boundary mismatch
+// and falls back to a resync.
+static void mirror_edit(State& state, const char* buf, int len, int caret)
+{
+    Transcript* t = state.transcript;
+    if (!t) return;
+    int old_len = static_cast<int>(t->size());
+    int a = state.sel_begin < state.sel_end ? state.sel_begin : state.cursor;
+    int from     = std::min(a, caret);
+    int inserted = caret - from;
+    int removed  = old_len - len + inserted;
+
+    bool fits = from >= 0 && removed >= 0 && from + removed <= old_len
+        && (from == 0 || t->at(from - 1) == buf[from - 1])
+        && (from + removed == old_len || t->at(from + removed) == buf[from + inserted]);
+    if (!fits) {
+        t->resync(buf, len);
+        return;
+    }
+    t->erase(from, removed);
+    t->insert(from, buf + from, inserted, Transcript::Origin::User);
+}
+
+// Put the live span over the model's Tentative bytes. With none left (the
+// user edited them all away) the span is empty, so the splice in the buffer
+// removes the same bytes as set_tentative() does in the model.
+static void locate_span(State& state)
+{
+    size_t pos, len;
+    if (!state.transcript) return;
+    if (state.transcript->tentative(&pos, &len)) {
+        state.live_pos = static_cast<int>(pos);
+        state.live_len = static_cast<int>(len);
+    } else {
+        state.live_len = 0;
+    }
+}
+
+static void clamp_span(State& state, int len)
+{
+    state.live_pos = std::min(std::max(state.live_pos, 0), len);
+    state.live_len = std::min(std::max(state.live_len, 0), len - state.live_pos);
+}
+
+// Field without focus: edit the buffer directly.
+static void splice_buffer(State& state)
+{
+    int len = state.transcript ? static_cast<int>(state.transcript->size())
+                               : static_cast<int>(std::strlen(state.text));
+    locate_span(state);
+    clamp_span(state, len);
+    std::string text = padded_live_text(state.text, len, state);
+    int room = static_cast<int>(state.text_cap) - 1 - (len - state.live_len);
+    int n = fit_utf8(text, room);
+
+    char* at = state.text + state.live_pos;
+    std::memmove(at + n, at + state.live_len, len - state.live_pos - state.live_len + 1);
+    std::memcpy(at, text.data(), n);
+    mirror_splice(state, text.data(), n);
+    state.live_len   = n;
+    state.live_dirty = false;
+}
+
+// Field with focus: go through the callback so ImGui's copy stays in sync.
+static int text_callback(ImGuiInputTextCallbackData* data)
+{
+    auto& state = *static_cast<State*>(data->UserData);
+    if (data->EventFlag == ImGuiInputTextFlags_CallbackEdit) {
+        state.user_edit = true;
+        mirror_edit(state, data->Buf, data->BufTextLen, data->CursorPos);
+    } else if (state.live_dirty) {
+        locate_span(state);
+        clamp_span(state, data->BufTextLen);
+        std::string text = padded_live_text(data->Buf, data->BufTextLen, state);
+        int room = data->BufSize - 1 - (data->BufTextLen - state.live_len);
+        int n = fit_utf8(text, room);
+
+        data->DeleteChars(state.live_pos, state.live_len);
+        data->InsertChars(state.live_pos, text.data(), text.data() + n);
+        mirror_splice(state, text.data(), n);
+        state.live_len   = n;
+        state.live_dirty = false;
+    }
+    state.cursor    = data->CursorPos;
+    state.sel_begin = std::min(data->SelectionStart, data->SelectionEnd);
+    state.sel_end   = std::max(data->SelectionStart, data->SelectionEnd);
+    return 0;
+}
+
+void apply_style(float scale)
+{
+    auto& style = ImGui::GetStyle();
+
+    // Scale all default sizes for HiDPI, then override specific values
+    style.ScaleAllSizes(scale);
+
+    // Geometry (set after ScaleAllSizes — these are direct overrides)
+    style.WindowRounding    = 12.0f;
+    style.WindowBorderSize  = 0.0f;
+    style.WindowPadding     = ImVec2(16.0f, 12.0f);
+    style.FrameRounding     = 6.0f;
+    style.FramePadding      = ImVec2(12.0f, 8.0f);
+    style.ItemSpacing       = ImVec2(8.0f, 8.0f);
+    style.ScrollbarSize     = 10.0f;
+    style.ScrollbarRounding = 4.0f;
+    style.GrabRounding      = 4.0f;
+
+    // Colors — dark translucent overlay
+    auto& c = style.Colors;
+    c[ImGuiCol_WindowBg]          = ImVec4(0.08f, 0.08f, 0.10f, 1.00f);
+    c[ImGuiCol_Border]            = ImVec4(0.20f, 0.20f, 0.25f, 0.50f);
+
+    // Text
+    c[ImGuiCol_Text]              = ImVec4(0.90f, 0.90f, 0.93f, 1.00f);
+    c[ImGuiCol_TextDisabled]      = ImVec4(0.45f, 0.45f, 0.50f, 1.00f);
+
+    // Frame (text input background)
+    c[ImGuiCol_FrameBg]           = ImVec4(0.12f, 0.12f, 0.15f, 1.00f);
+    c[ImGuiCol_FrameBgHovered]    = ImVec4(0.16f, 0.16f, 0.20f, 1.00f);
+    c[ImGuiCol_FrameBgActive]     = ImVec4(0.14f, 0.14f, 0.18f, 1.00f);
+
+    // Scrollbar
+    c[ImGuiCol_ScrollbarBg]       = ImVec4(0.08f, 0.08f, 0.10f, 0.50f);
+    c[ImGuiCol_ScrollbarGrab]     = ImVec4(0.25f, 0.25f, 0.30f, 1.00f);
+    c[ImGuiCol_ScrollbarGrabHovered] = ImVec4(0.35f, 0.35f, 0.40f, 1.00f);
+    c[ImGuiCol_ScrollbarGrabActive]  = ImVec4(0.40f, 0.40f, 0.45f, 1.00f);
+
+    // Separator
+    c[ImGuiCol_Separator]         = ImVec4(0.22f, 0.22f, 0.28f, 1.00f);
+
+    // Header (for the status bar area)
+    c[ImGuiCol_Header]            = ImVec4(0.15f, 0.15f, 0.20f, 1.00f);
+    c[ImGuiCol_HeaderHovered]     = ImVec4(0.20f, 0.20f, 0.26f, 1.00f);
+    c[ImGuiCol_HeaderActive]      = ImVec4(0.18f, 0.18f, 0.24f, 1.00f);
+
+    // Text selection
+    c[ImGuiCol_TextSelectedBg]    = ImVec4(0.22f, 0.35f, 0.55f, 0.60f);
+    c[ImGuiCol_NavHighlight]      = ImVec4(0.30f, 0.50f, 0.80f, 1.00f);
+}
+
+bool draw(State& state)
+{
+    ImGuiIO& io = ImGui::GetIO();
+
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("##overlay", nullptr,
+                 ImGuiWindowFlags_NoTitleBar |
+                 ImGuiWindowFlags_NoResize |
+                 ImGuiWindowFlags_NoMove |
+                 ImGuiWindowFlags_NoScrollbar |
+                 ImGuiWindowFlags_NoCollapse |
+                 ImGuiWindowFlags_NoBringToFrontOnFocus);
+
+    // Header bar
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.55f, 0.55f, 0.60f, 1.0f));
+    ImGui::Text("LIVE-WHISPER");
+    ImGui::PopStyleColor();
+    const char* keys = "Ctrl+R: redo selection  |  Enter: accept  |  Esc: cancel";
+    ImGui::SameLine(io.DisplaySize.x - ImGui::CalcTextSize(keys).x
+                    - ImGui::GetStyle().WindowPadding.x);
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.40f, 0.40f, 0.45f, 1.0f));
+    ImGui::TextUnformatted(keys);
+    ImGui::PopStyleColor();
+
+    ImGui::Spacing();
+    ImGui::Separator();
+    ImGui::Spacing();
+
+    // Text area fills remaining space minus status line
+    float status_height = ImGui::GetFrameHeightWithSpacing() + ImGui::GetStyle().ItemSpacing.y;
+    float text_height = ImGui::GetContentRegionAvail().y - status_height;
+    if (state.live_dirty && !state.active)
+        splice_buffer(state);
+    state.user_edit = false;
+    ImGui::InputTextMultiline("##text", state.text, state.text_cap,
+                              ImVec2(-1.0f, text_height),
+                              ImGuiInputTextFlags_AllowTabInput |
+                              ImGuiInputTextFlags_WordWrap |
+                              ImGuiInputTextFlags_CallbackEdit |
+                              ImGuiInputTextFlags_CallbackAlways,
+                              text_callback, &state);
+    bool was_active = state.active;
+    state.active = ImGui::IsItemActive();
+
+    // Once per focus change, catch anything mirror_edit() guessed wrong
+    // without noticing
+    if (was_active && !state.active && state.transcript)
+        state.transcript->resync(state.text, std::strlen(state.text));
+    bool edited = state.user_edit;
+    if (state.active && ImGui::IsKeyChordPressed(ImGuiMod_Ctrl | ImGuiKey_R))
+        state.redecode_requested = true;
+
+    // Status line
+    float secs = state.recording_seconds;
+    int mins = static_cast<int>(secs) / 60;
+    int s    = static_cast<int>(secs) % 60;
+    if (state.notice.empty())
+        ImGui::TextDisabled("Recording %d:%02d", mins, s);
+    else
+        ImGui::TextDisabled("%s", state.notice.c_str());
+
+    ImGui::SameLine(ImGui::GetContentRegionAvail().x + ImGui::GetCursorPosX()
+                    - ImGui::CalcTextSize("Send Enter").x - ImGui::GetFrameHeight()
+                    - ImGui::GetStyle().ItemSpacing.x);
+    ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.45f, 0.45f, 0.50f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_CheckMark, ImVec4(0.45f, 0.45f, 0.50f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_FrameBg, ImVec4(0.15f, 0.15f, 0.18f, 1.0f));
+    ImGui::PushStyleColor(ImGuiCol_FrameBgHovered, ImVec4(0.20f, 0.20f, 0.24f, 1.0f));
+    ImGui::PushStyleVar(ImGuiStyleVar_FramePadding, ImVec2(3.0f, 3.0f));
+    ImGui::Checkbox("Send Enter", &state.auto_enter);
+    ImGui::PopStyleVar();
+    ImGui::PopStyleColor(4);
+
+    ImGui::End();
+    return edited;
+}
+
+void draw_progress(size_t done, size_t total)
+{
+    ImGuiIO& io = ImGui::GetIO();
+
+    ImGui::SetNextWindowPos(ImVec2(0, 0));
+    ImGui::SetNextWindowSize(io.DisplaySize);
+    ImGui::Begin("##progress", nullptr,
+                 ImGuiWindowFlags_NoTitleBar |
+                 ImGuiWindowFlags_NoResize |
+                 ImGuiWindowFlags_NoMove |
+                 ImGuiWindowFlags_NoScrollbar |
+                 ImGuiWindowFlags_NoCollapse |
+                 ImGuiWindowFlags_NoInputs);
+
+    char label[64];
+    std::snprintf(label, sizeof(label), "Typing %zu / %zu", done, total);
+    const char* hint = "live-whisper --cancel to stop";
+    float fraction = total > 0 ? static_cast<float>(done) / static_cast<float>(total) : 0.0f;
+
+    ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0.30f, 0.50f, 0.80f, 1.0f));
+    ImGui::ProgressBar(fraction, ImVec2(io.DisplaySize.x * 0.5f, 0.0f), label);
+    ImGui::PopStyleColor();
+    ImGui::SameLine();
+    ImGui::TextDisabled("%s", hint);
+
+    ImGui::End();
+}
+
+} // namespace ui
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "transcript.h"
+
+#include <cstddef>
+#include <string>
+
+namespace ui {
+
+// Overlay state shared between the event loop and the UI code.
+struct State {
+    char*  text     = nullptr;  // editable transcript buffer
+    size_t text_cap = 0;
+    bool   auto_enter = true;
+    float  recording_seconds = 0.0f;
+
+    // Live transcript span: the bytes of text the transcriber owns. The
+    // event loop sets live_text and live_dirty; draw() splices it over
+    // [live_pos, live_pos + live_len), through the text field's callback
+    // while it has focus so an edit in progress sees it.
+    int         live_pos   = 0;
+    int         live_len   = 0;
+    std::string live_text;
+    bool        live_dirty = false;
+    int         live_origin = 0;  // offset of live_text[0] in text after the splice
+
+    // Model of text with origin tags: draw() mirrors every splice and edit
+    // into it, and while it has Tentative bytes they are the live span,
+    // wherever edits before them have moved it.
+    Transcript* transcript = nullptr;
+
+    int    cursor = 0;          // caret byte offset, tracked while the field has focus
+    int    sel_begin = 0;       // selection [sel_begin, sel_end), tracked likewise
+    int    sel_end   = 0;
+    bool   active = false;      // the text field had focus last frame
+    bool   user_edit = false;   // set by the field callback; draw() resets it
+    bool   redecode_requested = false;  // Ctrl+R this frame; cleared by the event loop
+    std::string notice;         // replaces the recording time in the status line
+};
+
+// Dark translucent theme, with sizes scaled for HiDPI.
+void apply_style(float scale);
+
+// Build the full-window overlay for the current frame (between NewFrame and
+// Render). Returns true if the user edited the text this frame; live span
+// splices do not count.
+bool draw(State& state);
+
+// Delivery indicator for the overlay shrunk by Overlay::set_indicator()
+// while the accepted text is typed.
+void draw_progress(size_t done, size_t total);
+
+} // namespace ui
@@ -0,0 +1,106 @@
+#include "wav.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static constexpr uint32_t SAMPLE_RATE = 16000;
+
+static constexpr uint16_t FORMAT_PCM        = 1;
+static constexpr uint16_t FORMAT_FLOAT      = 3;
+static constexpr uint16_t FORMAT_EXTENSIBLE = 0xFFFE;
+
+static uint16_t le16(const unsigned char* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+static uint32_t le32(const unsigned char* p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+namespace wav {
+
+bool read(const std::string& path, std::vector<float>* out)
+{
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) {
+        std::fprintf(stderr, "wav: cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    unsigned char riff[12];
+    if (std::fread(riff, 1, 12, f) != 12 ||
+        std::memcmp(riff, "RIFF", 4) != 0 || std::memcmp(riff + 8, "WAVE", 4) != 0) {
+        std::fprintf(stderr, "wav: %s is not a RIFF/WAVE file\n", path.c_str());
+        std::fclose(f);
+        return false;
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    uint32_t rate = 0;
+    bool have_fmt = false;
+
+    // Walk chunks until "data", picking up "fmt " on the way
+    unsigned char hdr[8];
+    while (std::fread(hdr, 1, 8, f) == 8) {
+        uint32_t size = le32(hdr + 4);
+
+        if (std::memcmp(hdr, "fmt ", 4) == 0 && size >= 16) {
+            std::vector<unsigned char> fmt(size);
+            if (std::fread(fmt.data(), 1, size, f) != size) break;
+            format   = le16(&fmt[0]);
+            channels = le16(&fmt[2]);
+            rate     = le32(&fmt[4]);
+            bits     = le16(&fmt[14]);
+            if (format == FORMAT_EXTENSIBLE && size >= 26)
+                format = le16(&fmt[24]);  // first two bytes of the sub-format GUID
+            have_fmt = true;
+        } else if (std::memcmp(hdr, "data", 4) == 0) {
+            if (!have_fmt || channels == 0) break;
+            if (rate != SAMPLE_RATE) {
+                std::fprintf(stderr, "wav: %s is %u Hz, need %u Hz\n",
+                             path.c_str(), rate, SAMPLE_RATE);
+                break;
+            }
+
+            bool pcm16 = format == FORMAT_PCM && bits == 16;
+            bool f32   = format == FORMAT_FLOAT && bits == 32;
+            if (!pcm16 && !f32) {
+                std::fprintf(stderr, "wav: %s: unsupported format %u/%u-bit\n",
+                             path.c_str(), format, bits);
+                break;
+            }
+
+            std::vector<unsigned char> data(size);
+            size_t got = std::fread(data.data(), 1, size, f);
+            size_t frame_bytes = static_cast<size_t>(channels) * (bits / 8);
+            size_t frames = got / frame_bytes;
+
+            out->resize(frames);
+            for (size_t i = 0; i < frames; ++i) {
+                const unsigned char* p = data.data() + i * frame_bytes;
+                float sum = 0.0f;
+                for (uint16_t c = 0; c < channels; ++c) {
+                    if (pcm16) {
+                        sum += static_cast<int16_t>(le16(p + c * 2)) / 32768.0f;
+                    } else {
+                        uint32_t u = le32(p + c * 4);
+                        float v;
+                        std::memcpy(&v, &u, sizeof(v));
+                        sum += v;
+                    }
+                }
+                (*out)[i] = sum / channels;
+            }
+            std::fclose(f);
+            return true;
+        } else {
+            std::fseek(f, size + (size & 1), SEEK_CUR);  // chunks are word aligned
+        }
+    }
+
+    std::fprintf(stderr, "wav: %s: no usable audio data\n", path.c_str());
+    std::fclose(f);
+    return false;
+}
+
+} // namespace wav
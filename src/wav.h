@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace wav {
+
+// Load a 16 kHz WAV file as mono float samples. Accepts 16-bit PCM and
+// 32-bit float data; multiple channels are mixed down.
+bool read(const std::string& path, std::vector<float>* out);
+
+} // namespace wav
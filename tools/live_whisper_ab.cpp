@@ -0,0 +1,261 @@
+// live-whisper-ab — compare experiment variants from the session log.
+//
+// Usage: live-whisper-ab [-c CONTROL] [FILE]
+//
+// FILE defaults to $XDG_STATE_HOME/live-whisper/sessions.jsonl. For each
+// metric, prints every variant's mean with a 95% confidence interval and
+// its difference from the control arm (Welch's t interval), as a percentage
+// of the control mean. A difference whose interval excludes zero is marked
+// with '*'.
+
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+static constexpr double MIN_AUDIO_S = 1.0;  // shorter sessions carry no signal
+
+struct Record {
+    std::string variant;
+    double audio_s = 0, first_partial_ms = -1, passes = 0, pass_ms = 0, cpu_s = 0;
+    double edits = 0, words = 0, accept_ms = -1;
+    bool   accepted = false;
+};
+
+// ---------------------------------------------------------------------------
+// Parsing: the log is flat JSON objects written by experiment.cpp
+// ---------------------------------------------------------------------------
+static bool field(const std::string& line, const char* key, std::string* out)
+{
+    std::string pat = std::string("\"") + key + "\":";
+    size_t pos = line.find(pat);
+    if (pos == std::string::npos) return false;
+    pos += pat.size();
+
+    out->clear();
+    if (pos < line.size() && line[pos] == '"') {
+        for (++pos; pos < line.size() && line[pos] != '"'; ++pos) {
+            if (line[pos] == '\\' && pos + 1 < line.size()) ++pos;
+            *out += line[pos];
+        }
+        return true;
+    }
+    size_t end = line.find_first_of(",}", pos);
+    *out = line.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+    return !out->empty();
+}
+
+static double number(const std::string& line, const char* key, double fallback)
+{
+    std::string v;
+    return field(line, key, &v) ? std::atof(v.c_str()) : fallback;
+}
+
+static bool parse(const std::string& line, Record* r)
+{
+    if (!field(line, "variant", &r->variant)) return false;
+    std::string accepted;
+    field(line, "accepted", &accepted);
+    r->accepted         = accepted == "true";
+    r->audio_s          = number(line, "audio_s", 0);
+    r->first_partial_ms = number(line, "first_partial_ms", -1);
+    r->passes           = number(line, "passes", 0);
+    r->pass_ms          = number(line, "pass_ms", 0);
+    r->cpu_s            = number(line, "cpu_s", 0);
+    r->edits            = number(line, "edits", 0);
+    r->words            = number(line, "words", 0);
+    r->accept_ms        = number(line, "accept_ms", -1);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Statistics
+// ---------------------------------------------------------------------------
+
+// Two-sided 95% quantile of Student's t with df degrees of freedom.
+static double t975(double df)
+{
+    static const double TABLE[] = {
+        12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+        2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+        2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042,
+    };
+    if (df < 1.0) return TABLE[0];
+    if (df <= 30.0) return TABLE[static_cast<int>(df) - 1];
+    return 1.960 + 2.4 / df;  // within 0.005 of the exact value beyond 30
+}
+
+struct Summary {
+    size_t n = 0;
+    double mean = 0, var = 0;   // sample variance
+};
+
+static Summary summarize(const std::vector<double>& xs)
+{
+    Summary s;
+    s.n = xs.size();
+    if (s.n == 0) return s;
+    for (double x : xs) s.mean += x;
+    s.mean /= s.n;
+    if (s.n > 1) {
+        for (double x : xs) s.var += (x - s.mean) * (x - s.mean);
+        s.var /= s.n - 1;
+    }
+    return s;
+}
+
+static double half_width(const Summary& s)
+{
+    return s.n > 1 ? t975(s.n - 1.0) * std::sqrt(s.var / s.n) : NAN;
+}
+
+// Welch interval for mean(b) - mean(a).
+static double welch_half_width(const Summary& a, const Summary& b)
+{
+    if (a.n < 2 || b.n < 2) return NAN;
+    double va = a.var / a.n, vb = b.var / b.n;
+    double se = std::sqrt(va + vb);
+    if (se == 0.0) return 0.0;
+    double df = (va + vb) * (va + vb)
+              / (va * va / (a.n - 1) + vb * vb / (b.n - 1));
+    return t975(df) * se;
+}
+
+// ---------------------------------------------------------------------------
+// Metrics: each maps a session to a value, or skips it
+// ---------------------------------------------------------------------------
+struct Metric {
+    const char* name;
+    bool (*value)(const Record&, double*);
+};
+
+static const Metric METRICS[] = {
+    {"first partial ms", [](const Record& r, double* v) {
+        *v = r.first_partial_ms; return r.first_partial_ms >= 0; }},
+    {"pass ms", [](const Record& r, double* v) {
+        *v = r.pass_ms; return r.passes > 0; }},
+    {"passes / audio min", [](const Record& r, double* v) {
+        *v = r.passes * 60.0 / r.audio_s; return true; }},
+    {"cpu s / audio s", [](const Record& r, double* v) {
+        *v = r.cpu_s / r.audio_s; return true; }},
+    {"edits / 100 words", [](const Record& r, double* v) {
+        *v = r.edits * 100.0 / r.words; return r.accepted && r.words > 0; }},
+    {"accepted %", [](const Record& r, double* v) {
+        *v = r.accepted ? 100.0 : 0.0; return true; }},
+    {"enter to key ms", [](const Record& r, double* v) {
+        *v = r.accept_ms; return r.accept_ms >= 0; }},
+};
+
+static void usage()
+{
+    std::fprintf(stderr, "Usage: live-whisper-ab [-c CONTROL] [FILE]\n");
+}
+
+static std::string default_log()
+{
+    if (const char* xdg = std::getenv("XDG_STATE_HOME"))
+        return std::string(xdg) + "/live-whisper/sessions.jsonl";
+    const char* home = std::getenv("HOME");
+    return std::string(home ? home : ".") + "/.local/state/live-whisper/sessions.jsonl";
+}
+
+int main(int argc, char** argv)
+{
+    std::string control = "control";
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-c" && i + 1 < argc) {
+            control = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else if (!arg.empty() && arg[0] != '-' && path.empty()) {
+            path = arg;
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (path.empty()) path = default_log();
+
+    std::ifstream in(path);
+    if (!in) {
+        std::fprintf(stderr, "live-whisper-ab: cannot read %s: %s\n", path.c_str(), std::strerror(errno));
+        return 1;
+    }
+
+    std::map<std::string, std::vector<Record>> arms;
+    std::string line;
+    size_t skipped = 0;
+    while (std::getline(in, line)) {
+        Record r;
+        if (!parse(line, &r) || r.audio_s < MIN_AUDIO_S) {
+            ++skipped;
+            continue;
+        }
+        arms[r.variant].push_back(r);
+    }
+    if (arms.empty()) {
+        std::fprintf(stderr, "live-whisper-ab: no usable sessions in %s\n", path.c_str());
+        return 1;
+    }
+    if (!arms.count(control))
+        std::fprintf(stderr, "live-whisper-ab: no sessions for %s; no differences shown\n",
+                     control.c_str());
+
+    // Control first, then the others by name
+    std::vector<std::string> order;
+    if (arms.count(control)) order.push_back(control);
+    for (const auto& [name, _] : arms)
+        if (name != control) order.push_back(name);
+
+    size_t total = 0;
+    for (const auto& [_, records] : arms) total += records.size();
+    std::printf("%zu sessions", total);
+    if (skipped) std::printf(" (%zu skipped: unparsable or under %.0fs of audio)", skipped, MIN_AUDIO_S);
+    std::printf("\n\n%-20s %-14s %5s %10s %23s %27s\n",
+                "metric", "variant", "n", "mean", "95% CI", "vs control");
+
+    for (const Metric& m : METRICS) {
+        std::map<std::string, Summary> sums;
+        for (const std::string& name : order) {
+            std::vector<double> xs;
+            for (const Record& r : arms[name]) {
+                double v;
+                if (m.value(r, &v) && std::isfinite(v)) xs.push_back(v);
+            }
+            sums[name] = summarize(xs);
+        }
+
+        bool first = true;
+        for (const std::string& name : order) {
+            const Summary& s = sums[name];
+            double h = half_width(s);
+            char ci[64] = "";
+            if (std::isfinite(h))
+                std::snprintf(ci, sizeof(ci), "[%.3g, %.3g]", s.mean - h, s.mean + h);
+
+            char diff[64] = "";
+            auto c = sums.find(control);
+            if (name != control && c != sums.end() && c->second.n > 0 && c->second.mean != 0.0) {
+                double d  = (s.mean - c->second.mean) / c->second.mean * 100.0;
+                double dh = welch_half_width(c->second, s) / std::fabs(c->second.mean) * 100.0;
+                if (std::isfinite(dh))
+                    std::snprintf(diff, sizeof(diff), "%+.1f%% [%+.1f%%, %+.1f%%]%s",
+                                  d, d - dh, d + dh, std::fabs(d) > dh ? " *" : "");
+                else
+                    std::snprintf(diff, sizeof(diff), "%+.1f%%", d);
+            }
+            std::printf("%-20s %-14s %5zu %10.3g %23s %27s\n",
+                        first ? m.name : "", name.c_str(), s.n, s.mean, ci, diff);
+            first = false;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,221 @@
+// live-whisper-stat — poll the metrics socket of a running live-whisper and
+// print one line per interval, vmstat style.
+//
+// Usage: live-whisper-stat [-j] [-s SOCKET] [INTERVAL [COUNT]]
+//
+// The first line covers the whole run so far, later lines only the last
+// interval. -j prints one raw JSON snapshot and exits.
+
+#include "metrics.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <vector>
+
+static constexpr int HEADER_EVERY = 20;
+
+struct Snapshot {
+    std::map<std::string, double>                values;
+    std::map<std::string, std::vector<uint64_t>> buckets;
+
+    double get(const std::string& key) const
+    {
+        auto it = values.find(key);
+        return it == values.end() ? 0.0 : it->second;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Socket
+// ---------------------------------------------------------------------------
+static bool query(const std::string& path, const char* format, std::string* out)
+{
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return false;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+    if (connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::fprintf(stderr, "live-whisper-stat: cannot connect to %s: %s\n",
+                     path.c_str(), std::strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    std::string req = std::string(format) + "\n";
+    if (write(fd, req.data(), req.size()) != static_cast<ssize_t>(req.size())) {
+        close(fd);
+        return false;
+    }
+
+    out->clear();
+    char buf[4096];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0)
+        out->append(buf, static_cast<size_t>(n));
+    close(fd);
+    return !out->empty();
+}
+
+static Snapshot parse(const std::string& text)
+{
+    Snapshot snap;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        const std::string suffix = ".buckets";
+        if (key.size() > suffix.size()
+            && key.compare(key.size() - suffix.size(), suffix.size(), suffix) == 0) {
+            std::vector<uint64_t>& b = snap.buckets[key.substr(0, key.size() - suffix.size())];
+            uint64_t v;
+            while (fields >> v) b.push_back(v);
+        } else {
+            double v = 0.0;
+            if (fields >> v) snap.values[key] = v;
+        }
+    }
+    return snap;
+}
+
+// ---------------------------------------------------------------------------
+// Interval statistics
+// ---------------------------------------------------------------------------
+
+// Percentile of the observations a histogram gained between two snapshots.
+static double interval_percentile(const Snapshot& prev, const Snapshot& cur,
+                                  const std::string& name, double p)
+{
+    auto it = cur.buckets.find(name);
+    if (it == cur.buckets.end()) return 0.0;
+    std::vector<uint64_t> diff = it->second;
+    auto pit = prev.buckets.find(name);
+    if (pit != prev.buckets.end())
+        for (size_t i = 0; i < diff.size() && i < pit->second.size(); ++i)
+            diff[i] -= pit->second[i];
+
+    uint64_t total = 0;
+    for (uint64_t v : diff) total += v;
+    if (total == 0) return 0.0;
+
+    uint64_t target = static_cast<uint64_t>(p / 100.0 * total + 0.5);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < diff.size(); ++i) {
+        seen += diff[i];
+        if (seen >= target && seen > 0) return metrics::bucket_upper(static_cast<int>(i));
+    }
+    return metrics::bucket_upper(metrics::HIST_BUCKETS - 1);
+}
+
+static double delta(const Snapshot& prev, const Snapshot& cur, const std::string& key)
+{
+    return cur.get(key) - prev.get(key);
+}
+
+static double ratio(double num, double den)
+{
+    return den > 0.0 ? num / den : 0.0;
+}
+
+static void print_header()
+{
+    std::printf("%s %s %s %s %s\n",
+                "---------inference-------", "------audio-------", "-----ui-----",
+                "------memory-------", "-------------cpu %-------------");
+    std::printf("%5s %6s %6s %5s %7s %10s %5s %6s %9s %9s %7s %7s %7s %7s\n",
+                "pass", "p50ms", "p99ms", "rtf", "ring%", "dropped", "fps", "p99ms",
+                "allocs/s", "rss MB", "infer", "ui", "results", "total");
+}
+
+static void print_row(const Snapshot& prev, const Snapshot& cur)
+{
+    double secs = delta(prev, cur, "mono_s");
+
+    auto cpu = [&](const char* thread) {
+        return ratio(delta(prev, cur, std::string("cpu_ms.") + thread), secs * 10.0);
+    };
+
+    std::printf("%5.0f %6.0f %6.0f %5.2f %7.2f %10.0f %5.0f %6.1f %9.0f %9.1f %7.1f %7.1f %7.1f %7.1f\n",
+                delta(prev, cur, "pass_ms.count"),
+                interval_percentile(prev, cur, "pass_ms", 50),
+                interval_percentile(prev, cur, "pass_ms", 99),
+                ratio(delta(prev, cur, "pass_rtf.sum"), delta(prev, cur, "pass_rtf.count")),
+                cur.get("ring_fill") * 100.0,
+                delta(prev, cur, "audio_dropped_frames"),
+                ratio(delta(prev, cur, "frame_ms.count"), secs),
+                interval_percentile(prev, cur, "frame_ms", 99),
+                ratio(delta(prev, cur, "allocs"), secs),
+                cur.get("rss_kb") / 1024.0,
+                cpu("inference"), cpu("ui"), cpu("results"), cpu("process"));
+    std::fflush(stdout);
+}
+
+static void usage()
+{
+    std::fprintf(stderr, "Usage: live-whisper-stat [-j] [-s SOCKET] [INTERVAL [COUNT]]\n");
+}
+
+int main(int argc, char** argv)
+{
+    std::string path = metrics::socket_path();
+    bool json = false;
+    double interval = 0.0;
+    long count = -1;
+
+    std::vector<std::string> positional;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-j" || arg == "--json") {
+            json = true;
+        } else if (arg == "-s" && i + 1 < argc) {
+            path = argv[++i];
+        } else if (arg == "-h" || arg == "--help") {
+            usage();
+            return 0;
+        } else if (!arg.empty() && arg[0] != '-') {
+            positional.push_back(arg);
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (positional.size() > 0) interval = std::atof(positional[0].c_str());
+    if (positional.size() > 1) count = std::atol(positional[1].c_str());
+
+    std::string body;
+    if (json) {
+        if (!query(path, "json", &body)) return 1;
+        std::fputs(body.c_str(), stdout);
+        return 0;
+    }
+
+    // First row: everything since the process started
+    if (!query(path, "text", &body)) return 1;
+    Snapshot cur = parse(body);
+    Snapshot prev;
+    prev.values["mono_s"] = cur.get("mono_s") - cur.get("uptime_s");
+    print_header();
+    print_row(prev, cur);
+    if (interval <= 0.0) return 0;
+
+    for (long row = 1; count < 0 || row < count; ++row) {
+        usleep(static_cast<useconds_t>(interval * 1e6));
+        prev = cur;
+        if (!query(path, "text", &body)) return 1;
+        cur = parse(body);
+        if (row % HEADER_EVERY == 0) print_header();
+        print_row(prev, cur);
+    }
+    return 0;
+}
@@ -0,0 +1,135 @@
+// Build-time generator for the signed-distance-field font atlas.
+//
+// Renders the printable Latin-1 range of a TTF as distance fields with
+// stb_truetype, shelf-packs them into a single-channel atlas and writes a
+// C++ source with the glyph table and pixels, to be #included by font.cpp.
+//
+// Usage: sdf_font_gen <font.ttf> <out.cpp>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "imstb_truetype.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static constexpr float SDF_SIZE        = 32.0f;  // pixel height the fields are generated at
+static constexpr int   SDF_PADDING     = 4;      // distance range in pixels either side of the edge
+static constexpr int   SDF_ON_EDGE     = 128;    // value on the outline (0.5 in the shader)
+static constexpr int   ATLAS_WIDTH     = 512;
+static constexpr int   FIRST_CODEPOINT = 0x20;
+static constexpr int   LAST_CODEPOINT  = 0xFF;
+
+struct Glyph {
+    int codepoint;
+    int x = 0, y = 0, w = 0, h = 0;
+    int xoff = 0, yoff = 0;
+    float advance = 0.0f;
+    unsigned char* pixels = nullptr;
+};
+
+static std::vector<unsigned char> read_file(const char* path)
+{
+    std::vector<unsigned char> data;
+    FILE* f = std::fopen(path, "rb");
+    if (!f) return data;
+    std::fseek(f, 0, SEEK_END);
+    data.resize(static_cast<size_t>(std::ftell(f)));
+    std::fseek(f, 0, SEEK_SET);
+    if (std::fread(data.data(), 1, data.size(), f) != data.size()) data.clear();
+    std::fclose(f);
+    return data;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s <font.ttf> <out.cpp>\n", argv[0]);
+        return 1;
+    }
+
+    std::vector<unsigned char> ttf = read_file(argv[1]);
+    stbtt_fontinfo info;
+    if (ttf.empty() || !stbtt_InitFont(&info, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0))) {
+        std::fprintf(stderr, "sdf_font_gen: cannot load %s\n", argv[1]);
+        return 1;
+    }
+
+    float scale = stbtt_ScaleForPixelHeight(&info, SDF_SIZE);
+    int ascent, descent, line_gap;
+    stbtt_GetFontVMetrics(&info, &ascent, &descent, &line_gap);
+
+    // Render fields
+    std::vector<Glyph> glyphs;
+    for (int cp = FIRST_CODEPOINT; cp <= LAST_CODEPOINT; ++cp) {
+        if (cp >= 0x7F && cp < 0xA0) continue;  // C1 controls
+        if (!stbtt_FindGlyphIndex(&info, cp)) continue;
+
+        Glyph g;
+        g.codepoint = cp;
+        int adv, lsb;
+        stbtt_GetCodepointHMetrics(&info, cp, &adv, &lsb);
+        g.advance = adv * scale;
+        g.pixels = stbtt_GetCodepointSDF(&info, scale, cp, SDF_PADDING, SDF_ON_EDGE,
+                                         static_cast<float>(SDF_ON_EDGE) / SDF_PADDING,
+                                         &g.w, &g.h, &g.xoff, &g.yoff);
+        if (!g.pixels) g.w = g.h = 0;
+        glyphs.push_back(g);
+    }
+
+    // Shelf-pack into a fixed-width atlas, 1px gap to avoid bleeding
+    int pen_x = 1, pen_y = 1, shelf_h = 0;
+    for (auto& g : glyphs) {
+        if (g.w == 0) continue;
+        if (pen_x + g.w + 1 > ATLAS_WIDTH) {
+            pen_x = 1;
+            pen_y += shelf_h + 1;
+            shelf_h = 0;
+        }
+        g.x = pen_x;
+        g.y = pen_y;
+        pen_x += g.w + 1;
+        if (g.h > shelf_h) shelf_h = g.h;
+    }
+    int atlas_h = pen_y + shelf_h + 1;
+
+    std::vector<unsigned char> atlas(static_cast<size_t>(ATLAS_WIDTH) * atlas_h, 0);
+    for (const auto& g : glyphs)
+        for (int row = 0; row < g.h; ++row)
+            for (int col = 0; col < g.w; ++col)
+                atlas[(g.y + row) * ATLAS_WIDTH + g.x + col] = g.pixels[row * g.w + col];
+
+    // Emit source
+    FILE* out = std::fopen(argv[2], "w");
+    if (!out) {
+        std::fprintf(stderr, "sdf_font_gen: cannot write %s\n", argv[2]);
+        return 1;
+    }
+
+    std::fprintf(out, "// Generated by sdf_font_gen from %s — do not edit.\n\n", argv[1]);
+    std::fprintf(out, "static const float sdf_font_size    = %.1ff;\n", SDF_SIZE);
+    std::fprintf(out, "static const int   sdf_font_padding = %d;\n", SDF_PADDING);
+    std::fprintf(out, "static const int   sdf_font_on_edge = %d;\n", SDF_ON_EDGE);
+    std::fprintf(out, "static const float sdf_font_ascent  = %.4ff;\n", ascent * scale);
+    std::fprintf(out, "static const float sdf_font_descent = %.4ff;\n", descent * scale);
+    std::fprintf(out, "static const int   sdf_atlas_width  = %d;\n", ATLAS_WIDTH);
+    std::fprintf(out, "static const int   sdf_atlas_height = %d;\n\n", atlas_h);
+
+    std::fprintf(out, "struct SdfGlyph { unsigned int codepoint; int x, y, w, h; float xoff, yoff, advance; };\n\n");
+    std::fprintf(out, "// Sorted by codepoint\nstatic const SdfGlyph sdf_font_glyphs[] = {\n");
+    for (const auto& g : glyphs)
+        std::fprintf(out, "    { 0x%04X, %d, %d, %d, %d, %.1ff, %.1ff, %.4ff },\n",
+                     g.codepoint, g.x, g.y, g.w, g.h,
+                     static_cast<float>(g.xoff), static_cast<float>(g.yoff), g.advance);
+    std::fprintf(out, "};\nstatic const int sdf_font_glyph_count = %zu;\n\n", glyphs.size());
+
+    std::fprintf(out, "static const unsigned char sdf_atlas_pixels[%zu] = {", atlas.size());
+    for (size_t i = 0; i < atlas.size(); ++i)
+        std::fprintf(out, "%s%u,", (i % 32 == 0) ? "\n    " : "", atlas[i]);
+    std::fprintf(out, "\n};\n");
+    std::fclose(out);
+
+    for (auto& g : glyphs)
+        stbtt_FreeSDF(g.pixels, nullptr);
+    return 0;
+}